@@ -0,0 +1,367 @@
+#pragma once
+
+// Dekodowanie rejestrów bitowych STATE1-3 (32002-32004), ALARM1-3 (32008-32010)
+// i kodu błędu 32090 (opis bitów: "Huawei SUN2000 - Statusy i Alarmy Bitowe.ini").
+// Kolejne próbki porównywane są maskami XOR: zmienione = poprzednie ^ bieżące,
+// zgłoszone = zmienione & bieżące, skasowane = zmienione & poprzednie, a bity
+// przechodzone przez __builtin_ctz - koszt zależy od liczby zmian, nie od
+// liczby bitów. Zdarzenia są trywialnie kopiowalne (bez napisów), opis bitu
+// pochodzi ze stałej tabeli dopiero przy wyświetlaniu lub zapisie.
+
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+
+#include "inverter_sample.hpp"
+#include "register_map.hpp"
+#include "text_format.hpp"
+
+// Ok - bit stanu "w normie": zgłoszenie to informacja, skasowanie to ostrzeżenie
+enum class AlarmSeverity : uint8_t { Info, Ok, Warning, Critical };
+
+inline const char* alarmSeverityName(AlarmSeverity s) {
+    switch (s) {
+        case AlarmSeverity::Critical: return "krytyczny";
+        case AlarmSeverity::Warning: return "ważny";
+        case AlarmSeverity::Ok: return "ok";
+        case AlarmSeverity::Info: break;
+    }
+    return "info";
+}
+
+struct AlarmBitDesc {
+    const char* name;  // nullptr - bit zarezerwowany
+    AlarmSeverity severity;
+};
+
+struct AlarmRegisterDesc {
+    RegId id;
+    uint16_t address;
+    const char* name;
+    AlarmBitDesc bits[16];
+};
+
+namespace alarm_detail {
+constexpr AlarmSeverity I = AlarmSeverity::Info;
+constexpr AlarmSeverity K = AlarmSeverity::Ok;
+constexpr AlarmSeverity W = AlarmSeverity::Warning;
+constexpr AlarmSeverity C = AlarmSeverity::Critical;
+constexpr AlarmBitDesc RESERVED = {nullptr, AlarmSeverity::Info};
+}  // namespace alarm_detail
+
+inline constexpr AlarmRegisterDesc ALARM_REGISTERS[] = {
+    {REG_STATE1, 32002, "STATE1", {
+        {"Standby", alarm_detail::I},
+        {"Sieć dostępna", alarm_detail::K},
+        {"Połączenie z siecią", alarm_detail::K},
+        {"Tryb wyłączenia", alarm_detail::W},
+        {"Tryb oszczędzania energii", alarm_detail::I},
+        {"Tryb eksportu energii", alarm_detail::K},
+        {"Tryb synchronizacji", alarm_detail::I},
+        {"Tryb pracy", alarm_detail::K},
+        {"Tryb debugowania", alarm_detail::W},
+        {"Tryb serwisowy", alarm_detail::W},
+        {"Tryb aktualizacji", alarm_detail::I},
+        {"Tryb testowy", alarm_detail::I},
+        {"Tryb konfiguracji", alarm_detail::I},
+        {"Tryb monitorowania", alarm_detail::I},
+        {"Tryb awaryjny", alarm_detail::C},
+        {"Tryb offline", alarm_detail::C},
+    }},
+    {REG_STATE2, 32003, "STATE2", {
+        {"MPPT1 aktywny", alarm_detail::I},
+        {"MPPT2 aktywny", alarm_detail::I},
+        {"Anti-islanding aktywne", alarm_detail::K},
+        {"PV izolacja OK", alarm_detail::K},
+        {"Wentylator aktywny", alarm_detail::I},
+        {"Temperatura OK", alarm_detail::K},
+        {"AC relay zamknięte", alarm_detail::I},
+        {"DC relay zamknięte", alarm_detail::I},
+        alarm_detail::RESERVED, alarm_detail::RESERVED, alarm_detail::RESERVED, alarm_detail::RESERVED,
+        alarm_detail::RESERVED, alarm_detail::RESERVED, alarm_detail::RESERVED, alarm_detail::RESERVED,
+    }},
+    {REG_STATE3, 32004, "STATE3", {
+        {"Komunikacja RS485 OK", alarm_detail::K},
+        {"Komunikacja Ethernet OK", alarm_detail::I},
+        {"Komunikacja WiFi OK", alarm_detail::I},
+        {"Dongle połączony", alarm_detail::I},
+        {"Licznik energii OK", alarm_detail::K},
+        {"Optymalizatory OK", alarm_detail::K},
+        {"Cloud połączone", alarm_detail::I},
+        {"NTP zsynchronizowany", alarm_detail::I},
+        alarm_detail::RESERVED, alarm_detail::RESERVED, alarm_detail::RESERVED, alarm_detail::RESERVED,
+        alarm_detail::RESERVED, alarm_detail::RESERVED, alarm_detail::RESERVED, alarm_detail::RESERVED,
+    }},
+    {REG_ALARM1, 32008, "ALARM1", {
+        {"Wysoka temperatura wewnętrzna", alarm_detail::C},
+        {"Wysoka temperatura radiatora", alarm_detail::C},
+        {"Wysoka temperatura modułu mocy", alarm_detail::C},
+        {"Błąd wentylatora", alarm_detail::C},
+        {"Błąd Phase A", alarm_detail::W},
+        {"Błąd Phase B", alarm_detail::W},
+        {"Błąd Phase C", alarm_detail::W},
+        {"Błąd SPD", alarm_detail::W},
+        {"Odwrócona polaryzacja PV1", alarm_detail::C},
+        {"Odwrócona polaryzacja PV2", alarm_detail::C},
+        {"PV1 doziemiony", alarm_detail::C},
+        {"PV2 doziemiony", alarm_detail::C},
+        {"Niska rezystancja izolacji", alarm_detail::C},
+        {"Błąd czujnika temperatury", alarm_detail::W},
+        {"Błąd komunikacji AFCI", alarm_detail::W},
+        {"Błąd AFCI", alarm_detail::C},
+    }},
+    {REG_ALARM2, 32009, "ALARM2", {
+        {"Błąd czujnika prądu AC", alarm_detail::W},
+        {"Błąd czujnika napięcia AC", alarm_detail::W},
+        {"Błąd kalibracji prądu", alarm_detail::W},
+        {"Błąd kalibracji napięcia", alarm_detail::W},
+        {"Błąd czujnika prądu PV", alarm_detail::W},
+        {"Błąd czujnika napięcia PV", alarm_detail::W},
+        {"Błąd czujnika prądu wyjścia", alarm_detail::W},
+        {"Błąd czujnika napięcia wyjścia", alarm_detail::W},
+        {"Błąd czujnika prądu sieci", alarm_detail::W},
+        {"Błąd czujnika napięcia sieci", alarm_detail::W},
+        {"Prąd upływu", alarm_detail::C},
+        {"Zabezpieczenie odwrotne", alarm_detail::W},
+        {"Zabezpieczenie impedancji", alarm_detail::W},
+        {"Zabezpieczenie napięcia", alarm_detail::C},
+        {"Zabezpieczenie częstotliwości", alarm_detail::C},
+        {"Zabezpieczenie wyspy", alarm_detail::C},
+    }},
+    {REG_ALARM3, 32010, "ALARM3", {
+        {"Błąd EEPROM", alarm_detail::C},
+        {"Błąd zegara RTC", alarm_detail::W},
+        {"Błąd kalibracji EEPROM", alarm_detail::W},
+        {"Błąd parametrów EEPROM", alarm_detail::W},
+        {"Błąd komunikacji z licznikiem", alarm_detail::W},
+        {"Błąd komunikacji z optymalizatorami", alarm_detail::W},
+        {"Błąd konfiguracji systemu", alarm_detail::W},
+        {"Błąd firmware", alarm_detail::C},
+        {"Błąd sprzętu", alarm_detail::C},
+        {"Błąd systemu kontroli", alarm_detail::C},
+        {"Błąd komunikacji RS485", alarm_detail::W},
+        {"Błąd komunikacji CAN", alarm_detail::W},
+        {"Błąd inicjalizacji", alarm_detail::C},
+        {"Błąd konfiguracji urządzenia", alarm_detail::W},
+        {"Błąd aktualizacji firmware", alarm_detail::C},
+        {"Błąd krytyczny systemu", alarm_detail::C},
+    }},
+};
+constexpr size_t ALARM_REGISTER_COUNT = sizeof(ALARM_REGISTERS) / sizeof(ALARM_REGISTERS[0]);
+constexpr uint8_t ALARM_FAULT_CODE = 0xFF;       // AlarmEvent::reg dla kodu błędu 32090
+constexpr size_t ALARM_FIRST_ALARM_REGISTER = 3;  // ALARM1 - od niego bity to alarmy, wcześniej stany
+constexpr uint8_t ALARM_ANOMALY = 0xFE;          // AlarmEvent::reg dla anomalii (bit - AnomalyKind)
+
+// Anomalie wykrywane w strumieniu próbek (anomaly_detector.hpp)
+enum class AnomalyKind : uint8_t {
+    VoltageImbalance,
+    CurrentImbalance,
+    EfficiencyDrop,
+    FrequencyExcursion,
+    ThermalDerating,
+    PowerLimit,
+};
+
+struct AnomalyDesc {
+    const char* key;    // Nazwa w JSON i etykieta Prometheusa
+    const char* name;
+    const char* unit;   // Jednostka AlarmEvent::value
+    int decimals;       // value = wartość * 10^decimals
+    AlarmSeverity severity;
+};
+
+inline constexpr AnomalyDesc ANOMALIES[] = {
+    {"voltage_imbalance", "Asymetria napięć faz", "%", 1, AlarmSeverity::Warning},
+    {"current_imbalance", "Asymetria prądów faz", "%", 1, AlarmSeverity::Warning},
+    {"efficiency_drop", "Spadek sprawności", "p.p.", 1, AlarmSeverity::Warning},
+    {"frequency_excursion", "Częstotliwość sieci poza normą", "Hz", 2, AlarmSeverity::Critical},
+    {"thermal_derating", "Ograniczenie mocy: temperatura", "°C", 1, AlarmSeverity::Warning},
+    // kW - w W wartość 16-bitowa kończyłaby się na 65 kW
+    {"power_limit", "Ograniczenie mocy: zewnętrzne", "kW", 2, AlarmSeverity::Info},
+};
+constexpr size_t ANOMALY_COUNT = sizeof(ANOMALIES) / sizeof(ANOMALIES[0]);
+
+// Kategoria kodu błędu 32090 (zakresy z dokumentacji)
+inline const char* faultCodeCategory(uint16_t code) {
+    static const char* const CATEGORIES[] = {
+        "Błędy temperatury", "Błędy napięcia", "Błędy prądu", "Błędy izolacji", "Błędy komunikacji",
+        "Błędy sprzętowe", "Błędy oprogramowania", "Błędy konfiguracji", "Błędy systemowe", "Błędy krytyczne",
+    };
+    if (code == 0) return "Brak błędów";
+    unsigned range = code >> 12;
+    if (range >= sizeof(CATEGORIES) / sizeof(CATEGORIES[0]) || (code & 0x0FFF) > 0x0999) return "Nieznany kod";
+    return CATEGORIES[range];
+}
+
+// Zgłoszenie albo skasowanie bitu (lub zmiana kodu błędu) - 16 bajtów
+struct AlarmEvent {
+    int64_t timestamp_ms = 0;
+    uint16_t value = 0;   // Wartość rejestru po zmianie (kod błędu dla ALARM_FAULT_CODE)
+    uint8_t reg = 0;      // Indeks w ALARM_REGISTERS albo ALARM_FAULT_CODE
+    uint8_t bit = 0;
+    bool raised = false;
+    AlarmSeverity severity = AlarmSeverity::Info;  // Już uwzględnia kierunek zmiany
+
+    const char* registerName() const {
+        if (reg == ALARM_ANOMALY) return "ANOMALY";
+        return reg == ALARM_FAULT_CODE ? "FAULT" : ALARM_REGISTERS[reg].name;
+    }
+
+    // Opis bitu, kategoria kodu błędu albo rodzaj anomalii
+    const char* description() const {
+        if (reg == ALARM_FAULT_CODE) return faultCodeCategory(value);
+        if (reg == ALARM_ANOMALY) return ANOMALIES[bit].name;
+        const char* name = ALARM_REGISTERS[reg].bits[bit].name;
+        return name != nullptr ? name : "Bit zarezerwowany";
+    }
+};
+
+static_assert(sizeof(AlarmEvent) == 16, "AlarmEvent powinien mieć 16 bajtów");
+
+class AlarmDecoder {
+public:
+    // Najwięcej zdarzeń z jednej próbki: wszystkie bity i kod błędu (skasowanie + zgłoszenie)
+    static constexpr size_t MAX_EVENTS = ALARM_REGISTER_COUNT * 16 + 2;
+
+private:
+    uint16_t previous[ALARM_REGISTER_COUNT] = {};
+    uint16_t previous_fault = 0;
+    bool has_previous = false;
+
+    static AlarmSeverity eventSeverity(AlarmSeverity bit_severity, bool raised) {
+        if (bit_severity == AlarmSeverity::Ok) return raised ? AlarmSeverity::Info : AlarmSeverity::Warning;
+        return raised ? bit_severity : AlarmSeverity::Info;
+    }
+
+public:
+    // Zdarzenia między poprzednią a bieżącą próbką; zwraca ich liczbę (out: MAX_EVENTS miejsc).
+    // Pierwsza próbka ustala stan odniesienia - zgłaszane są tylko aktywne alarmy i kod błędu.
+    size_t update(const InverterSample& s, AlarmEvent* out) {
+        size_t n = 0;
+        auto emit = [&](uint8_t reg, uint8_t bit, bool raised, uint16_t value, AlarmSeverity severity) {
+            AlarmEvent& e = out[n++];
+            e.timestamp_ms = s.timestamp_ms;
+            e.reg = reg;
+            e.bit = bit;
+            e.raised = raised;
+            e.value = value;
+            e.severity = severity;
+        };
+        for (size_t r = 0; r < ALARM_REGISTER_COUNT; r++) {
+            const AlarmRegisterDesc& desc = ALARM_REGISTERS[r];
+            if (!s.regs.has(desc.id)) continue;  // Rejestr nieodczytany - bez zmiany stanu
+            uint16_t current = uint16_t(s.regs.raw[desc.id]);
+            uint16_t before = has_previous ? previous[r] : r >= ALARM_FIRST_ALARM_REGISTER ? 0 : current;
+            uint16_t changed = before ^ current;
+            previous[r] = current;
+            while (changed != 0) {
+                int bit = __builtin_ctz(changed);
+                changed &= uint16_t(changed - 1);
+                bool raised = (current >> bit) & 1;
+                emit(uint8_t(r), uint8_t(bit), raised, current, eventSeverity(desc.bits[bit].severity, raised));
+            }
+        }
+        if (s.regs.has(REG_FAULT_CODE)) {
+            uint16_t fault = uint16_t(s.regs.raw[REG_FAULT_CODE]);
+            uint16_t before = has_previous ? previous_fault : 0;
+            if (fault != before) {
+                if (before != 0) emit(ALARM_FAULT_CODE, 0, false, before, AlarmSeverity::Info);
+                if (fault != 0) emit(ALARM_FAULT_CODE, 0, true, fault, AlarmSeverity::Critical);
+            }
+            previous_fault = fault;
+        }
+        has_previous = true;
+        return n;
+    }
+
+    // Stan z ostatniej próbki. Nieudane odczyty go nie zmieniają, więc alarm
+    // skasowany w czasie przerwy w łączności zostaje zgłoszony po powrocie.
+    bool hasPrevious() const { return has_previous; }
+    uint16_t activeBits(size_t reg) const { return previous[reg]; }
+    uint16_t faultCode() const { return previous_fault; }
+};
+
+// Ograniczony dziennik zdarzeń: pierścień o stałej pojemności, najstarsze nadpisywane
+template <size_t CAPACITY>
+class AlarmEventLog {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Pojemność musi być potęgą dwójki");
+
+private:
+    AlarmEvent events[CAPACITY];
+    uint64_t total = 0;  // Wszystkie dodane (także nadpisane) - służy też jako wersja
+
+public:
+    void push(const AlarmEvent& e) { events[total++ & (CAPACITY - 1)] = e; }
+
+    size_t size() const { return total < CAPACITY ? size_t(total) : CAPACITY; }
+    uint64_t totalCount() const { return total; }
+    // i = 0 to najnowsze zdarzenie
+    const AlarmEvent& recent(size_t i) const { return events[(total - 1 - i) & (CAPACITY - 1)]; }
+};
+
+// Dopisywanie zdarzeń do pliku tekstowego - jedna krótka linia na zdarzenie:
+// "<czas ms>\t<urządzenie>\t+|-\t<rejestr>.<bit>\t<waga>\t<opis>"
+// (anomalie: "ANOMALY.<klucz>" i wartość z jednostką w opisie)
+// Wszystkie linie jednej próbki idą jednym write() na deskryptorze O_APPEND,
+// więc wątki odczytu różnych urządzeń mogą pisać do tego samego pliku.
+class AlarmEventFile {
+private:
+    int fd = -1;
+    std::string error;
+
+public:
+    AlarmEventFile() = default;
+    AlarmEventFile(const AlarmEventFile&) = delete;
+    AlarmEventFile& operator=(const AlarmEventFile&) = delete;
+    ~AlarmEventFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            error = "Nie można otworzyć " + path + ": " + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+    const std::string& lastError() const { return error; }
+
+    // Wołane z wątków odczytu - bufor linii lokalny, błąd zostaje w errno
+    bool append(const char* device, const AlarmEvent* events, size_t count) const {
+        if (fd < 0 || count == 0) return true;
+        std::string line_buffer;
+        line_buffer.reserve(count * 96);
+        for (size_t i = 0; i < count; i++) {
+            const AlarmEvent& e = events[i];
+            if (e.reg == ALARM_ANOMALY) {
+                const AnomalyDesc& a = ANOMALIES[e.bit];
+                appendFormat(line_buffer, "%lld\t%s\t%c\tANOMALY.%s\t%s\t%s (%.*f %s)\n",
+                             (long long)e.timestamp_ms, device, e.raised ? '+' : '-', a.key,
+                             alarmSeverityName(e.severity), a.name, a.decimals,
+                             e.value / std::pow(10.0, a.decimals), a.unit);
+            } else if (e.reg == ALARM_FAULT_CODE) {
+                appendFormat(line_buffer, "%lld\t%s\t%c\tFAULT.%u\t%s\t%s\n", (long long)e.timestamp_ms,
+                             device, e.raised ? '+' : '-', unsigned(e.value), alarmSeverityName(e.severity),
+                             e.description());
+            } else {
+                appendFormat(line_buffer, "%lld\t%s\t%c\t%s.%u\t%s\t%s\n", (long long)e.timestamp_ms,
+                             device, e.raised ? '+' : '-', e.registerName(), unsigned(e.bit),
+                             alarmSeverityName(e.severity), e.description());
+            }
+        }
+        return ::write(fd, line_buffer.data(), line_buffer.size()) == ssize_t(line_buffer.size());
+    }
+};
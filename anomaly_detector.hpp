@@ -0,0 +1,197 @@
+#pragma once
+
+// Analiza strumienia próbek: asymetria napięć i prądów faz, spadek sprawności
+// względem mocy wejściowej, częstotliwość sieci i ograniczenie mocy (stan
+// 0x0201). Statystyki są wykładnicze (EWMA średniej i wariancji), więc pamięć
+// jest stała - kilkaset bajtów na urządzenie - a próbka kosztuje kilkadziesiąt
+// operacji zmiennoprzecinkowych. Wykryte stany to flagi AnomalyState (panel,
+// HTTP) oraz zdarzenia AlarmEvent (reg = ALARM_ANOMALY) w tym samym dzienniku
+// co alarmy z rejestrów bitowych. Progi mają histerezę, żeby stan na granicy
+// nie generował serii zdarzeń.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "alarm_decoder.hpp"
+#include "inverter_sample.hpp"
+#include "register_map.hpp"
+
+// Średnia i wariancja wykładnicza - statystyka krocząca bez bufora próbek.
+// Na początku (count < 1/alpha) zwykła średnia, żeby szybciej się ustaliła.
+struct Ewma {
+    double mean = 0.0;
+    double var = 0.0;
+    uint32_t count = 0;
+
+    void add(double x, double alpha) {
+        count++;
+        double a = std::max(alpha, 1.0 / count);
+        double d = x - mean;
+        mean += a * d;
+        var = (1.0 - a) * (var + a * d * d);
+    }
+
+    double stddev() const { return std::sqrt(var); }
+    void reset() { *this = Ewma(); }
+};
+
+// Bieżące wyniki analizy (trywialnie kopiowalne - część DeviceSnapshot)
+struct AnomalyState {
+    uint8_t active = 0;                  // Maska bitów AnomalyKind
+    float voltage_imbalance_pct = 0.0f;  // Wygładzona asymetria (maks. odchyłka od średniej)
+    float current_imbalance_pct = 0.0f;
+    float efficiency_pct = 0.0f;           // Wygładzona sprawność
+    float efficiency_expected_pct = 0.0f;  // Odniesienie dla bieżącej mocy wejściowej (0 - jeszcze brak)
+    float frequency_deviation_hz = 0.0f;   // Od częstotliwości nominalnej (50 / 60 Hz)
+
+    bool has(AnomalyKind kind) const { return (active >> unsigned(kind)) & 1; }
+};
+
+class AnomalyDetector {
+public:
+    static constexpr size_t MAX_EVENTS = ANOMALY_COUNT;
+
+    static constexpr double SMOOTHING_ALPHA = 0.3;           // Wygładzanie bieżących wartości
+    static constexpr double VOLTAGE_IMBALANCE_ON_PCT = 2.0;  // EN 50160: asymetria do 2%
+    static constexpr double VOLTAGE_IMBALANCE_OFF_PCT = 1.5;
+    static constexpr double CURRENT_IMBALANCE_ON_PCT = 10.0;
+    static constexpr double CURRENT_IMBALANCE_OFF_PCT = 7.0;
+    static constexpr double MIN_PHASE_CURRENT_A = 1.0;        // Poniżej asymetria prądów to szum
+    static constexpr int EFFICIENCY_BINS = 10;                // Przedziały mocy wejściowej (część nominalnej)
+    static constexpr double BASELINE_ALPHA = 0.02;            // Odniesienie sprawności uczy się powoli
+    static constexpr uint32_t MIN_BASELINE_SAMPLES = 30;
+    static constexpr double EFFICIENCY_DROP_MIN_PP = 1.5;     // Minimalny spadek (punkty procentowe)
+    static constexpr double EFFICIENCY_DROP_SIGMAS = 3.0;
+    static constexpr double MIN_INPUT_FRACTION = 0.05;        // Przy małej mocy sprawność jest niestabilna
+    static constexpr double FALLBACK_RATED_POWER_W = 10000.0; // Gdy identyfikacja nie podaje mocy nominalnej
+    static constexpr double FREQUENCY_ON_HZ = 0.5;            // EN 50160: 50 Hz +/- 1%
+    static constexpr double FREQUENCY_OFF_HZ = 0.4;
+    static constexpr double THERMAL_DERATING_C = 55.0;        // 0x0201 przy tej temperaturze - przyczyna termiczna
+    static constexpr int DERATING_MIN_SAMPLES = 2;            // Ograniczenie trwające co najmniej tyle próbek
+
+private:
+    AnomalyState state;
+    Ewma voltage_imbalance, current_imbalance, efficiency;
+    Ewma efficiency_baseline[EFFICIENCY_BINS];
+    int derating_samples = 0;
+
+    static double imbalancePct(double a, double b, double c) {
+        double avg = (a + b + c) / 3.0;
+        if (avg <= 0.0) return 0.0;
+        double dev = std::max({std::fabs(a - avg), std::fabs(b - avg), std::fabs(c - avg)});
+        return dev / avg * 100.0;
+    }
+
+    static uint16_t eventValue(AnomalyKind kind, double value) {
+        double scaled = std::round(std::fabs(value) * std::pow(10.0, ANOMALIES[size_t(kind)].decimals));
+        return uint16_t(std::min(scaled, 65535.0));
+    }
+
+    // Ustawia flagę z histerezą; zmiana trafia do out
+    void set(AnomalyKind kind, bool on, bool off, double value, int64_t timestamp_ms, AlarmEvent* out,
+             size_t& n) {
+        uint8_t bit = uint8_t(1u << unsigned(kind));
+        bool active = state.active & bit;
+        if (active ? !off : !on) return;
+        state.active ^= bit;
+        AlarmEvent& e = out[n++];
+        e.timestamp_ms = timestamp_ms;
+        e.reg = ALARM_ANOMALY;
+        e.bit = uint8_t(kind);
+        e.raised = !active;
+        e.value = eventValue(kind, value);
+        e.severity = e.raised ? ANOMALIES[size_t(kind)].severity : AlarmSeverity::Info;
+    }
+
+public:
+    // Analiza udanej próbki; zwraca liczbę zmian flag (out: MAX_EVENTS miejsc)
+    size_t update(const InverterSample& s, AlarmEvent* out) {
+        size_t n = 0;
+        const RegisterValues& r = s.regs;
+        if (!r.has(REG_DEVICE_STATE)) return 0;  // Bez stanu pracy nie ma kontekstu
+        uint16_t device_state = s.state();
+        bool on_grid = device_state == 0x0200 || device_state == 0x0201;
+        if (!on_grid) {
+            // Poza pracą w sieci (noc, błąd) - flagi kasowane, wygładzanie od nowa
+            for (size_t k = 0; k < ANOMALY_COUNT; k++) set(AnomalyKind(k), false, true, 0.0, s.timestamp_ms, out, n);
+            voltage_imbalance.reset();
+            current_imbalance.reset();
+            efficiency.reset();
+            derating_samples = 0;
+            state.voltage_imbalance_pct = state.current_imbalance_pct = 0.0f;
+            state.efficiency_pct = state.efficiency_expected_pct = state.frequency_deviation_hz = 0.0f;
+            return n;
+        }
+
+        // Asymetria faz (tylko falowniki trójfazowe)
+        if (s.device->phases() == 3 && r.has(REG_PHASE_A_VOLTAGE) && r.has(REG_PHASE_A_CURRENT)) {
+            voltage_imbalance.add(imbalancePct(r.get<REG_PHASE_A_VOLTAGE>(), r.get<REG_PHASE_B_VOLTAGE>(),
+                                               r.get<REG_PHASE_C_VOLTAGE>()), SMOOTHING_ALPHA);
+            double v = voltage_imbalance.mean;
+            set(AnomalyKind::VoltageImbalance, v > VOLTAGE_IMBALANCE_ON_PCT, v < VOLTAGE_IMBALANCE_OFF_PCT, v,
+                s.timestamp_ms, out, n);
+            state.voltage_imbalance_pct = float(v);
+
+            double ia = r.get<REG_PHASE_A_CURRENT>(), ib = r.get<REG_PHASE_B_CURRENT>();
+            double ic = r.get<REG_PHASE_C_CURRENT>();
+            if ((ia + ib + ic) / 3.0 >= MIN_PHASE_CURRENT_A) {
+                current_imbalance.add(imbalancePct(ia, ib, ic), SMOOTHING_ALPHA);
+                double c = current_imbalance.mean;
+                set(AnomalyKind::CurrentImbalance, c > CURRENT_IMBALANCE_ON_PCT, c < CURRENT_IMBALANCE_OFF_PCT, c,
+                    s.timestamp_ms, out, n);
+                state.current_imbalance_pct = float(c);
+            }
+        }
+
+        // Sprawność względem odniesienia dla tej samej mocy wejściowej - przy małej
+        // mocy sprawność jest naturalnie niższa, więc jeden próg nie wystarcza
+        double input_w = r.get<REG_INPUT_POWER>();
+        double rated_w = s.device->rated_power_w > 0 ? s.device->rated_power_w : FALLBACK_RATED_POWER_W;
+        double fraction = input_w / rated_w;
+        if (r.has(REG_EFFICIENCY) && fraction >= MIN_INPUT_FRACTION) {
+            efficiency.add(r.get<REG_EFFICIENCY>(), SMOOTHING_ALPHA);
+            Ewma& baseline = efficiency_baseline[std::min(int(fraction * EFFICIENCY_BINS), EFFICIENCY_BINS - 1)];
+            double deficit = 0.0;
+            double threshold = EFFICIENCY_DROP_MIN_PP;
+            if (baseline.count >= MIN_BASELINE_SAMPLES) {
+                deficit = baseline.mean - efficiency.mean;
+                threshold = std::max(EFFICIENCY_DROP_MIN_PP, EFFICIENCY_DROP_SIGMAS * baseline.stddev());
+                state.efficiency_expected_pct = float(baseline.mean);
+            } else {
+                state.efficiency_expected_pct = 0.0f;
+            }
+            bool dropped = deficit > threshold;
+            set(AnomalyKind::EfficiencyDrop, dropped, deficit < threshold * 0.5, deficit, s.timestamp_ms, out, n);
+            // Spadek nie wchodzi do odniesienia - inaczej po czasie stałby się normą
+            if (!state.has(AnomalyKind::EfficiencyDrop)) baseline.add(r.get<REG_EFFICIENCY>(), BASELINE_ALPHA);
+            state.efficiency_pct = float(efficiency.mean);
+        }
+
+        // Częstotliwość: ważne 0 to odczyt spoza okna 45-65 Hz (wyzerowany w
+        // finishInverterSample), inaczej odchyłka od nominalnej. Brak odczytu (bez
+        // licznika energii 32085 bywa 0, a rejestr zapasowy niedostępny) - pole nieważne, bez oceny
+        if (r.has(REG_GRID_FREQUENCY)) {
+            double f = r.get<REG_GRID_FREQUENCY>();
+            double deviation = f == 0.0 ? 0.0 : f - (f < 55.0 ? 50.0 : 60.0);
+            bool out_of_window = f == 0.0;
+            double abs_dev = std::fabs(deviation);
+            set(AnomalyKind::FrequencyExcursion, out_of_window || abs_dev > FREQUENCY_ON_HZ,
+                !out_of_window && abs_dev < FREQUENCY_OFF_HZ, out_of_window ? 0.0 : f, s.timestamp_ms, out, n);
+            state.frequency_deviation_hz = float(deviation);
+        }
+
+        // Ograniczenie mocy (0x0201): termiczne przy wysokiej temperaturze, inaczej zewnętrzne
+        derating_samples = device_state == 0x0201 ? derating_samples + 1 : 0;
+        bool derating = derating_samples >= DERATING_MIN_SAMPLES;
+        double temperature = r.get<REG_INTERNAL_TEMPERATURE>();
+        bool thermal = temperature >= THERMAL_DERATING_C;
+        set(AnomalyKind::ThermalDerating, derating && thermal, !derating, temperature, s.timestamp_ms, out, n);
+        set(AnomalyKind::PowerLimit, derating && !thermal && !state.has(AnomalyKind::ThermalDerating), !derating,
+            r.get<REG_ACTIVE_POWER>() / 1000.0, s.timestamp_ms, out, n);
+        return n;
+    }
+
+    const AnomalyState& current() const { return state; }
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+// Identyfikacja urządzenia (rejestry 30000-30074): model, numer seryjny,
+// firmware i parametry nominalne. Odczytywana raz po połączeniu i zamieniana
+// na niezmienny, internowany opis - próbki przechowują tylko wskaźnik.
+// Ten sam opis ma zawsze ten sam adres, więc porównanie identyfikacji dwóch
+// próbek to porównanie wskaźników. Opisy nie są zwalniane (jest ich tyle,
+// ile różnych urządzeń), a wskaźnik można bez obaw kopiować między wątkami.
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+
+#include "register_map.hpp"
+
+// Rozmiar bufora na tekst rejestru (dwa znaki na słowo + zero)
+constexpr size_t registerTextSize(RegId id) { return size_t(REGISTER_MAP[id].words) * 2 + 1; }
+
+struct DeviceDescriptor {
+    char model[registerTextSize(REG_MODEL)] = "N/A";
+    char sn[registerTextSize(REG_SN)] = "N/A";
+    char firmware_version[registerTextSize(REG_FIRMWARE)] = "N/A";
+    char production_date[registerTextSize(REG_PRODUCTION_DATE)] = "";
+    uint16_t device_type = 0;
+    uint16_t rated_power_w = 0;   // 0 - nieznana
+    uint16_t max_power_w = 0;
+    uint16_t phase_count = 0;     // 0 - nieznana
+    uint16_t pv_string_count = 0;
+
+    bool known() const { return rated_power_w != 0 || strcmp(sn, "N/A") != 0; }
+    // Liczba faz do wyświetlenia (domyślnie trzy, jak dotychczas)
+    int phases() const { return phase_count == 1 ? 1 : 3; }
+
+    bool operator==(const DeviceDescriptor& o) const {
+        return strcmp(model, o.model) == 0 && strcmp(sn, o.sn) == 0 &&
+               strcmp(firmware_version, o.firmware_version) == 0 &&
+               strcmp(production_date, o.production_date) == 0 && device_type == o.device_type &&
+               rated_power_w == o.rated_power_w && max_power_w == o.max_power_w &&
+               phase_count == o.phase_count && pv_string_count == o.pv_string_count;
+    }
+};
+
+// Opis przed pierwszym odczytem identyfikacji
+inline const DeviceDescriptor UNKNOWN_DEVICE{};
+
+// Zbiór internowanych opisów (wspólny dla wszystkich połączeń)
+class DescriptorRegistry {
+public:
+    // Zabezpieczenie przed urządzeniem zwracającym za każdym razem inne dane
+    static constexpr size_t MAX_DESCRIPTORS = 1024;
+
+private:
+    std::mutex mutex;
+    std::deque<DeviceDescriptor> descriptors;  // deque - adresy elementów są stałe
+
+public:
+    static DescriptorRegistry& instance() {
+        static DescriptorRegistry registry;
+        return registry;
+    }
+
+    // Wskaźnik do niezmiennej kopii opisu (istniejącej, jeśli taka już jest)
+    const DeviceDescriptor* intern(const DeviceDescriptor& d) {
+        if (d == UNKNOWN_DEVICE) return &UNKNOWN_DEVICE;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& existing : descriptors) {
+            if (existing == d) return &existing;
+        }
+        if (descriptors.size() >= MAX_DESCRIPTORS) return &UNKNOWN_DEVICE;
+        descriptors.push_back(d);
+        return &descriptors.back();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return descriptors.size();
+    }
+};
+
+// Opis z odczytanych wartości identyfikacji (pola tekstowe dekoduje wywołujący)
+inline void fillDescriptorValues(DeviceDescriptor& d, const RegisterValues& values) {
+    d.device_type = uint16_t(values.raw[REG_DEVICE_TYPE]);
+    d.rated_power_w = uint16_t(values.raw[REG_RATED_POWER]);
+    d.max_power_w = uint16_t(values.raw[REG_MAX_POWER]);
+    d.phase_count = uint16_t(values.raw[REG_PHASE_COUNT]);
+    d.pv_string_count = uint16_t(values.raw[REG_PV_STRING_COUNT]);
+}
+
+// Opis z bloku identyfikacji planu (tekst ASCII, dwa znaki na rejestr);
+// nullptr, gdy blok nie został odczytany
+inline const DeviceDescriptor* decodeDescriptor(const RegisterPlan& plan, const RegisterDecoder& decoder,
+                                                const RegisterValues& values) {
+    DeviceDescriptor d;
+    if (decoder.decodeText(plan, REG_MODEL, d.model, sizeof(d.model)) == 0) return nullptr;
+    decoder.decodeText(plan, REG_SN, d.sn, sizeof(d.sn));
+    decoder.decodeText(plan, REG_FIRMWARE, d.firmware_version, sizeof(d.firmware_version));
+    decoder.decodeText(plan, REG_PRODUCTION_DATE, d.production_date, sizeof(d.production_date));
+    fillDescriptorValues(d, values);
+    return DescriptorRegistry::instance().intern(d);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// Dane urządzenia publikowane przez wątek odczytu dla czytelników
+// (interfejs, serwer HTTP). Wszystko trywialnie kopiowalne i bez blokad.
+
+#include "alarm_decoder.hpp"
+#include "anomaly_detector.hpp"
+#include "energy_accounting.hpp"
+#include "inverter_sample.hpp"
+#include "json_publisher.hpp"
+#include "snapshot.hpp"
+#include "string_monitor.hpp"
+
+// Ostatni stan urządzenia publikowany przez wątek odczytu (trywialnie kopiowalny)
+struct DeviceSnapshot {
+    InverterSample sample;
+    PublisherStats publish_stats;
+    EnergyLedger energy;
+    AnomalyState anomalies;
+    char last_error[160] = "";
+};
+
+// Punkt mocy dla agregatów wykresu
+struct PowerPoint {
+    int64_t timestamp_ms;
+    double power_w;
+};
+
+// Wymiana danych z wątkiem odczytu - bez blokad w obie strony
+struct DeviceFeed {
+    SeqlockSnapshot<DeviceSnapshot> latest;
+    SpscRing<PowerPoint> power;         // Każda próbka mocy; agregaty prowadzi wątek UI
+    SpscRing<StringPoint> strings;      // Pomiary stringów PV; historię prowadzi wątek UI
+    SpscRing<AlarmEvent> events{128};   // Zmiany stanów i alarmów; dziennik prowadzi wątek UI
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+// Bieżące rozliczanie produkcji energii (zamiast ponownego czytania plików JSON).
+// Energia między kolejnymi próbkami to całka mocy czynnej (metoda trapezów),
+// przypisywana do kubełków godzinowych, dobowych i miesięcznych (czas lokalny).
+// Kubełki to pierścienie o stałym rozmiarze - pamięć nie rośnie z czasem pracy,
+// a nowa próbka kosztuje O(1) (czas lokalny liczony tylko na granicy okresu).
+//
+// Liczniki urządzenia są punktem odniesienia (rozdzielczość 10 Wh):
+//  - 32106 (całkowity) - przyrost liczony modulo 2^32 (przepełnienie licznika),
+//  - 32114/32116/32118 (dzienny, miesięczny, roczny) - spadek wartości po
+//    przejściu granicy okresu to zerowanie o północy, a nie zakłócenie.
+// Rozbieżność całki i licznika większa niż rozdzielczość licznika trafia do
+// kubełków jako korekta. Przerwa w odczytach (np. ponowne łączenie) nie jest
+// całkowana - energię z przerwy uzupełnia korekta rozłożona na czas przerwy.
+// Skok licznika niemożliwy przy mocy maksymalnej urządzenia to zakłócenie:
+// wartość jest tylko nowym punktem odniesienia, a rozliczenie przejmuje wtedy
+// licznik dzienny. Pierwszy odczyt liczników wyrównuje bieżącą dobę i miesiąc
+// do liczników urządzenia (energia sprzed uruchomienia programu).
+//
+// EnergyAccountant używany tylko przez wątek odczytu urządzenia; EnergyLedger
+// jest trywialnie kopiowalny i publikowany razem z próbką.
+
+#include <algorithm>
+#include <cstdint>
+#include <ctime>
+#include <type_traits>
+
+#include "inverter_sample.hpp"
+#include "register_map.hpp"
+
+enum class EnergyPeriod : uint8_t { Hour, Day, Month };
+
+// Najkrótszy możliwy okres (zmiana czasu, luty) - ograniczenie pętli po przerwie
+constexpr int64_t energyPeriodMinMs(EnergyPeriod period) {
+    return period == EnergyPeriod::Hour ? 3600LL * 1000 :
+           period == EnergyPeriod::Day ? 23 * 3600LL * 1000 : 28 * 24 * 3600LL * 1000;
+}
+
+// Granice okresu (czas lokalny) zawierającego chwilę ts_ms: [start_ms, end_ms)
+inline void energyPeriodBounds(int64_t ts_ms, EnergyPeriod period, int64_t& start_ms, int64_t& end_ms) {
+    time_t t = time_t(ts_ms / 1000);
+    struct tm lt;
+    localtime_r(&t, &lt);
+    lt.tm_sec = 0;
+    lt.tm_min = 0;
+    if (period == EnergyPeriod::Hour) {
+        start_ms = int64_t(mktime(&lt)) * 1000;
+        end_ms = start_ms + 3600LL * 1000;
+        return;
+    }
+    lt.tm_hour = 0;
+    if (period == EnergyPeriod::Month) lt.tm_mday = 1;
+    lt.tm_isdst = -1;
+    struct tm next = lt;
+    if (period == EnergyPeriod::Day) next.tm_mday++;
+    else next.tm_mon++;
+    start_ms = int64_t(mktime(&lt)) * 1000;
+    end_ms = int64_t(mktime(&next)) * 1000;
+    if (end_ms <= ts_ms) end_ms = ts_ms + 1;  // Zabezpieczenie przed nietypową strefą czasową
+}
+
+struct EnergyBucket {
+    int64_t start_ms = 0;
+    int64_t end_ms = 0;
+    double integrated_wh = 0.0;   // Całka mocy czynnej
+    double corrected_wh = 0.0;    // Korekty z liczników (przerwy, dryf, stan przed uruchomieniem)
+
+    double energyWh() const { return integrated_wh + corrected_wh; }
+    bool contains(int64_t ts_ms) const { return ts_ms >= start_ms && ts_ms < end_ms; }
+};
+
+// Ostatnie N okresów; kubełki tworzone dopiero, gdy przypada na nie energia
+template <EnergyPeriod P, size_t N>
+class EnergyBucketRing {
+private:
+    EnergyBucket buckets[N];
+    uint32_t head = 0;    // Indeks najnowszego kubełka
+    uint32_t filled = 0;
+
+public:
+    static constexpr EnergyPeriod PERIOD = P;
+    static constexpr size_t CAPACITY = N;
+
+    size_t size() const { return filled; }
+    // i-ty kubełek od najnowszego
+    const EnergyBucket& recent(size_t i) const { return buckets[(head + N - i) % N]; }
+
+    const EnergyBucket* find(int64_t ts_ms) const {
+        for (size_t i = 0; i < filled; i++) {
+            if (recent(i).contains(ts_ms)) return &recent(i);
+        }
+        return nullptr;
+    }
+
+    // Energia okresu zawierającego chwilę ts_ms [Wh]
+    double energyAt(int64_t ts_ms) const {
+        const EnergyBucket* b = find(ts_ms);
+        return b != nullptr ? b->energyWh() : 0.0;
+    }
+
+    // Kubełek okresu zawierającego ts_ms; nowszy okres - nowy kubełek,
+    // starszy niż zawartość pierścienia - nullptr
+    EnergyBucket* at(int64_t ts_ms) {
+        if (filled > 0) {
+            EnergyBucket& current = buckets[head];
+            if (current.contains(ts_ms)) return &current;
+            if (ts_ms < current.start_ms) {
+                for (size_t i = 1; i < filled; i++) {
+                    EnergyBucket& b = buckets[(head + N - i) % N];
+                    if (b.contains(ts_ms)) return &b;
+                }
+                return nullptr;
+            }
+            head = (head + 1) % N;
+        }
+        filled = std::min<uint32_t>(filled + 1, N);
+        EnergyBucket& b = buckets[head];
+        b = EnergyBucket{};
+        energyPeriodBounds(ts_ms, P, b.start_ms, b.end_ms);
+        return &b;
+    }
+
+    // Energia z przedziału [t0, t1) rozłożona proporcjonalnie do czasu (t1 <= t0 - w chwili t1)
+    void add(int64_t t0, int64_t t1, double wh, bool correction) {
+        if (t1 <= t0) {
+            if (EnergyBucket* b = at(t1)) (correction ? b->corrected_wh : b->integrated_wh) += wh;
+            return;
+        }
+        double per_ms = wh / double(t1 - t0);
+        // Część dłuższej przerwy starsza niż pierścień i tak nie miałaby kubełka
+        int64_t t = std::max(t0, t1 - int64_t(N) * energyPeriodMinMs(P));
+        while (t < t1) {
+            int64_t start, end;
+            EnergyBucket* b = at(t);
+            if (b != nullptr) end = b->end_ms;
+            else energyPeriodBounds(t, P, start, end);
+            end = std::min(end, t1);
+            if (b != nullptr) (correction ? b->corrected_wh : b->integrated_wh) += per_ms * double(end - t);
+            t = end;
+        }
+    }
+};
+
+// Wynik rozliczenia jednego urządzenia (trywialnie kopiowalny)
+struct EnergyLedger {
+    EnergyBucketRing<EnergyPeriod::Hour, 48> hours;
+    EnergyBucketRing<EnergyPeriod::Day, 31> days;
+    EnergyBucketRing<EnergyPeriod::Month, 12> months;
+    double integrated_wh = 0.0;    // Całka mocy od uruchomienia
+    double corrections_wh = 0.0;   // Suma korekt z liczników od uruchomienia
+    double residual_wh = 0.0;      // Licznik minus przypisana energia (w granicach rozdzielczości)
+    uint32_t gaps = 0;             // Przerwy w odczytach bez całkowania
+    uint32_t glitches = 0;         // Odrzucone skoki liczników
+    uint32_t counter_resets = 0;   // Zerowania liczników okresowych (północ, nowy miesiąc/rok)
+    int64_t updated_ms = 0;        // Czas ostatniej rozliczonej próbki
+};
+
+static_assert(std::is_trivially_copyable<EnergyLedger>::value, "EnergyLedger musi być trywialnie kopiowalny");
+
+class EnergyAccountant {
+public:
+    static constexpr int64_t MAX_INTEGRATION_GAP_MS = 15 * 60 * 1000;  // Dłuższa przerwa - tylko z licznika
+    static constexpr double COUNTER_STEP_WH = 10.0;                    // Rozdzielczość liczników (0.01 kWh)
+    static constexpr double COUNTER_MARGIN = 1.25;                     // Zapas ponad moc maksymalną
+    static constexpr double FALLBACK_MAX_POWER_W = 250000.0;           // Bez identyfikacji urządzenia
+    static constexpr int64_t RESET_TOLERANCE_MS = 5 * 60 * 1000;       // Zegar falownika a zegar lokalny
+
+private:
+    enum class CounterStep : uint8_t { None, First, Advanced, Glitch };
+
+    struct CounterTrack {
+        RegId id;
+        bool periodic;          // Zerowany na początku okresu
+        EnergyPeriod reset_period;
+        bool have = false;
+        uint32_t raw = 0;
+        int64_t ts_ms = 0;      // Czas ostatniej zmiany wartości
+    };
+
+    enum { COUNTER_TOTAL, COUNTER_DAILY, COUNTER_MONTHLY, COUNTER_YEARLY, COUNTER_COUNT };
+
+    CounterTrack counters[COUNTER_COUNT] = {
+        {REG_TOTAL_ENERGY, false, EnergyPeriod::Day},
+        {REG_DAILY_ENERGY, true, EnergyPeriod::Day},
+        {REG_MONTHLY_ENERGY, true, EnergyPeriod::Month},
+        {REG_YEARLY_ENERGY, true, EnergyPeriod::Month},  // Nowy rok to także nowy miesiąc
+    };
+    EnergyLedger book;
+    bool have_power = false;
+    int64_t last_ts = 0;
+    double last_power_w = 0.0;
+    double pending_wh = 0.0;  // Całka od ostatniej zmiany licznika odniesienia
+
+    static double counterWh(RegId id, uint32_t raw) { return regScaled(id, raw) * 1000.0; }
+
+    void attribute(int64_t t0, int64_t t1, double wh, bool correction) {
+        book.hours.add(t0, t1, wh, correction);
+        book.days.add(t0, t1, wh, correction);
+        book.months.add(t0, t1, wh, correction);
+    }
+
+    // Przyrost licznika od ostatniej zmiany [Wh]
+    CounterStep step(CounterTrack& c, const InverterSample& s, double max_power_w, double& delta_wh) {
+        if (!s.regs.has(c.id)) return CounterStep::None;
+        uint32_t raw = s.regs.raw[c.id];
+        if (!c.have) {
+            c.have = true;
+            c.raw = raw;
+            c.ts_ms = s.timestamp_ms;
+            return CounterStep::First;
+        }
+        if (raw == c.raw) return CounterStep::None;
+
+        bool reset = false;
+        uint32_t diff = raw - c.raw;  // Modulo 2^32 - przepełnienie licznika całkowitego
+        if (c.periodic && raw < c.raw) {
+            int64_t start, end;
+            energyPeriodBounds(c.ts_ms, c.reset_period, start, end);
+            reset = s.timestamp_ms + RESET_TOLERANCE_MS >= end;
+            diff = reset ? raw : UINT32_MAX;  // Spadek w trakcie okresu - zakłócenie
+        }
+        double hours = double(std::max<int64_t>(s.timestamp_ms - c.ts_ms, 0)) / 3600000.0;
+        double limit = max_power_w * hours * COUNTER_MARGIN + 2 * COUNTER_STEP_WH;
+        delta_wh = counterWh(c.id, diff);
+        c.raw = raw;
+        c.ts_ms = s.timestamp_ms;
+        if (delta_wh > limit) return CounterStep::Glitch;
+        if (reset) book.counter_resets++;
+        return CounterStep::Advanced;
+    }
+
+    // Pierwszy odczyt licznika okresowego - energia okresu sprzed uruchomienia
+    template <typename Ring>
+    static void align(Ring& ring, int64_t ts_ms, double counter_wh) {
+        EnergyBucket* b = ring.at(ts_ms);
+        if (b != nullptr && counter_wh > b->energyWh()) b->corrected_wh += counter_wh - b->energyWh();
+    }
+
+public:
+    // Próbka z udanego odczytu (także rekordy historii przy starcie, w kolejności czasu)
+    void update(const InverterSample& s) {
+        int64_t ts = s.timestamp_ms;
+        int64_t gap_from = 0;
+
+        // Całka mocy czynnej; moc ujemna (pobór w nocy) nie jest produkcją
+        if (s.regs.has(REG_ACTIVE_POWER)) {
+            double power_w = std::max(0.0, s.get<REG_ACTIVE_POWER>());
+            if (have_power && ts > last_ts) {
+                if (ts - last_ts <= MAX_INTEGRATION_GAP_MS) {
+                    double wh = (last_power_w + power_w) / 2.0 * double(ts - last_ts) / 3600000.0;
+                    attribute(last_ts, ts, wh, false);
+                    book.integrated_wh += wh;
+                    pending_wh += wh;
+                } else {
+                    book.gaps++;
+                    gap_from = last_ts;
+                }
+            }
+            have_power = true;
+            last_ts = ts;
+            last_power_w = power_w;
+        }
+
+        // Liczniki: całkowity jest odniesieniem, dzienny tylko gdy całkowity zawiedzie
+        const DeviceDescriptor& device = *s.device;
+        double max_power_w = device.max_power_w > 0 ? device.max_power_w :
+                             device.rated_power_w > 0 ? device.rated_power_w : FALLBACK_MAX_POWER_W;
+        double delta_wh[COUNTER_COUNT] = {};
+        CounterStep steps[COUNTER_COUNT];
+        for (size_t i = 0; i < COUNTER_COUNT; i++) {
+            steps[i] = step(counters[i], s, max_power_w, delta_wh[i]);
+            if (steps[i] == CounterStep::Glitch) book.glitches++;
+        }
+        if (steps[COUNTER_DAILY] == CounterStep::First) {
+            align(book.days, ts, counterWh(REG_DAILY_ENERGY, counters[COUNTER_DAILY].raw));
+        }
+        if (steps[COUNTER_MONTHLY] == CounterStep::First) {
+            align(book.months, ts, counterWh(REG_MONTHLY_ENERGY, counters[COUNTER_MONTHLY].raw));
+        }
+
+        int source = -1;
+        if (steps[COUNTER_TOTAL] == CounterStep::Advanced) {
+            source = COUNTER_TOTAL;
+        } else if ((steps[COUNTER_TOTAL] == CounterStep::Glitch || !s.regs.has(REG_TOTAL_ENERGY)) &&
+                   steps[COUNTER_DAILY] == CounterStep::Advanced) {
+            source = COUNTER_DAILY;
+        }
+        if (source < 0) {
+            // Nowy punkt odniesienia bez porównania - całka liczy się od niego
+            if (steps[COUNTER_TOTAL] == CounterStep::First || steps[COUNTER_TOTAL] == CounterStep::Glitch) {
+                pending_wh = 0.0;
+            }
+        } else {
+            book.residual_wh += delta_wh[source] - pending_wh;
+            pending_wh = 0.0;
+            // Różnica w granicach rozdzielczości licznika zostaje na później
+            double excess = book.residual_wh - std::clamp(book.residual_wh, -COUNTER_STEP_WH, COUNTER_STEP_WH);
+            if (excess != 0.0) {
+                book.residual_wh -= excess;
+                book.corrections_wh += excess;
+                attribute(gap_from > 0 ? gap_from : ts, ts, excess, true);
+            }
+        }
+        book.updated_ms = ts;
+    }
+
+    const EnergyLedger& ledger() const { return book; }
+};
@@ -0,0 +1,269 @@
+#pragma once
+
+// Zapis i odczyt surowych ramek Modbus (--capture), do odtwarzania bez urządzenia.
+// Ramka to jeden cykl odczytu: bloki planu z flagą powodzenia i słowami
+// rejestrów, zapasowy rejestr częstotliwości oraz adres urządzenia. Odtworzenie
+// przechodzi przez ten sam dekoder co odczyt na żywo (RegisterDecoder +
+// finishInverterSample), więc daje identyczne próbki.
+//
+// Plik: nagłówek CAPTURE_MAGIC (16 bajtów), potem ramki jedna za drugą:
+//   CaptureFrameHeader | (CaptureBlockHeader | count * uint16_t) * block_count
+// Każda ramka jest dopisywana jednym write() na deskryptorze O_APPEND, więc
+// wątki odczytu różnych bramek mogą pisać do tego samego pliku. Ucięta ostatnia
+// ramka (awaria w trakcie zapisu) jest przy odczycie pomijana.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "inverter_sample.hpp"
+#include "register_map.hpp"
+#include "register_planner.hpp"
+
+constexpr char CAPTURE_MAGIC[16] = "SUN2000-CAP-v1";
+
+struct CaptureFrameHeader {
+    uint32_t size;             // Cała ramka: nagłówek i bloki
+    uint16_t block_count;
+    uint16_t spare_frequency;  // Rejestr zapasowy częstotliwości (0 - nieodczytany)
+    int64_t timestamp_ms;
+    uint16_t port;
+    uint8_t slave;
+    uint8_t groups;            // Odczytane grupy rejestrów
+    char host[44];
+};
+
+struct CaptureBlockHeader {
+    uint16_t start;
+    uint16_t count;
+    uint16_t ok;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(CaptureFrameHeader) == 64, "Stały układ nagłówka ramki");
+static_assert(sizeof(CaptureBlockHeader) == 8, "Stały układ nagłówka bloku");
+
+class FrameCapture {
+private:
+    int fd = -1;
+    std::string error;
+
+public:
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    ~FrameCapture() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) != 0) {
+            error = "Nie można otworzyć " + path + ": " + strerror(errno);
+            close();
+            return false;
+        }
+        if (st.st_size == 0 && ::write(fd, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != ssize_t(sizeof(CAPTURE_MAGIC))) {
+            error = "Zapis nagłówka " + path + ": " + strerror(errno);
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    bool isOpen() const { return fd >= 0; }
+    const std::string& lastError() const { return error; }
+
+    // Wołane z wątków odczytu; buffer należy do połączenia, błąd zostaje w errno
+    bool append(int64_t timestamp_ms, const std::string& host, int port, int slave, uint8_t groups,
+                RegisterPlan& plan, uint16_t spare_frequency, std::vector<uint8_t>& buffer) const {
+        if (fd < 0) return true;
+        const auto& blocks = plan.blocks();
+        size_t size = sizeof(CaptureFrameHeader);
+        for (const auto& b : blocks) size += sizeof(CaptureBlockHeader) + b.count * sizeof(uint16_t);
+        buffer.resize(size);
+
+        CaptureFrameHeader h{};
+        h.size = uint32_t(size);
+        h.block_count = uint16_t(blocks.size());
+        h.spare_frequency = spare_frequency;
+        h.timestamp_ms = timestamp_ms;
+        h.port = uint16_t(port);
+        h.slave = uint8_t(slave);
+        h.groups = groups;
+        snprintf(h.host, sizeof(h.host), "%s", host.c_str());
+        uint8_t* p = buffer.data();
+        memcpy(p, &h, sizeof(h));
+        p += sizeof(h);
+        for (const auto& b : blocks) {
+            CaptureBlockHeader bh{b.start, b.count, uint16_t(b.ok), 0};
+            memcpy(p, &bh, sizeof(bh));
+            p += sizeof(bh);
+            memcpy(p, plan.blockData(b), b.count * sizeof(uint16_t));
+            p += b.count * sizeof(uint16_t);
+        }
+        return ::write(fd, buffer.data(), size) == ssize_t(size);
+    }
+};
+
+// Ramka wskazująca na dane zmapowanego pliku
+struct CaptureFrame {
+    CaptureFrameHeader header;
+    const uint8_t* blocks = nullptr;  // Pierwszy CaptureBlockHeader
+};
+
+// Odczyt pliku ramek (mapowany w pamięć, tylko do odczytu)
+class CaptureReader {
+private:
+    int fd = -1;
+    const uint8_t* map = nullptr;
+    size_t map_size = 0;
+    std::string error;
+
+public:
+    CaptureReader() = default;
+    CaptureReader(const CaptureReader&) = delete;
+    CaptureReader& operator=(const CaptureReader&) = delete;
+    ~CaptureReader() { close(); }
+
+    // Czy plik zaczyna się nagłówkiem zapisu ramek
+    static bool detect(const std::string& path) {
+        char magic[sizeof(CAPTURE_MAGIC)] = {};
+        int f = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (f < 0) return false;
+        bool ok = ::read(f, magic, sizeof(magic)) == ssize_t(sizeof(magic)) &&
+                  memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) == 0;
+        ::close(f);
+        return ok;
+    }
+
+    bool open(const std::string& path) {
+        close();
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) != 0) {
+            error = "Nie można otworzyć " + path + ": " + strerror(errno);
+            close();
+            return false;
+        }
+        map_size = size_t(st.st_size);
+        void* p = map_size >= sizeof(CAPTURE_MAGIC) ?
+            ::mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        if (p == MAP_FAILED || memcmp(p, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+            error = "Niezgodny format zapisu ramek " + path;
+            if (p != MAP_FAILED) ::munmap(p, map_size);
+            close();
+            return false;
+        }
+        map = static_cast<const uint8_t*>(p);
+        ::madvise(const_cast<uint8_t*>(map), map_size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if (map != nullptr) ::munmap(const_cast<uint8_t*>(map), map_size);
+        map = nullptr;
+        map_size = 0;
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    const std::string& lastError() const { return error; }
+    static constexpr size_t firstFrame() { return sizeof(CAPTURE_MAGIC); }
+
+    // Ramka od pozycji offset (przesuwanej za ramkę); false na końcu pliku
+    // albo przy uciętej / niespójnej ramce
+    bool next(size_t& offset, CaptureFrame& frame) const {
+        if (map == nullptr || offset + sizeof(CaptureFrameHeader) > map_size) return false;
+        memcpy(&frame.header, map + offset, sizeof(CaptureFrameHeader));
+        const CaptureFrameHeader& h = frame.header;
+        if (h.size < sizeof(CaptureFrameHeader) || h.size > map_size - offset) return false;
+        // Bloki muszą wypełniać ramkę dokładnie
+        size_t pos = sizeof(CaptureFrameHeader);
+        for (uint16_t i = 0; i < h.block_count; i++) {
+            CaptureBlockHeader bh;
+            if (pos + sizeof(bh) > h.size) return false;
+            memcpy(&bh, map + offset + pos, sizeof(bh));
+            pos += sizeof(bh) + bh.count * sizeof(uint16_t);
+        }
+        if (pos != h.size) return false;
+        frame.blocks = map + offset + sizeof(CaptureFrameHeader);
+        offset += h.size;
+        return true;
+    }
+};
+
+// Dekodowanie ramek jednego urządzenia. Plan z układem bloków ramki powstaje
+// przy pierwszym wystąpieniu układu (zwykle dwa-trzy: pełny i części grup).
+class CaptureDecoder {
+private:
+    struct Layout {
+        std::vector<uint32_t> spans;  // (start << 16) | count kolejnych bloków
+        RegisterPlan plan;
+        RegisterDecoder decoder;
+    };
+    std::vector<std::unique_ptr<Layout>> layouts;
+    std::vector<uint32_t> spans;
+
+    Layout* layoutFor(const CaptureFrame& frame) {
+        spans.clear();
+        const uint8_t* p = frame.blocks;
+        for (uint16_t i = 0; i < frame.header.block_count; i++) {
+            CaptureBlockHeader bh;
+            memcpy(&bh, p, sizeof(bh));
+            spans.push_back((uint32_t(bh.start) << 16) | bh.count);
+            p += sizeof(bh) + bh.count * sizeof(uint16_t);
+        }
+        for (auto& l : layouts) {
+            if (l->spans == spans) return l.get();
+        }
+        auto l = std::make_unique<Layout>();
+        l->spans = spans;
+        for (uint32_t s : spans) l->plan.want(uint16_t(s >> 16), uint16_t(s & 0xFFFF));
+        l->plan.build(0);  // Bloki zapisanego planu nie są sąsiednie, więc układ zostaje bez zmian
+        if (l->plan.blocks().size() != spans.size()) return nullptr;
+        l->decoder.bind(l->plan);
+        layouts.push_back(std::move(l));
+        return layouts.back().get();
+    }
+
+public:
+    // Ramka -> próbka. Pola spoza ramki zostają z przekazanej próbki (jak przy
+    // odczycie części grup). Zwraca false, gdy żaden blok nie był odczytany.
+    bool decode(const CaptureFrame& frame, InverterSample& sample) {
+        Layout* l = layoutFor(frame);
+        if (l == nullptr) return false;
+        PollStats stats;
+        const uint8_t* p = frame.blocks;
+        auto& blocks = l->plan.blocks();
+        for (auto& block : blocks) {
+            CaptureBlockHeader bh;
+            memcpy(&bh, p, sizeof(bh));
+            p += sizeof(bh);
+            memcpy(l->plan.blockData(block), p, bh.count * sizeof(uint16_t));
+            p += bh.count * sizeof(uint16_t);
+            block.ok = bh.ok != 0;
+            stats.round_trips++;
+            if (block.ok) stats.registers += block.count;
+            else stats.failed_blocks++;
+        }
+        sample.timestamp_ms = frame.header.timestamp_ms;
+        l->decoder.decode(l->plan, sample.regs);
+        finishInverterSample(l->plan, l->decoder, frame.header.groups, frame.header.spare_frequency, sample);
+        sample.poll = stats;
+        return stats.failed_blocks < int(blocks.size());
+    }
+};
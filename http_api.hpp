@@ -0,0 +1,504 @@
+#pragma once
+
+// Endpointy HTTP trybu bez interfejsu (--headless / --http):
+//   /devices              - lista urządzeń ze stanem odczytu (JSON)
+//   /sample?device=N      - ostatnia próbka w formacie pliku JSON (dane.json)
+//   /energy?device=N      - bilans produkcji: kubełki godzin, dób i miesięcy (JSON)
+//   /history?device=N&from=&to=&fields=&max_points=  - zakres z historii (JSON)
+//   /metrics              - pomiary urządzeń i ścieżki odczytu (Prometheus)
+// Odpowiedzi /devices, /sample, /energy i /metrics są serializowane raz na nową próbkę
+// (klucz: wersje z SeqlockSnapshot) i wysyłane z pamięci podręcznej - kolejne
+// zapytania kosztują tylko porównanie wersji. Obiekt używany tylko z wątku
+// serwera HTTP; dane urządzeń czytane bez blokad, historia pod blokadą
+// urządzenia (plik historii może być w tym czasie powiększany i przemapowany).
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "device_feed.hpp"
+#include "http_server.hpp"
+#include "metrics.hpp"
+#include "register_map.hpp"
+#include "sample_source.hpp"
+#include "sample_json.hpp"
+#include "timeseries_store.hpp"
+
+// Źródła danych jednego urządzenia
+struct HttpDeviceSource {
+    const DeviceFeed* feed = nullptr;
+    const TimeSeriesStore* history = nullptr;  // nullptr - bez historii
+    std::mutex* history_mutex = nullptr;        // Blokada zapisu historii przez wątek odczytu
+};
+
+class SunHttpApi {
+public:
+    static constexpr int64_t DEFAULT_HISTORY_MS = 3600LL * 1000;
+    static constexpr size_t DEFAULT_MAX_POINTS = 1000;
+    static constexpr size_t MAX_POINTS_LIMIT = 10000;
+    static constexpr int64_t METRICS_MAX_AGE_MS = 1000;  // Liczniki ścieżki odczytu odświeżane co najmniej co 1 s
+
+private:
+    struct CachedResponse {
+        uint64_t key = 0;
+        HttpResponsePtr response;
+    };
+
+    const SampleSource& source;
+    const PollMetrics& metrics;
+    std::vector<HttpDeviceSource> devices;
+
+    std::vector<CachedResponse> sample_cache;
+    std::vector<CachedResponse> energy_cache;
+    CachedResponse devices_cache;
+    CachedResponse metrics_cache;
+    HttpResponsePtr index_response;
+
+    // Bufory robocze (tylko wątek serwera)
+    SampleJsonWriter json{false};
+    DeviceSnapshot snap;
+    std::string body;
+
+    static constexpr const char* JSON_TYPE = "application/json";
+    static constexpr const char* TEXT_TYPE = "text/plain; charset=utf-8";
+    static constexpr const char* PROMETHEUS_TYPE = "text/plain; version=0.0.4; charset=utf-8";
+
+    static uint64_t mix(uint64_t key, uint64_t v) {
+        return key ^ (v + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2));
+    }
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Klucz zależny od wszystkich próbek i statusów (zmienia się po każdym odczycie)
+    uint64_t allVersionsKey() const {
+        uint64_t key = 1;
+        for (size_t d = 0; d < devices.size(); d++) {
+            uint64_t status_version = 0;
+            source.status(d, &status_version);
+            key = mix(mix(key, devices[d].feed->latest.version()), status_version);
+        }
+        return key;
+    }
+
+    HttpResponsePtr error(int status, const char* message) {
+        body = message;
+        body.push_back('\n');
+        return makeHttpResponse(status, TEXT_TYPE, body);
+    }
+
+    void appendInt(int64_t v) {
+        char buf[24];
+        auto r = std::to_chars(buf, buf + sizeof(buf), v);
+        body.append(buf, size_t(r.ptr - buf));
+    }
+
+    void appendNumber(double v, int decimals) {
+        char buf[40];
+        auto r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed, decimals);
+        body.append(buf, size_t(r.ptr - buf));
+    }
+
+    // Napis JSON / wartość etykiety Prometheusa (ta sama reguła dla " i \)
+    void appendQuoted(const char* s) {
+        body.push_back('"');
+        for (; *s; ++s) {
+            char c = *s;
+            if (c == '"' || c == '\\') {
+                body.push_back('\\');
+                body.push_back(c);
+            } else if (c == '\n') {
+                body.append("\\n");
+            } else if (static_cast<unsigned char>(c) >= 0x20) {
+                body.push_back(c);
+            }
+        }
+        body.push_back('"');
+    }
+
+    // Numer urządzenia z parametru device (domyślnie 0)
+    bool deviceParam(const HttpRequest& req, size_t& device) const {
+        std::string value;
+        if (!httpQueryParam(req.query, "device", value)) {
+            device = 0;
+            return !devices.empty();
+        }
+        size_t d = 0;
+        auto r = std::from_chars(value.data(), value.data() + value.size(), d);
+        if (r.ec != std::errc() || r.ptr != value.data() + value.size() || d >= devices.size()) return false;
+        device = d;
+        return true;
+    }
+
+    static bool int64Param(const HttpRequest& req, const char* name, int64_t& out) {
+        std::string value;
+        if (!httpQueryParam(req.query, name, value)) return true;  // Zostaje wartość domyślna
+        auto r = std::from_chars(value.data(), value.data() + value.size(), out);
+        return r.ec == std::errc() && r.ptr == value.data() + value.size();
+    }
+
+    HttpResponsePtr sample(const HttpRequest& req) {
+        size_t d;
+        if (!deviceParam(req, d)) return error(404, "Nieznane urządzenie");
+        CachedResponse& cached = sample_cache[d];
+        if (cached.response && cached.key == devices[d].feed->latest.version()) return cached.response;
+        cached.key = devices[d].feed->latest.load(snap);
+        cached.response = makeHttpResponse(200, JSON_TYPE, json.write(snap.sample, &snap.energy));
+        return cached.response;
+    }
+
+    // Kubełki od najstarszego: [początek_ms, kWh, w tym korekty kWh]
+    template <typename Ring>
+    void appendBuckets(const char* key, const Ring& ring) {
+        body.append(",\"");
+        body.append(key);
+        body.append("\":[");
+        for (size_t i = ring.size(); i-- > 0;) {
+            const EnergyBucket& b = ring.recent(i);
+            body.push_back('[');
+            appendInt(b.start_ms);
+            body.push_back(',');
+            appendNumber(b.energyWh() / 1000.0, 3);
+            body.push_back(',');
+            appendNumber(b.corrected_wh / 1000.0, 3);
+            body.append(i > 0 ? "]," : "]");
+        }
+        body.push_back(']');
+    }
+
+    HttpResponsePtr energy(const HttpRequest& req) {
+        size_t d;
+        if (!deviceParam(req, d)) return error(404, "Nieznane urządzenie");
+        CachedResponse& cached = energy_cache[d];
+        if (cached.response && cached.key == devices[d].feed->latest.version()) return cached.response;
+        cached.key = devices[d].feed->latest.load(snap);
+        const EnergyLedger& e = snap.energy;
+        body.clear();
+        body.append("{\"device\":");
+        appendQuoted(source.config(d).name.c_str());
+        body.append(",\"updated_ms\":");
+        appendInt(e.updated_ms);
+        body.append(",\"integrated_kwh\":");
+        appendNumber(e.integrated_wh / 1000.0, 3);
+        body.append(",\"corrections_kwh\":");
+        appendNumber(e.corrections_wh / 1000.0, 3);
+        body.append(",\"gaps\":");
+        appendInt(e.gaps);
+        body.append(",\"glitches\":");
+        appendInt(e.glitches);
+        body.append(",\"counter_resets\":");
+        appendInt(e.counter_resets);
+        appendBuckets("hours", e.hours);
+        appendBuckets("days", e.days);
+        appendBuckets("months", e.months);
+        body.push_back('}');
+        cached.response = makeHttpResponse(200, JSON_TYPE, body);
+        return cached.response;
+    }
+
+    HttpResponsePtr deviceList() {
+        uint64_t key = allVersionsKey();
+        if (devices_cache.response && devices_cache.key == key) return devices_cache.response;
+        body.clear();
+        body.push_back('[');
+        for (size_t d = 0; d < devices.size(); d++) {
+            const DeviceConfig& cfg = source.config(d);
+            DeviceStatus st = source.status(d);
+            devices[d].feed->latest.load(snap);
+            if (d > 0) body.push_back(',');
+            body.append("{\"id\":");
+            appendInt(int64_t(d));
+            body.append(",\"name\":");
+            appendQuoted(cfg.name.c_str());
+            body.append(",\"ip\":");
+            appendQuoted(cfg.ip.c_str());
+            body.append(",\"port\":");
+            appendInt(cfg.port);
+            body.append(",\"slave\":");
+            appendInt(cfg.slave_id);
+            body.append(",\"connected\":");
+            body.append(st.connected ? "true" : "false");
+            body.append(",\"health\":");
+            appendQuoted(linkHealthName(st.health));
+            body.append(",\"reconnect_attempts\":");
+            appendInt(st.reconnect_attempts);
+            body.append(",\"last_ok_ms\":");
+            appendInt(st.last_ok_ms);
+            body.append(",\"status\":");
+            appendQuoted(st.status);
+            body.append(",\"mode\":");
+            appendQuoted(pollModeName(st.mode));
+            body.append(",\"interval_s\":");
+            appendInt(st.current_interval_s);
+            body.append(",\"polls\":");
+            appendInt(int64_t(st.polls));
+            body.append(",\"failures\":");
+            appendInt(int64_t(st.failures));
+            body.append(",\"last_sample_ms\":");
+            appendInt(snap.sample.timestamp_ms);
+            body.append(",\"active_power\":");
+            appendNumber(snap.sample.get<REG_ACTIVE_POWER>(), 1);
+            body.append(",\"anomalies\":[");
+            bool first = true;
+            for (size_t k = 0; k < ANOMALY_COUNT; k++) {
+                if (!snap.anomalies.has(AnomalyKind(k))) continue;
+                if (!first) body.push_back(',');
+                appendQuoted(ANOMALIES[k].key);
+                first = false;
+            }
+            body.append("],\"error\":");
+            appendQuoted(snap.last_error);
+            body.push_back('}');
+        }
+        body.push_back(']');
+        devices_cache.key = key;
+        devices_cache.response = makeHttpResponse(200, JSON_TYPE, body);
+        return devices_cache.response;
+    }
+
+    HttpResponsePtr prometheus() {
+        uint64_t key = mix(allVersionsKey(), uint64_t(nowMs() / METRICS_MAX_AGE_MS));
+        if (metrics_cache.response && metrics_cache.key == key) return metrics_cache.response;
+
+        // Najpierw próbki wszystkich urządzeń, potem po jednej metryce na pole rejestru
+        std::vector<DeviceSnapshot> snaps(devices.size());
+        std::vector<DeviceStatus> statuses(devices.size());
+        for (size_t d = 0; d < devices.size(); d++) {
+            devices[d].feed->latest.load(snaps[d]);
+            statuses[d] = source.status(d);
+        }
+        body.clear();
+        auto labels = [&](size_t d) {
+            body.append("{device=");
+            appendQuoted(source.config(d).name.c_str());
+            body.push_back('}');
+        };
+        auto gauge = [&](const char* name, const char* help) {
+            body.append("# HELP sun2000_");
+            body.append(name);
+            body.push_back(' ');
+            body.append(help);
+            body.append("\n# TYPE sun2000_");
+            body.append(name);
+            body.append(" gauge\n");
+        };
+
+        gauge("up", "Połączenie z urządzeniem (1 - odczyt udany)");
+        for (size_t d = 0; d < devices.size(); d++) {
+            body.append("sun2000_up");
+            labels(d);
+            body.append(statuses[d].connected ? " 1\n" : " 0\n");
+        }
+        gauge("link_health", "Stan łącza: 0 łączenie, 1 OK, 2 błędy, 3 ponowne łączenie, 4 brak");
+        for (size_t d = 0; d < devices.size(); d++) {
+            body.append("sun2000_link_health");
+            labels(d);
+            body.push_back(' ');
+            appendInt(int(statuses[d].health));
+            body.push_back('\n');
+        }
+        gauge("poll_interval_seconds", "Bieżący interwał odczytu");
+        for (size_t d = 0; d < devices.size(); d++) {
+            body.append("sun2000_poll_interval_seconds");
+            labels(d);
+            body.push_back(' ');
+            appendInt(statuses[d].current_interval_s);
+            body.push_back('\n');
+        }
+        gauge("sample_timestamp_seconds", "Czas ostatniej próbki (epoka Unix)");
+        for (size_t d = 0; d < devices.size(); d++) {
+            body.append("sun2000_sample_timestamp_seconds");
+            labels(d);
+            body.push_back(' ');
+            appendNumber(double(snaps[d].sample.timestamp_ms) / 1000.0, 3);
+            body.push_back('\n');
+        }
+        for (const auto& desc : REGISTER_MAP) {
+            if (desc.type == RegType::STR || !(desc.group & REG_GROUPS_POLLED)) continue;
+            char help[48];
+            snprintf(help, sizeof(help), desc.unit[0] != '\0' ? "Rejestr %u [%s]" : "Rejestr %u",
+                     unsigned(desc.address), desc.unit);
+            gauge(desc.key, help);
+            for (size_t d = 0; d < devices.size(); d++) {
+                if (!snaps[d].sample.regs.has(desc.id)) continue;  // Bez odczytu - brak serii zamiast zera
+                body.append("sun2000_");
+                body.append(desc.key);
+                labels(d);
+                body.push_back(' ');
+                appendNumber(snaps[d].sample.value(desc.id), desc.decimals);
+                body.push_back('\n');
+            }
+        }
+        // Bilans produkcji w bieżących okresach
+        struct EnergyGauge {
+            const char* name;
+            const char* help;
+            int decimals;
+            double (*value)(const EnergyLedger&, int64_t);
+        };
+        static constexpr EnergyGauge ENERGY_GAUGES[] = {
+            {"energy_hour_kwh", "Produkcja w bieżącej godzinie (bilans) [kWh]", 3,
+             [](const EnergyLedger& e, int64_t ts) { return e.hours.energyAt(ts) / 1000.0; }},
+            {"energy_today_kwh", "Produkcja w bieżącej dobie (bilans) [kWh]", 3,
+             [](const EnergyLedger& e, int64_t ts) { return e.days.energyAt(ts) / 1000.0; }},
+            {"energy_month_kwh", "Produkcja w bieżącym miesiącu (bilans) [kWh]", 3,
+             [](const EnergyLedger& e, int64_t ts) { return e.months.energyAt(ts) / 1000.0; }},
+            {"energy_corrections_kwh", "Suma korekt całki mocy z liczników [kWh]", 3,
+             [](const EnergyLedger& e, int64_t) { return e.corrections_wh / 1000.0; }},
+            {"energy_counter_glitches", "Odrzucone skoki liczników energii", 0,
+             [](const EnergyLedger& e, int64_t) { return double(e.glitches); }},
+        };
+        for (const auto& g : ENERGY_GAUGES) {
+            gauge(g.name, g.help);
+            for (size_t d = 0; d < devices.size(); d++) {
+                const DeviceSnapshot& s = snaps[d];
+                if (s.energy.updated_ms == 0) continue;
+                body.append("sun2000_");
+                body.append(g.name);
+                labels(d);
+                body.push_back(' ');
+                appendNumber(g.value(s.energy, s.sample.timestamp_ms), g.decimals);
+                body.push_back('\n');
+            }
+        }
+        // Analiza strumienia próbek: flaga na rodzaj anomalii i wygładzone asymetrie faz
+        gauge("anomaly", "Aktywna anomalia (1 - wykryta)");
+        for (size_t d = 0; d < devices.size(); d++) {
+            if (snaps[d].sample.timestamp_ms == 0) continue;
+            for (size_t k = 0; k < ANOMALY_COUNT; k++) {
+                body.append("sun2000_anomaly{device=");
+                appendQuoted(source.config(d).name.c_str());
+                body.append(",kind=\"");
+                body.append(ANOMALIES[k].key);
+                body.append(snaps[d].anomalies.has(AnomalyKind(k)) ? "\"} 1\n" : "\"} 0\n");
+            }
+        }
+        gauge("voltage_imbalance_percent", "Asymetria napięć faz (wygładzona) [%]");
+        for (size_t d = 0; d < devices.size(); d++) {
+            if (snaps[d].sample.timestamp_ms == 0) continue;
+            body.append("sun2000_voltage_imbalance_percent");
+            labels(d);
+            body.push_back(' ');
+            appendNumber(snaps[d].anomalies.voltage_imbalance_pct, 2);
+            body.push_back('\n');
+        }
+        gauge("current_imbalance_percent", "Asymetria prądów faz (wygładzona) [%]");
+        for (size_t d = 0; d < devices.size(); d++) {
+            if (snaps[d].sample.timestamp_ms == 0) continue;
+            body.append("sun2000_current_imbalance_percent");
+            labels(d);
+            body.push_back(' ');
+            appendNumber(snaps[d].anomalies.current_imbalance_pct, 2);
+            body.push_back('\n');
+        }
+        appendMetricsText(body, metrics);
+
+        metrics_cache.key = key;
+        metrics_cache.response = makeHttpResponse(200, PROMETHEUS_TYPE, body);
+        return metrics_cache.response;
+    }
+
+    // Zakres historii; co k-ty rekord, tak by punktów było najwyżej max_points
+    HttpResponsePtr history(const HttpRequest& req) {
+        size_t d;
+        if (!deviceParam(req, d)) return error(404, "Nieznane urządzenie");
+        const HttpDeviceSource& src = devices[d];
+        if (src.history == nullptr) return error(404, "Urządzenie bez historii");
+
+        int64_t to_ms = nowMs() + 1;
+        if (!int64Param(req, "to", to_ms)) return error(400, "Niepoprawny parametr to");
+        int64_t from_ms = to_ms - DEFAULT_HISTORY_MS;
+        if (!int64Param(req, "from", from_ms)) return error(400, "Niepoprawny parametr from");
+        int64_t max_points = int64_t(DEFAULT_MAX_POINTS);
+        if (!int64Param(req, "max_points", max_points) || max_points < 1) {
+            return error(400, "Niepoprawny parametr max_points");
+        }
+        max_points = std::min<int64_t>(max_points, int64_t(MAX_POINTS_LIMIT));
+
+        // Pola: klucze z mapy rejestrów oddzielone przecinkami (domyślnie moc czynna)
+        std::vector<const RegisterDesc*> fields;
+        std::string list = "active_power";
+        httpQueryParam(req.query, "fields", list);
+        size_t pos = 0;
+        while (pos <= list.size()) {
+            size_t comma = list.find(',', pos);
+            if (comma == std::string::npos) comma = list.size();
+            std::string key = list.substr(pos, comma - pos);
+            const RegisterDesc* found = nullptr;
+            for (const auto& desc : REGISTER_MAP) {
+                if (desc.type != RegType::STR && key == desc.key) found = &desc;
+            }
+            if (found == nullptr) return error(400, ("Nieznane pole: " + key).c_str());
+            fields.push_back(found);
+            pos = comma + 1;
+        }
+
+        body.clear();
+        body.append("{\"device\":");
+        appendQuoted(source.config(d).name.c_str());
+        body.append(",\"from\":");
+        appendInt(from_ms);
+        body.append(",\"to\":");
+        appendInt(to_ms);
+        body.append(",\"fields\":[");
+        for (size_t f = 0; f < fields.size(); f++) {
+            if (f > 0) body.push_back(',');
+            appendQuoted(fields[f]->key);
+        }
+        body.append("],\"points\":[");
+        {
+            std::lock_guard<std::mutex> lock(*src.history_mutex);
+            auto range = src.history->range(from_ms, to_ms);
+            size_t count = range.second - range.first;
+            size_t step = std::max<size_t>(1, (count + size_t(max_points) - 1) / size_t(max_points));
+            for (size_t i = range.first; i < range.second; i += step) {
+                const TimeSeriesRecord& rec = src.history->at(i);
+                if (i > range.first) body.push_back(',');
+                body.push_back('[');
+                appendInt(rec.timestamp_ms);
+                for (const RegisterDesc* f : fields) {
+                    body.push_back(',');
+                    if (rec.has(f->id)) appendNumber(rec.value(f->id), f->decimals);
+                    else body.append("null");
+                }
+                body.push_back(']');
+            }
+        }
+        body.append("]}");
+        return makeHttpResponse(200, JSON_TYPE, body);
+    }
+
+public:
+    SunHttpApi(const SampleSource& sample_source, const PollMetrics& poll_metrics,
+               std::vector<HttpDeviceSource> sources)
+        : source(sample_source), metrics(poll_metrics), devices(std::move(sources)),
+          sample_cache(devices.size()), energy_cache(devices.size()) {
+        body.reserve(64 * 1024);
+        index_response = makeHttpResponse(200, TEXT_TYPE,
+            "Huawei SUN2000 - endpointy:\n"
+            "  /devices\n"
+            "  /sample?device=N\n"
+            "  /energy?device=N\n"
+            "  /history?device=N&from=<ms>&to=<ms>&fields=active_power,daily_yield_energy&max_points=1000\n"
+            "  /metrics\n");
+    }
+
+    // Obsługa zapytania (wątek serwera HTTP)
+    HttpResponsePtr handle(const HttpRequest& req) {
+        if (req.path == "/metrics") return prometheus();
+        if (req.path == "/sample") return sample(req);
+        if (req.path == "/energy") return energy(req);
+        if (req.path == "/devices") return deviceList();
+        if (req.path == "/history") return history(req);
+        if (req.path == "/") return index_response;
+        return error(404, "Nie znaleziono");
+    }
+};
@@ -0,0 +1,358 @@
+#pragma once
+
+// Minimalny serwer HTTP/1.1 (tylko GET) dla trybu bez interfejsu.
+// Jeden wątek (epoll), połączenia keep-alive, domyślnie tylko localhost.
+// Odpowiedzi to gotowe bufory (nagłówki + treść) współdzielone przez
+// shared_ptr - ta sama odpowiedź z pamięci podręcznej trafia do wielu
+// połączeń bez kopiowania, a obsługa zapytania to parsowanie jednej linii.
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+
+struct HttpRequest {
+    std::string method;
+    std::string path;   // Bez części zapytania
+    std::string query;  // Po '?', bez dekodowania
+    bool keep_alive = true;
+};
+
+using HttpResponsePtr = std::shared_ptr<const std::string>;
+
+inline const char* httpStatusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 431: return "Request Header Fields Too Large";
+    }
+    return "Internal Server Error";
+}
+
+// Kompletna odpowiedź HTTP gotowa do wysłania
+inline HttpResponsePtr makeHttpResponse(int status, const char* content_type, const std::string& body) {
+    char head[256];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nCache-Control: no-cache\r\n\r\n",
+                     status, httpStatusText(status), content_type, body.size());
+    auto response = std::make_shared<std::string>();
+    response->reserve(size_t(n) + body.size());
+    response->append(head, size_t(n));
+    response->append(body);
+    return response;
+}
+
+inline int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    return (c | 0x20) - 'a' + 10;
+}
+
+// Wartość parametru zapytania ("a=1&b=2") z dekodowaniem %XX i '+'; false gdy brak
+inline bool httpQueryParam(const std::string& query, const char* name, std::string& value) {
+    size_t name_len = strlen(name);
+    size_t pos = 0;
+    while (pos <= query.size()) {
+        size_t end = query.find('&', pos);
+        if (end == std::string::npos) end = query.size();
+        if (end - pos > name_len && query.compare(pos, name_len, name) == 0 && query[pos + name_len] == '=') {
+            value.clear();
+            for (size_t i = pos + name_len + 1; i < end; i++) {
+                char c = query[i];
+                if (c == '+') {
+                    value.push_back(' ');
+                } else if (c == '%' && i + 2 < end && isxdigit(static_cast<unsigned char>(query[i + 1])) &&
+                           isxdigit(static_cast<unsigned char>(query[i + 2]))) {
+                    value.push_back(char(hexDigit(query[i + 1]) * 16 + hexDigit(query[i + 2])));
+                    i += 2;
+                } else {
+                    value.push_back(c);
+                }
+            }
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+struct HttpServerStats {
+    std::atomic<uint64_t> connections{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> bad_requests{0};
+};
+
+class HttpServer {
+public:
+    // Wołane z wątku serwera; zwraca gotową odpowiedź (może pochodzić z pamięci podręcznej)
+    using Handler = std::function<HttpResponsePtr(const HttpRequest&)>;
+
+    static constexpr size_t MAX_REQUEST_HEAD = 8192;
+    static constexpr size_t MAX_CONNECTIONS = 256;
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string rx;
+        std::deque<HttpResponsePtr> out;  // Odpowiedzi czekające na wysłanie (potokowanie)
+        size_t out_offset = 0;            // Wysłane bajty pierwszej odpowiedzi
+        bool close_after = false;         // Zamknąć po wysłaniu kolejki
+        bool want_write = false;          // Zarejestrowane EPOLLOUT
+    };
+
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::atomic<bool> stopping{false};
+    std::string error;
+    HttpServerStats server_stats;
+
+    bool fail(const std::string& what) {
+        error = what + ": " + strerror(errno);
+        return false;
+    }
+
+    void closeConnection(int fd) {
+        ::close(fd);  // Zamknięcie usuwa też deskryptor z epoll
+        connections.erase(fd);
+    }
+
+    void setWriteInterest(Connection& c, bool enable) {
+        if (c.want_write == enable) return;
+        epoll_event ev{};
+        ev.events = enable ? uint32_t(EPOLLIN | EPOLLOUT) : uint32_t(EPOLLIN);
+        ev.data.fd = c.fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, c.fd, &ev);
+        c.want_write = enable;
+    }
+
+    // Wysyła kolejkę odpowiedzi; false gdy połączenie zostało zamknięte
+    bool flush(Connection& c) {
+        while (!c.out.empty()) {
+            const std::string& r = *c.out.front();
+            ssize_t n = ::send(c.fd, r.data() + c.out_offset, r.size() - c.out_offset, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EINTR) {
+                    setWriteInterest(c, true);
+                    return true;
+                }
+                closeConnection(c.fd);
+                return false;
+            }
+            c.out_offset += size_t(n);
+            if (c.out_offset == r.size()) {
+                c.out.pop_front();
+                c.out_offset = 0;
+            }
+        }
+        setWriteInterest(c, false);
+        if (c.close_after) {
+            closeConnection(c.fd);
+            return false;
+        }
+        return true;
+    }
+
+    static bool headerEquals(const char* begin, const char* end, const char* value) {
+        while (begin < end && (*begin == ' ' || *begin == '\t')) begin++;
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) end--;
+        size_t n = strlen(value);
+        return size_t(end - begin) == n && strncasecmp(begin, value, n) == 0;
+    }
+
+    // Parsuje nagłówek zapytania [head, head + size) (bez końcowego "\r\n\r\n")
+    static bool parseRequest(const char* head, size_t size, HttpRequest& req) {
+        const char* end = head + size;
+        const char* line_end = static_cast<const char*>(memchr(head, '\r', size));
+        if (line_end == nullptr) line_end = end;
+        const char* sp1 = static_cast<const char*>(memchr(head, ' ', size_t(line_end - head)));
+        if (sp1 == nullptr) return false;
+        const char* sp2 = static_cast<const char*>(memchr(sp1 + 1, ' ', size_t(line_end - sp1 - 1)));
+        if (sp2 == nullptr) return false;
+        req.method.assign(head, sp1);
+        std::string target(sp1 + 1, sp2);
+        if (target.empty() || target[0] != '/') return false;
+        size_t q = target.find('?');
+        req.path = target.substr(0, q);
+        req.query = q == std::string::npos ? std::string() : target.substr(q + 1);
+        // HTTP/1.0 domyślnie zamyka połączenie, HTTP/1.1 - utrzymuje
+        req.keep_alive = size_t(line_end - sp2 - 1) == 8 && strncmp(sp2 + 1, "HTTP/1.1", 8) == 0;
+
+        const char* p = line_end;
+        while (p < end) {
+            while (p < end && (*p == '\r' || *p == '\n')) p++;
+            const char* eol = static_cast<const char*>(memchr(p, '\r', size_t(end - p)));
+            if (eol == nullptr) eol = end;
+            const char* colon = static_cast<const char*>(memchr(p, ':', size_t(eol - p)));
+            if (colon != nullptr && size_t(colon - p) == 10 && strncasecmp(p, "connection", 10) == 0) {
+                if (headerEquals(colon + 1, eol, "close")) req.keep_alive = false;
+                else if (headerEquals(colon + 1, eol, "keep-alive")) req.keep_alive = true;
+            } else if (colon != nullptr && size_t(colon - p) == 14 && strncasecmp(p, "content-length", 14) == 0 &&
+                       !headerEquals(colon + 1, eol, "0")) {
+                return false;  // Zapytania z treścią nie są obsługiwane
+            }
+            p = eol;
+        }
+        return true;
+    }
+
+    void onReadable(Connection& c, const Handler& handler) {
+        char buf[4096];
+        while (true) {
+            ssize_t n = ::recv(c.fd, buf, sizeof(buf), 0);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+                closeConnection(c.fd);
+                return;
+            }
+            if (n < 0) break;
+            c.rx.append(buf, size_t(n));
+        }
+        // Wszystkie kompletne zapytania z bufora (klient może je potokować)
+        size_t pos = 0;
+        while (!c.close_after) {
+            size_t head_end = c.rx.find("\r\n\r\n", pos);
+            if (head_end == std::string::npos) {
+                if (c.rx.size() - pos > MAX_REQUEST_HEAD) {
+                    server_stats.bad_requests.fetch_add(1, std::memory_order_relaxed);
+                    c.out.push_back(makeHttpResponse(431, "text/plain; charset=utf-8", "Zbyt długi nagłówek\n"));
+                    c.close_after = true;
+                }
+                break;
+            }
+            HttpRequest req;
+            server_stats.requests.fetch_add(1, std::memory_order_relaxed);
+            if (!parseRequest(c.rx.data() + pos, head_end - pos, req)) {
+                server_stats.bad_requests.fetch_add(1, std::memory_order_relaxed);
+                c.out.push_back(makeHttpResponse(400, "text/plain; charset=utf-8", "Niepoprawne zapytanie\n"));
+                c.close_after = true;
+            } else if (req.method != "GET" && req.method != "HEAD") {
+                c.out.push_back(makeHttpResponse(405, "text/plain; charset=utf-8", "Tylko GET\n"));
+                c.close_after = !req.keep_alive;
+            } else {
+                HttpResponsePtr response = handler(req);
+                if (req.method == "HEAD") {
+                    size_t body = response->find("\r\n\r\n");
+                    response = std::make_shared<std::string>(response->substr(0, body + 4));
+                }
+                c.out.push_back(std::move(response));
+                c.close_after = !req.keep_alive;
+            }
+            pos = head_end + 4;
+        }
+        c.rx.erase(0, pos);
+        flush(c);
+    }
+
+    void acceptAll() {
+        int fd;
+        while ((fd = ::accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            if (connections.size() >= MAX_CONNECTIONS) {
+                ::close(fd);
+                continue;
+            }
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            auto c = std::make_unique<Connection>();
+            c->fd = fd;
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.fd = fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+            connections[fd] = std::move(c);
+            server_stats.connections.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+public:
+    HttpServer() = default;
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    ~HttpServer() {
+        for (auto& entry : connections) ::close(entry.first);
+        if (listen_fd >= 0) ::close(listen_fd);
+        if (wake_fd >= 0) ::close(wake_fd);
+        if (epoll_fd >= 0) ::close(epoll_fd);
+    }
+
+    // Nasłuch na adresie IPv4 (domyślnie tylko localhost)
+    bool listen(const std::string& address, int port) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epoll_fd < 0 || wake_fd < 0) return fail("epoll/eventfd");
+        listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0) return fail("socket");
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(uint16_t(port));
+        if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+            errno = EINVAL;
+            return fail("Niepoprawny adres " + address);
+        }
+        if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd, 64) != 0) {
+            return fail("Nie można nasłuchiwać na " + address + ":" + std::to_string(port));
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = listen_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &ev);
+        ev.data.fd = wake_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev);
+        return true;
+    }
+
+    // Pętla obsługi do wywołania stop() (z innego wątku)
+    void run(const Handler& handler) {
+        epoll_event events[64];
+        while (!stopping.load(std::memory_order_acquire)) {
+            int n = epoll_wait(epoll_fd, events, 64, -1);
+            if (n < 0 && errno != EINTR) break;
+            for (int e = 0; e < n; e++) {
+                int fd = events[e].data.fd;
+                if (fd == listen_fd) {
+                    acceptAll();
+                    continue;
+                }
+                if (fd == wake_fd) continue;
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;
+                Connection& c = *it->second;
+                if (events[e].events & (EPOLLHUP | EPOLLERR)) {
+                    closeConnection(fd);
+                } else if (events[e].events & EPOLLIN) {
+                    onReadable(c, handler);
+                } else if (events[e].events & EPOLLOUT) {
+                    flush(c);
+                }
+            }
+        }
+    }
+
+    void stop() {
+        stopping.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        if (wake_fd >= 0 && ::write(wake_fd, &one, sizeof(one)) < 0) {}
+    }
+
+    const std::string& lastError() const { return error; }
+    const HttpServerStats& stats() const { return server_stats; }
+};
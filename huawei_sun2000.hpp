@@ -0,0 +1,321 @@
+#pragma once
+
+// Połączenie Modbus TCP z inwerterem SUN2000.
+// Domyślnie nieblokujący klient z potokowaniem zapytań (modbus_tcp_client.hpp);
+// libmodbus pozostaje jako tryb zgodności (--transport libmodbus).
+// Jedno połączenie może obsługiwać kilka urządzeń za wspólną bramką
+// (SDongle / SmartLogger) - urządzenie wybiera się identyfikatorem slave.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <modbus/modbus.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "device_descriptor.hpp"
+#include "frame_capture.hpp"
+#include "inverter_sample.hpp"
+#include "metrics.hpp"
+#include "modbus_tcp_client.hpp"
+#include "register_map.hpp"
+#include "register_planner.hpp"
+
+// Parametry transportu Modbus
+struct ModbusLinkOptions {
+    bool use_libmodbus = false;                             // Zapytania blokujące, jedno po drugim
+    int pipeline = ModbusTcpClient::DEFAULT_PIPELINE;       // Zapytań w locie (tylko klient nieblokujący)
+    int timeout_ms = ModbusTcpClient::DEFAULT_TIMEOUT_MS;   // Termin odpowiedzi na zapytanie
+    PollMetrics* metrics = nullptr;                         // Pomiary ścieżki odczytu (opcjonalne)
+    const FrameCapture* capture = nullptr;                  // Zapis ramek do odtwarzania (opcjonalny)
+};
+
+class HuaweiSun2000 {
+private:
+    modbus_t *mb;
+    std::unique_ptr<ModbusTcpClient> client;  // Gdy nie używamy libmodbus
+    std::vector<ModbusTcpClient::Request> requests;
+    std::string ip_address;
+    int port;
+    int slave_id;
+    ModbusLinkOptions options;
+    bool link_broken = false;
+    bool answered = false;    // Urządzenie odpowiedziało w ostatnim cyklu (także wyjątkiem)
+    uint32_t min_rtt_us = 0;  // Najkrótszy czas odpowiedzi w ostatnim cyklu
+    int plan_max_gap;
+    PollStats last_stats;
+    std::vector<uint8_t> capture_buffer;  // Ramka do zapisu (wielokrotnego użytku)
+
+    // Plan odczytu dla zestawu grup rejestrów (budowany przy pierwszym użyciu)
+    struct GroupPlan {
+        uint8_t groups;
+        RegisterPlan plan;
+        RegisterDecoder decoder;
+    };
+    std::vector<std::unique_ptr<GroupPlan>> plans;
+
+    GroupPlan& planFor(uint8_t groups) {
+        for (auto& p : plans) {
+            if (p->groups == groups) return *p;
+        }
+        plans.push_back(std::make_unique<GroupPlan>());
+        GroupPlan& p = *plans.back();
+        p.groups = groups;
+        planRegisterGroups(p.plan, groups);
+        p.plan.build(plan_max_gap);
+        p.decoder.bind(p.plan);
+        return p;
+    }
+
+    // Błędy oznaczające zerwane połączenie (w odróżnieniu od timeoutu jednego urządzenia)
+    static bool isLinkError(int err) {
+        return err == ECONNRESET || err == EPIPE || err == ENOTCONN || err == EBADF ||
+               err == ECONNREFUSED || err == ECONNABORTED;
+    }
+
+    // Wynik jednego zapytania: histogram RTT, liczniki błędów, ping próbki
+    void recordRequest(bool ok, uint32_t rtt_us, bool timeout, bool exception) {
+        if (ok && (min_rtt_us == 0 || rtt_us < min_rtt_us)) min_rtt_us = std::max<uint32_t>(1, rtt_us);
+        if (ok || exception) answered = true;
+        if (options.metrics == nullptr) return;
+        PollMetrics& m = *options.metrics;
+        PollMetrics::add(m.requests);
+        if (ok) m.block_rtt.record(uint64_t(rtt_us));
+        if (timeout) PollMetrics::add(m.timeouts);
+        if (exception) PollMetrics::add(m.exceptions);
+    }
+
+    // libmodbus: pomiar jednego zapytania blokującego
+    int timedRead(int address, int count, uint16_t* dest) {
+        auto start = std::chrono::steady_clock::now();
+        int rc = modbus_read_registers(mb, address, count, dest);
+        int err = errno;
+        uint32_t rtt_us = uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        recordRequest(rc == count, rtt_us, rc != count && err == ETIMEDOUT,
+                      rc != count && err > int(MODBUS_ENOBASE) && err <= int(EMBXGTAR));
+        errno = err;
+        return rc;
+    }
+
+public:
+    HuaweiSun2000(const std::string& ip, int p = 6607, int max_gap = REGISTER_PLAN_MAX_GAP, int slave = 0,
+                  const ModbusLinkOptions& link_options = ModbusLinkOptions())
+        : mb(nullptr), ip_address(ip), port(p), slave_id(slave), options(link_options), plan_max_gap(max_gap) {
+        // Plan pełnego odczytu gotowy od razu; plany części grup powstają przy pierwszym użyciu
+        planFor(REG_GROUPS_POLLED);
+        if (!options.use_libmodbus) {
+            client = std::make_unique<ModbusTcpClient>(ip_address, port, options.timeout_ms, options.pipeline);
+        }
+    }
+
+    ~HuaweiSun2000() {
+        disconnect();
+    }
+
+    HuaweiSun2000(const HuaweiSun2000&) = delete;
+    HuaweiSun2000& operator=(const HuaweiSun2000&) = delete;
+
+    bool connect() {
+        disconnect();
+        link_broken = false;
+        if (client) return client->connect();
+
+        mb = modbus_new_tcp(ip_address.c_str(), port);
+        if (mb == nullptr) {
+            return false;
+        }
+
+        modbus_set_response_timeout(mb, uint32_t(options.timeout_ms / 1000),
+                                    uint32_t(options.timeout_ms % 1000) * 1000);
+        modbus_set_slave(mb, slave_id);
+
+        if (modbus_connect(mb) == -1) {
+            int err = errno;
+            modbus_free(mb);
+            mb = nullptr;
+            errno = err;
+            return false;
+        }
+        enableTcpKeepalive(modbus_get_socket(mb));
+
+        return true;
+    }
+
+    void disconnect() {
+        if (client) client->close();
+        if (mb != nullptr) {
+            modbus_close(mb);
+            modbus_free(mb);
+            mb = nullptr;
+        }
+    }
+
+    bool isConnected() const { return client ? client->isOpen() : mb != nullptr; }
+
+    // Przerywa trwający odczyt (z innego wątku, np. przy zamykaniu programu).
+    // libmodbus nie daje się przerwać - tam odczyt kończy się po timeoucie.
+    void cancel() {
+        if (client) client->cancel();
+    }
+
+    bool pipelined() const { return client != nullptr; }
+
+    // true, gdy ostatni odczyt zakończył się błędem połączenia - trzeba połączyć ponownie
+    bool linkBroken() const { return link_broken; }
+
+    // false, gdy w ostatnim cyklu nie przyszła żadna odpowiedź (same timeouty) -
+    // przy kilku takich cyklach z rzędu połączenie jest podejrzane (półotwarte)
+    bool lastPollAnswered() const { return answered; }
+
+    const std::string& address() const { return ip_address; }
+    int tcpPort() const { return port; }
+
+    // Zmiana urządzenia na wspólnym połączeniu (bramka z kilkoma inwerterami)
+    void setSlave(int slave) {
+        slave_id = slave;
+        if (mb != nullptr) modbus_set_slave(mb, slave_id);
+    }
+
+    // Pojedyncze zapytanie poza planem (oba transporty)
+    bool readRegisters(int address, int count, uint16_t* dest) {
+        if (!client) {
+            if (timedRead(address, count, dest) == count) return true;
+            if (isLinkError(errno)) link_broken = true;
+            return false;
+        }
+        ModbusTcpClient::Request r;
+        r.start = uint16_t(address);
+        r.count = uint16_t(count);
+        r.dest = dest;
+        client->transact(uint8_t(slave_id), &r, 1);
+        if (client->lastError() != 0) link_broken = true;
+        recordRequest(r.ok, r.rtt_us, !r.ok && r.tid != 0 && r.exception == 0 && !link_broken, r.exception != 0);
+        return r.ok;
+    }
+
+    // Nieudany odczyt zwraca false i nie zmienia value - zero z martwego łącza
+    // nie może udawać zmierzonej wartości
+    bool readHoldingRegister(int address, uint16_t& value) {
+        return readRegisters(address, 1, &value);
+    }
+
+    bool readHoldingRegister32(int address, uint32_t& value) {
+        uint16_t values[2];
+        if (!readRegisters(address, 2, values)) return false;
+        value = (uint32_t(values[0]) << 16) | values[1];
+        return true;
+    }
+
+    // Odczyt wszystkich bloków planu jednym potokiem zapytań
+    PollStats readPlanPipelined(RegisterPlan& plan) {
+        PollStats stats;
+        auto start = std::chrono::steady_clock::now();
+        auto& blocks = plan.blocks();
+        requests.resize(blocks.size());
+        for (size_t i = 0; i < blocks.size(); i++) {
+            requests[i].start = blocks[i].start;
+            requests[i].count = blocks[i].count;
+            requests[i].dest = plan.blockData(blocks[i]);
+        }
+        client->transact(uint8_t(slave_id), requests.data(), requests.size());
+        if (client->lastError() != 0) link_broken = true;
+        for (size_t i = 0; i < blocks.size(); i++) {
+            RegisterBlock& block = blocks[i];
+            const ModbusTcpClient::Request& r = requests[i];
+            uint16_t* dest = plan.blockData(block);
+            block.ok = r.ok;
+            if (r.tid != 0) {
+                // Zapytanie wysłane; brak odpowiedzi bez błędu połączenia to timeout
+                stats.round_trips++;
+                recordRequest(r.ok, r.rtt_us, !r.ok && r.exception == 0 && !link_broken, r.exception != 0);
+            }
+            if (block.ok) {
+                stats.registers += block.count;
+            } else {
+                std::fill(dest, dest + block.count, 0);
+                stats.failed_blocks++;
+            }
+        }
+        stats.wall_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    // Odczyt wszystkich bloków planu; nieudany blok jest zerowany
+    PollStats readPlan(RegisterPlan& plan) {
+        if (client) return readPlanPipelined(plan);
+        PollStats stats;
+        auto start = std::chrono::steady_clock::now();
+        for (auto& block : plan.blocks()) {
+            uint16_t* dest = plan.blockData(block);
+            if (link_broken) {
+                // Po zerwaniu połączenia kolejne zapytania tylko czekałyby na timeout
+                block.ok = false;
+            } else {
+                stats.round_trips++;
+                block.ok = timedRead(block.start, block.count, dest) == block.count;
+                if (!block.ok) {
+                    if (isLinkError(errno)) link_broken = true;
+                    else if (errno == ETIMEDOUT) modbus_flush(mb);  // Spóźniona odpowiedź nie trafi do następnego zapytania
+                }
+            }
+            if (block.ok) {
+                stats.registers += block.count;
+            } else {
+                std::fill(dest, dest + block.count, 0);
+                stats.failed_blocks++;
+            }
+        }
+        stats.wall_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    const PollStats& lastPollStats() const { return last_stats; }
+
+    // Odczyt jednej próbki z wybranych grup rejestrów; pola pozostałych grup
+    // zostają z poprzedniej próbki. Zwraca false, gdy żaden blok nie został odczytany
+    bool readInverterData(InverterSample& sample, uint8_t groups = REG_GROUPS_POLLED) {
+        sample.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        // Jeden odczyt blokowy zamiast osobnego zapytania na każde pole
+        auto poll_start = std::chrono::steady_clock::now();
+        min_rtt_us = 0;
+        answered = false;
+        GroupPlan& group_plan = planFor(groups);
+        last_stats = readPlan(group_plan.plan);
+        group_plan.decoder.decode(group_plan.plan, sample.regs);
+
+        // Częstotliwość sieci: rejestr zapasowy poza planem, odczyt tylko gdy potrzebny
+        uint16_t spare_frequency = 0;
+        if ((groups & REG_GROUP_POWER) && sample.regs.raw[REG_GRID_FREQUENCY] == 0 && !link_broken &&
+            sample.regs.has(REG_GRID_FREQUENCY)) {
+            if (!readHoldingRegister(SPARE_GRID_FREQUENCY_ADDRESS, spare_frequency)) spare_frequency = 0;
+            last_stats.round_trips++;
+        }
+        finishInverterSample(group_plan.plan, group_plan.decoder, groups, spare_frequency, sample);
+        if (options.capture != nullptr) {
+            options.capture->append(sample.timestamp_ms, ip_address, port, slave_id, groups, group_plan.plan,
+                                    spare_frequency, capture_buffer);
+        }
+
+        // Ping: najkrótszy czas odpowiedzi w cyklu (najbliższy RTT sieci), -1 gdy brak odpowiedzi
+        sample.ping_ms = min_rtt_us > 0 ? int16_t(std::min<uint32_t>((min_rtt_us + 500) / 1000, 32767)) : -1;
+
+        auto poll_time = std::chrono::steady_clock::now() - poll_start;
+        last_stats.wall_ms = std::chrono::duration<double, std::milli>(poll_time).count();
+        sample.poll = last_stats;
+        bool ok = last_stats.failed_blocks < int(group_plan.plan.blocks().size());
+        if (options.metrics != nullptr) {
+            options.metrics->poll_duration.record(poll_time);
+            PollMetrics::add(options.metrics->polls);
+            if (!ok) PollMetrics::add(options.metrics->failed_polls);
+            if (link_broken) PollMetrics::add(options.metrics->link_errors);
+        }
+        return ok;
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+// Binarna próbka danych invertera - jedyne źródło prawdy od dekodowania
+// Modbus aż do wyświetlenia i zapisu. Struktura jest trywialnie kopiowalna
+// (bez std::string), więc kopiowanie między wątkami to zwykłe memcpy.
+
+#include <cstdint>
+#include <ctime>
+#include <type_traits>
+
+#include "device_descriptor.hpp"
+#include "register_map.hpp"
+#include "register_planner.hpp"
+
+struct InverterSample {
+    int64_t timestamp_ms = 0;          // Czas odczytu (epoka Unix, ms)
+    RegisterValues regs;               // Surowe wartości wszystkich pól z mapy rejestrów
+    PollStats poll;                    // Koszt odczytu
+    const DeviceDescriptor* device = &UNKNOWN_DEVICE;  // Identyfikacja (internowana, niezmienna)
+    int16_t ping_ms = 0;
+
+    double value(RegId id) const { return regs.value(id); }
+    template <RegId ID> double get() const { return regs.get<ID>(); }
+    uint16_t state() const { return uint16_t(regs.raw[REG_DEVICE_STATE]); }
+};
+
+static_assert(std::is_trivially_copyable<InverterSample>::value,
+              "InverterSample musi być trywialnie kopiowalna");
+
+// Rejestr zapasowy częstotliwości sieci (licznik energii) - odczytywany poza planem,
+// gdy 32085 zwraca 0
+constexpr uint16_t SPARE_GRID_FREQUENCY_ADDRESS = 37118;
+
+// Dokończenie próbki po dekodowaniu planu - wspólne dla odczytu z urządzenia
+// i odtwarzania zapisanych ramek. spare_frequency: rejestr zapasowy (0 - brak).
+// Częstotliwość: brak odczytu (32085 i rejestr zapasowy dają 0) - pole nieważne;
+// odczyt spoza okna 45-65 Hz - ważne 0
+inline void finishInverterSample(const RegisterPlan& plan, const RegisterDecoder& decoder, uint8_t groups,
+                                 uint16_t spare_frequency, InverterSample& sample) {
+    RegisterValues& values = sample.regs;
+    if ((groups & REG_GROUP_POWER) && values.raw[REG_GRID_FREQUENCY] == 0) {
+        values.raw[REG_GRID_FREQUENCY] = spare_frequency;
+        if (spare_frequency == 0) values.valid.reset(REG_GRID_FREQUENCY);
+    }
+    double frequency_hz = values.get<REG_GRID_FREQUENCY>();
+    if (values.has(REG_GRID_FREQUENCY) && (frequency_hz < 45.0 || frequency_hz > 65.0)) {
+        values.raw[REG_GRID_FREQUENCY] = 0;
+    }
+    // Identyfikacja tylko po połączeniu - w pozostałych odczytach zostaje wskaźnik z poprzedniej próbki
+    if (groups & REG_GROUP_IDENT) {
+        if (const DeviceDescriptor* device = decodeDescriptor(plan, decoder, values)) sample.device = device;
+    }
+}
+
+// Opis stanu pracy (rejestr 32089); nullptr dla nieznanego kodu
+inline const char* deviceStatusName(uint16_t state) {
+    switch(state) {
+        case 0x0000: return "Standby: inicjalizacja";
+        case 0x0200: return "On-grid";
+        case 0x0201: return "On-grid: moc ograniczona";
+        case 0x0300: return "Wyłączony: błąd";
+        case 0x0308: return "Wyłączony: mała moc wejściowa";
+        case 0xA000: return "Standby: brak napromieniowania";
+    }
+    return nullptr;
+}
+
+// Czas lokalny próbki w formacie "YYYY-MM-DD HH:MM:SS" (bufor min. 20 znaków)
+inline size_t formatSampleTime(int64_t timestamp_ms, char* out, size_t out_size) {
+    time_t t = time_t(timestamp_ms / 1000);
+    struct tm tm_local;
+    localtime_r(&t, &tm_local);
+    return strftime(out, out_size, "%Y-%m-%d %H:%M:%S", &tm_local);
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+// Publikacja bieżącej próbki w formacie JSON dla frontendu WWW.
+// - plik: zapis do pliku tymczasowego i atomowe rename() - czytelnik nigdy
+//   nie zobaczy połowicznie zapisanego pliku
+// - unix:<ścieżka>: datagram na lokalne gniazdo UNIX (SOCK_DGRAM)
+// - fifo:<ścieżka>: jedna linia JSON na próbkę do nazwanego potoku
+// Z binary = true zamiast JSON wysyłany jest rekord binarny (sample_codec.hpp);
+// w potoku każdy rekord poprzedza jego długość (varint) zamiast końca linii.
+// Zapis jest pomijany, gdy wartości się nie zmieniły (z okresowym
+// "heartbeatem") lub gdy nie minął minimalny odstęp między zapisami.
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "inverter_sample.hpp"
+#include "sample_codec.hpp"
+#include "sample_json.hpp"
+
+enum class PublishTarget { File, UnixSocket, Fifo };
+
+struct PublisherConfig {
+    std::string target = "/var/www/html/dane.json";  // Ścieżka lub "unix:..."/"fifo:..."
+    bool pretty = true;                              // Wcięcia jak dotychczas (dump(2))
+    bool binary = false;                             // Rekord binarny zamiast JSON
+    int min_interval_ms = 0;                         // Minimalny odstęp między zapisami
+    int heartbeat_s = 60;                            // Zapis mimo braku zmian co tyle sekund
+};
+
+struct PublisherStats {
+    uint64_t writes = 0;
+    uint64_t skipped_unchanged = 0;
+    uint64_t skipped_rate = 0;
+    uint64_t errors = 0;
+    uint64_t bytes_written = 0;
+    double last_write_us = 0.0;
+    double max_write_us = 0.0;
+    int last_errno = 0;
+};
+
+class JsonPublisher {
+private:
+    PublisherConfig config;
+    PublishTarget kind = PublishTarget::File;
+    std::string path;
+    std::string tmp_path;
+    SampleJsonWriter writer;
+    SampleWireWriter wire_writer;
+    std::string length_prefix;
+    PublisherStats stats;
+    int fd = -1;  // Gniazdo lub FIFO (dla pliku otwierany przy każdym zapisie)
+    sockaddr_un sock_addr{};
+
+    bool have_last = false;
+    RegisterValues last_regs;
+    const DeviceDescriptor* last_device = nullptr;
+    std::chrono::steady_clock::time_point last_write_time;
+
+    static bool startsWith(const std::string& s, const char* prefix) {
+        return s.compare(0, strlen(prefix), prefix) == 0;
+    }
+
+    bool sameAsLast(const InverterSample& s) const {
+        return have_last && s.device == last_device &&
+               memcmp(s.regs.raw, last_regs.raw, sizeof(last_regs.raw)) == 0 &&
+               s.regs.valid == last_regs.valid;
+    }
+
+    static bool writeAll(int out_fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::write(out_fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            size -= size_t(n);
+        }
+        return true;
+    }
+
+    bool writeFile(const std::string& body) {
+        int out = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (out < 0) return false;
+        bool ok = writeAll(out, body.data(), body.size());
+        ok = (::close(out) == 0) && ok;
+        if (ok && ::rename(tmp_path.c_str(), path.c_str()) != 0) ok = false;
+        if (!ok) {
+            int err = errno;
+            ::unlink(tmp_path.c_str());
+            errno = err;
+        }
+        return ok;
+    }
+
+    bool writeSocket(const std::string& body) {
+        if (fd < 0) {
+            fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+            if (fd < 0) return false;
+        }
+        ssize_t n = ::sendto(fd, body.data(), body.size(), MSG_NOSIGNAL,
+                             reinterpret_cast<const sockaddr*>(&sock_addr), sizeof(sock_addr));
+        return n == ssize_t(body.size());
+    }
+
+    bool writeFifo(const std::string& body) {
+        if (fd < 0) {
+            // Bez czytelnika open() zwraca ENXIO - próbka jest wtedy pomijana
+            fd = ::open(path.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+            if (fd < 0) return false;
+        }
+        iovec parts[2];
+        if (config.binary) {
+            length_prefix.clear();
+            appendVarint(length_prefix, body.size());
+            parts[0] = {const_cast<char*>(length_prefix.data()), length_prefix.size()};
+            parts[1] = {const_cast<char*>(body.data()), body.size()};
+        } else {
+            parts[0] = {const_cast<char*>(body.data()), body.size()};
+            parts[1] = {const_cast<char*>("\n"), 1};
+        }
+        ssize_t n = ::writev(fd, parts, 2);
+        if (n != ssize_t(parts[0].iov_len + parts[1].iov_len)) {
+            // EPIPE (czytelnik zniknął) lub EAGAIN (pełny potok) - otwórz ponownie przy następnej próbce
+            int err = errno;
+            ::close(fd);
+            fd = -1;
+            errno = err;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    explicit JsonPublisher(const PublisherConfig& cfg) : config(cfg), writer(cfg.pretty) {
+        if (startsWith(config.target, "unix:")) {
+            kind = PublishTarget::UnixSocket;
+            path = config.target.substr(5);
+            sock_addr.sun_family = AF_UNIX;
+            strncpy(sock_addr.sun_path, path.c_str(), sizeof(sock_addr.sun_path) - 1);
+        } else if (startsWith(config.target, "fifo:")) {
+            kind = PublishTarget::Fifo;
+            path = config.target.substr(5);
+        } else {
+            kind = PublishTarget::File;
+            path = config.target;
+            tmp_path = path + ".tmp";
+        }
+    }
+
+    ~JsonPublisher() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    JsonPublisher(const JsonPublisher&) = delete;
+    JsonPublisher& operator=(const JsonPublisher&) = delete;
+
+    // Publikuje próbkę (z bilansem energii, jeśli podany); zwraca true, jeśli dane zostały zapisane
+    bool publish(const InverterSample& sample, const EnergyLedger* energy = nullptr) {
+        auto now = std::chrono::steady_clock::now();
+        if (have_last) {
+            auto since_last = now - last_write_time;
+            if (since_last < std::chrono::milliseconds(config.min_interval_ms)) {
+                stats.skipped_rate++;
+                return false;
+            }
+            if (sameAsLast(sample) && since_last < std::chrono::seconds(config.heartbeat_s)) {
+                stats.skipped_unchanged++;
+                return false;
+            }
+        }
+
+        const std::string& body = config.binary ? wire_writer.write(sample) : writer.write(sample, energy);
+        bool ok = false;
+        switch (kind) {
+            case PublishTarget::File: ok = writeFile(body); break;
+            case PublishTarget::UnixSocket: ok = writeSocket(body); break;
+            case PublishTarget::Fifo: ok = writeFifo(body); break;
+        }
+        int write_errno = errno;
+
+        auto done = std::chrono::steady_clock::now();
+        stats.last_write_us = std::chrono::duration<double, std::micro>(done - now).count();
+        if (stats.last_write_us > stats.max_write_us) stats.max_write_us = stats.last_write_us;
+        if (!ok) {
+            stats.errors++;
+            stats.last_errno = write_errno;
+            return false;
+        }
+
+        stats.writes++;
+        stats.bytes_written += body.size();
+        have_last = true;
+        last_regs = sample.regs;
+        last_device = sample.device;
+        last_write_time = now;
+        return true;
+    }
+
+    const PublisherStats& getStats() const { return stats; }
+    PublishTarget targetKind() const { return kind; }
+    const std::string& targetPath() const { return path; }
+};
@@ -0,0 +1,178 @@
+#pragma once
+
+// Pomiary ścieżki odczytu: histogramy opóźnień i liczniki zdarzeń.
+// Histogram jest log-liniowy (jak HDR): 16 przedziałów na każdą potęgę dwójki,
+// czyli błąd względny ~6% w całym zakresie od 1 µs do ~70 minut.
+// Zapis to jeden fetch_add na atomowym liczniku - bez blokad, więc można
+// go wołać z wątków odczytu i z wątku interfejsu jednocześnie.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+#include "text_format.hpp"
+
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;  // Przedziały na potęgę dwójki
+    static constexpr int MAX_BIT = 31;               // Wartości do 2^32 µs
+    static constexpr int BUCKETS = (MAX_BIT - SUB_BITS + 2) * SUB_COUNT;
+
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+        uint64_t buckets[BUCKETS] = {};
+
+        double meanUs() const { return count > 0 ? double(sum_us) / double(count) : 0.0; }
+
+        // Górna granica przedziału zawierającego percentyl p (0-100)
+        uint64_t percentileUs(double p) const {
+            if (count == 0) return 0;
+            uint64_t rank = uint64_t(double(count) * p / 100.0 + 0.5);
+            rank = std::max<uint64_t>(1, std::min(rank, count));
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; i++) {
+                seen += buckets[i];
+                if (seen >= rank) return std::min(bucketHigh(i), max_us);
+            }
+            return max_us;
+        }
+    };
+
+private:
+    std::atomic<uint64_t> counts[BUCKETS];
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+
+public:
+    LatencyHistogram() {
+        for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+    }
+
+    static int bucketIndex(uint64_t us) {
+        if (us < uint64_t(SUB_COUNT)) return int(us);
+        us = std::min<uint64_t>(us, (uint64_t(1) << (MAX_BIT + 1)) - 1);
+        int msb = 63 - __builtin_clzll(us);
+        int shift = msb - SUB_BITS;
+        return (shift + 1) * SUB_COUNT + int(us >> shift) - SUB_COUNT;
+    }
+
+    static uint64_t bucketHigh(int index) {
+        if (index < SUB_COUNT) return uint64_t(index);
+        int shift = index / SUB_COUNT - 1;
+        uint64_t sub = uint64_t(index % SUB_COUNT + SUB_COUNT);
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void record(uint64_t us) {
+        counts[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(us, std::memory_order_relaxed);
+        uint64_t prev = maximum.load(std::memory_order_relaxed);
+        while (us > prev && !maximum.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {}
+    }
+
+    template <typename Duration>
+    void record(Duration d) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        record(uint64_t(std::max<int64_t>(0, us)));
+    }
+
+    // Kopia stanu do odczytu percentyli (liczniki czytane niezależnie - wystarczające do podglądu)
+    void snapshot(Snapshot& out) const {
+        for (int i = 0; i < BUCKETS; i++) out.buckets[i] = counts[i].load(std::memory_order_relaxed);
+        out.count = total.load(std::memory_order_relaxed);
+        out.sum_us = sum.load(std::memory_order_relaxed);
+        out.max_us = maximum.load(std::memory_order_relaxed);
+    }
+};
+
+// Wszystkie pomiary ścieżki odczytu w jednym miejscu
+struct PollMetrics {
+    LatencyHistogram block_rtt;      // Czas odpowiedzi na pojedyncze zapytanie (blok rejestrów)
+    LatencyHistogram poll_duration;  // Cały cykl odczytu urządzenia
+    LatencyHistogram render_frame;   // Budowa klatki interfejsu
+
+    std::atomic<uint64_t> polls{0};
+    std::atomic<uint64_t> failed_polls{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<uint64_t> exceptions{0};       // Odpowiedzi z wyjątkiem Modbus
+    std::atomic<uint64_t> link_errors{0};      // Zerwane połączenia
+    std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> reconnects{0};       // Ponowne połączenia po utracie
+    std::atomic<uint64_t> connect_failures{0};
+
+    static void add(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+};
+
+// Pomiary w formacie tekstowym Prometheusa dopisywane do bufora
+// (wspólne dla pliku textfile collectora i endpointu HTTP /metrics)
+inline void appendMetricsText(std::string& out, const PollMetrics& m) {
+    auto counter = [&](const char* name, const char* help, const std::atomic<uint64_t>& v) {
+        appendFormat(out, "# HELP sun2000_%s %s\n# TYPE sun2000_%s counter\nsun2000_%s %llu\n",
+                     name, help, name, name, (unsigned long long)v.load(std::memory_order_relaxed));
+    };
+    LatencyHistogram::Snapshot snap;
+    auto summary = [&](const char* name, const char* help, const LatencyHistogram& h) {
+        h.snapshot(snap);
+        appendFormat(out, "# HELP sun2000_%s_seconds %s\n# TYPE sun2000_%s_seconds summary\n", name, help, name);
+        const double quantiles[] = {50.0, 90.0, 99.0, 99.9};
+        for (double q : quantiles) {
+            appendFormat(out, "sun2000_%s_seconds{quantile=\"%g\"} %.6f\n", name, q / 100.0,
+                         double(snap.percentileUs(q)) / 1e6);
+        }
+        appendFormat(out, "sun2000_%s_seconds_sum %.6f\nsun2000_%s_seconds_count %llu\n",
+                     name, double(snap.sum_us) / 1e6, name, (unsigned long long)snap.count);
+        // Maksimum nie należy do rodziny summary - osobna rodzina gauge
+        appendFormat(out,
+                     "# HELP sun2000_%s_seconds_max %s - maksimum\n# TYPE sun2000_%s_seconds_max gauge\n"
+                     "sun2000_%s_seconds_max %.6f\n",
+                     name, help, name, name, double(snap.max_us) / 1e6);
+    };
+
+    counter("polls_total", "Cykle odczytu", m.polls);
+    counter("failed_polls_total", "Cykle bez żadnego odczytanego bloku", m.failed_polls);
+    counter("requests_total", "Zapytania Modbus", m.requests);
+    counter("timeouts_total", "Zapytania bez odpowiedzi w terminie", m.timeouts);
+    counter("exceptions_total", "Odpowiedzi z wyjątkiem Modbus", m.exceptions);
+    counter("link_errors_total", "Zerwane połączenia", m.link_errors);
+    counter("connects_total", "Udane połączenia", m.connects);
+    counter("reconnects_total", "Ponowne połączenia po utracie", m.reconnects);
+    counter("connect_failures_total", "Nieudane próby połączenia", m.connect_failures);
+    summary("block_rtt", "Czas odpowiedzi na zapytanie o blok rejestrów", m.block_rtt);
+    summary("poll_duration", "Czas cyklu odczytu urządzenia", m.poll_duration);
+    summary("render_frame", "Czas budowy klatki interfejsu", m.render_frame);
+}
+
+// Eksport w formacie tekstowym Prometheusa (np. dla textfile collector
+// node_exportera). Zapis do pliku tymczasowego i rename(), jak przy JSON.
+inline bool writeMetricsFile(const std::string& path, const PollMetrics& m) {
+    std::string text;
+    text.reserve(8192);
+    appendMetricsText(text, m);
+
+    std::string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "w");
+    if (f == nullptr) return false;
+    bool ok = fwrite(text.data(), 1, text.size(), f) == text.size();
+    ok = fflush(f) == 0 && ok;
+    ok = (fclose(f) == 0) && ok;
+    if (ok && rename(tmp.c_str(), path.c_str()) != 0) ok = false;
+    if (!ok) {
+        int err = errno;
+        unlink(tmp.c_str());
+        errno = err;
+    }
+    return ok;
+}
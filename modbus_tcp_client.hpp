@@ -0,0 +1,380 @@
+#pragma once
+
+// Nieblokujący klient Modbus TCP (epoll) z potokowaniem zapytań.
+// Kilka zapytań FC03 z różnymi identyfikatorami transakcji jest wysyłanych
+// bez czekania na odpowiedzi, a odpowiedzi są dopasowywane po identyfikatorze -
+// cykl odczytu trwa zbliżony do jednego RTT zamiast sumy RTT wszystkich bloków.
+// Każde zapytanie ma własny termin; spóźniona odpowiedź na przeterminowane
+// zapytanie jest rozpoznawana po identyfikatorze i odrzucana. cancel() z
+// dowolnego wątku przerywa oczekiwanie (zamykanie programu bez czekania na timeout).
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// Keepalive TCP: bramka zrestartowana bez zamknięcia połączenia (utrata zasilania,
+// restart SDongle) jest wykrywana przez jądro po ok. idle + interval * count sekund,
+// a niepotwierdzony zapis kończy się błędem po tym samym czasie (TCP_USER_TIMEOUT)
+// zamiast po kilkunastu minutach retransmisji
+constexpr int TCP_KEEPALIVE_IDLE_S = 10;
+constexpr int TCP_KEEPALIVE_INTERVAL_S = 5;
+constexpr int TCP_KEEPALIVE_COUNT = 3;
+
+inline void enableTcpKeepalive(int fd) {
+    if (fd < 0) return;
+    int one = 1, idle = TCP_KEEPALIVE_IDLE_S, interval = TCP_KEEPALIVE_INTERVAL_S, count = TCP_KEEPALIVE_COUNT;
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+    unsigned int user_timeout_ms = unsigned((idle + interval * count) * 1000);
+    setsockopt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, &user_timeout_ms, sizeof(user_timeout_ms));
+}
+
+class ModbusTcpClient {
+public:
+    static constexpr int DEFAULT_TIMEOUT_MS = 5000;
+    static constexpr int DEFAULT_PIPELINE = 4;      // Zapytań w locie na połączenie
+    static constexpr size_t MBAP_SIZE = 7;          // Nagłówek Modbus TCP
+    static constexpr size_t MAX_ADU_SIZE = 260;
+
+    // Odczyt bloku rejestrów (FC03); wynik w dest, ok ustawiane po odpowiedzi
+    struct Request {
+        uint16_t start = 0;
+        uint16_t count = 0;
+        uint16_t* dest = nullptr;
+        bool ok = false;
+        uint8_t exception = 0;  // Kod wyjątku Modbus (0 - brak)
+        uint32_t rtt_us = 0;    // Czas od wysłania do odpowiedzi
+        // Stan wewnętrzny transakcji
+        uint16_t tid = 0;
+        bool pending = false;
+        std::chrono::steady_clock::time_point sent{};
+        std::chrono::steady_clock::time_point deadline{};
+    };
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::string host;
+    int port;
+    int timeout_ms;
+    int pipeline;
+    int fd = -1;
+    int epoll_fd = -1;
+    int cancel_fd = -1;
+    uint16_t next_tid = 1;
+    int error = 0;  // errno ostatniego błędu połączenia (0 - połączenie sprawne)
+    std::atomic<bool> cancel_requested{false};
+
+    uint8_t rx[MAX_ADU_SIZE * 8];
+    size_t rx_len = 0;
+    std::vector<uint8_t> tx;
+    size_t tx_sent = 0;
+
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = uint8_t(v >> 8);
+        p[1] = uint8_t(v & 0xFF);
+    }
+    static uint16_t get16(const uint8_t* p) { return uint16_t((p[0] << 8) | p[1]); }
+
+    bool failLink(int err) {
+        error = err;
+        close();
+        errno = err;
+        return false;
+    }
+
+    // Czeka na zdarzenia gniazda; false - przerwane przez cancel()
+    bool wait(int timeout, bool& readable, bool& writable) {
+        readable = writable = false;
+        epoll_event events[2];
+        int n;
+        do {
+            n = epoll_wait(epoll_fd, events, 2, timeout);
+        } while (n < 0 && errno == EINTR);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == cancel_fd) return false;
+            if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) readable = true;
+            if (events[i].events & EPOLLOUT) writable = true;
+        }
+        return true;
+    }
+
+    void watch(bool want_write) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | (want_write ? EPOLLOUT : 0u);
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    // Wysyła zaległe ramki; false przy błędzie połączenia
+    bool flushTx() {
+        while (tx_sent < tx.size()) {
+            ssize_t n = ::send(fd, tx.data() + tx_sent, tx.size() - tx_sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                return false;
+            }
+            tx_sent += size_t(n);
+        }
+        if (tx_sent == tx.size()) {
+            tx.clear();
+            tx_sent = 0;
+        }
+        return true;
+    }
+
+    void queueRequest(uint8_t unit, Request& r) {
+        uint8_t frame[12];
+        r.tid = next_tid++;
+        if (next_tid == 0) next_tid = 1;  // 0 oznacza "brak transakcji"
+        put16(frame, r.tid);
+        put16(frame + 2, 0);      // Protokół Modbus
+        put16(frame + 4, 6);      // Długość: unit + PDU
+        frame[6] = unit;
+        frame[7] = 0x03;
+        put16(frame + 8, r.start);
+        put16(frame + 10, r.count);
+        tx.insert(tx.end(), frame, frame + sizeof(frame));
+        r.pending = true;
+        r.ok = false;
+        r.exception = 0;
+        r.rtt_us = 0;
+        r.sent = Clock::now();
+        r.deadline = r.sent + std::chrono::milliseconds(timeout_ms);
+    }
+
+    // Przetwarza kompletne ramki z bufora; zwraca liczbę rozstrzygniętych zapytań
+    // albo -1 przy rozsynchronizowanym strumieniu
+    int parseResponses(uint8_t unit, Request* reqs, size_t n) {
+        int resolved = 0;
+        size_t pos = 0;
+        while (rx_len - pos >= MBAP_SIZE) {
+            const uint8_t* f = rx + pos;
+            uint16_t length = get16(f + 4);
+            if (get16(f + 2) != 0 || length < 2 || length > MAX_ADU_SIZE - 6) return -1;
+            size_t frame_size = 6 + size_t(length);
+            if (rx_len - pos < frame_size) break;
+            pos += frame_size;
+
+            uint16_t tid = get16(f);
+            Request* r = nullptr;
+            for (size_t i = 0; i < n; i++) {
+                if (reqs[i].pending && reqs[i].tid == tid) {
+                    r = &reqs[i];
+                    break;
+                }
+            }
+            if (r == nullptr || f[6] != unit) continue;  // Spóźniona odpowiedź - odrzucona
+            r->pending = false;
+            r->rtt_us = uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - r->sent).count());
+            resolved++;
+            const uint8_t* pdu = f + MBAP_SIZE;
+            if (pdu[0] == 0x83 && length >= 3) {
+                r->exception = pdu[1];
+            } else if (pdu[0] == 0x03 && length >= 3 && pdu[1] == r->count * 2 &&
+                       length == 3 + size_t(pdu[1])) {
+                for (uint16_t k = 0; k < r->count; k++) r->dest[k] = get16(pdu + 2 + 2 * k);
+                r->ok = true;
+            }
+        }
+        if (pos > 0) {
+            memmove(rx, rx + pos, rx_len - pos);
+            rx_len -= pos;
+        }
+        return resolved;
+    }
+
+public:
+    ModbusTcpClient(const std::string& h, int p, int timeout = DEFAULT_TIMEOUT_MS, int depth = DEFAULT_PIPELINE)
+        : host(h), port(p), timeout_ms(timeout), pipeline(std::max(1, depth)) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        cancel_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = cancel_fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, cancel_fd, &ev);
+        tx.reserve(12 * size_t(pipeline));
+    }
+
+    ~ModbusTcpClient() {
+        close();
+        if (cancel_fd >= 0) ::close(cancel_fd);
+        if (epoll_fd >= 0) ::close(epoll_fd);
+    }
+
+    ModbusTcpClient(const ModbusTcpClient&) = delete;
+    ModbusTcpClient& operator=(const ModbusTcpClient&) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+    int lastError() const { return error; }
+    int pipelineDepth() const { return pipeline; }
+
+    // Przerywa bieżące i kolejne operacje (bezpieczne z dowolnego wątku)
+    void cancel() {
+        cancel_requested = true;
+        uint64_t one = 1;
+        ssize_t r = ::write(cancel_fd, &one, sizeof(one));
+        (void)r;
+    }
+
+    bool cancelled() const { return cancel_requested.load(); }
+
+    // Przywraca działanie po cancel()
+    void resetCancel() {
+        uint64_t value;
+        ssize_t r = ::read(cancel_fd, &value, sizeof(value));
+        (void)r;
+        cancel_requested = false;
+    }
+
+    // Nieblokujące połączenie z limitem czasu
+    bool connect() {
+        close();
+        error = 0;
+        if (cancelled()) return failLink(ECANCELED);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(uint16_t(port));
+        if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            addrinfo hints{}, *res = nullptr;
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || res == nullptr) {
+                error = EHOSTUNREACH;
+                errno = error;
+                return false;
+            }
+            addr.sin_addr = reinterpret_cast<sockaddr_in*>(res->ai_addr)->sin_addr;
+            freeaddrinfo(res);
+        }
+
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return failLink(errno);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // Małe ramki bez opóźnienia Nagle'a
+        enableTcpKeepalive(fd);
+        epoll_event ev{};
+        ev.events = EPOLLOUT;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            if (errno != EINPROGRESS) return failLink(errno);
+            bool readable, writable;
+            if (!wait(timeout_ms, readable, writable)) return failLink(ECANCELED);
+            if (!writable && !readable) return failLink(ETIMEDOUT);
+            int so_error = 0;
+            socklen_t len = sizeof(so_error);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+            if (so_error != 0) return failLink(so_error);
+        }
+        watch(false);
+        rx_len = 0;
+        tx.clear();
+        tx_sent = 0;
+        return true;
+    }
+
+    void close() {
+        if (fd >= 0) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    // Wykonuje zapytania z potokowaniem; zwraca liczbę udanych.
+    // Błąd połączenia zamyka gniazdo (lastError() != 0), timeout dotyczy tylko
+    // pojedynczych zapytań i nie zrywa połączenia.
+    int transact(uint8_t unit, Request* reqs, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            reqs[i].ok = false;
+            reqs[i].pending = false;
+            reqs[i].tid = 0;
+        }
+        if (fd < 0) {
+            errno = error != 0 ? error : ENOTCONN;
+            return 0;
+        }
+        size_t next = 0, done = 0;
+        int inflight = 0, ok = 0, timed_out = 0;
+        bool aborted = false;
+        while (done < n) {
+            while (next < n && inflight < pipeline) {
+                queueRequest(unit, reqs[next++]);
+                inflight++;
+            }
+            if (!flushTx()) {
+                failLink(errno);
+                break;
+            }
+            watch(!tx.empty());
+
+            auto now = Clock::now();
+            auto earliest = Clock::time_point::max();
+            for (size_t i = 0; i < next; i++) {
+                if (reqs[i].pending) earliest = std::min(earliest, reqs[i].deadline);
+            }
+            int wait_ms = int(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(
+                earliest - now).count() + 1));
+            bool readable, writable;
+            if (!wait(wait_ms, readable, writable)) {
+                aborted = true;
+                break;
+            }
+            if (readable) {
+                ssize_t got = ::recv(fd, rx + rx_len, sizeof(rx) - rx_len, 0);
+                if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    failLink(got == 0 ? ECONNRESET : errno);
+                    break;
+                }
+                if (got > 0) {
+                    rx_len += size_t(got);
+                    int resolved = parseResponses(unit, reqs, next);
+                    if (resolved < 0) {
+                        failLink(EPROTO);
+                        break;
+                    }
+                    done += size_t(resolved);
+                    inflight -= resolved;
+                }
+            }
+            // Przeterminowane zapytania - odpowiedź, jeśli kiedyś przyjdzie, zostanie odrzucona
+            now = Clock::now();
+            for (size_t i = 0; i < next; i++) {
+                if (reqs[i].pending && reqs[i].deadline <= now) {
+                    reqs[i].pending = false;
+                    done++;
+                    inflight--;
+                    timed_out++;
+                }
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            reqs[i].pending = false;
+            if (reqs[i].ok) ok++;
+        }
+        if (error != 0) errno = error;
+        else if (aborted) errno = ECANCELED;
+        else if (timed_out > 0) errno = ETIMEDOUT;
+        else if (ok < int(n)) errno = EIO;  // Wyjątek Modbus lub niepoprawna odpowiedź
+        return ok;
+    }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+// Adaptacyjne planowanie odczytów jednego urządzenia.
+//  - Grupy rejestrów mają własne okresy: moc i alarmy w każdym odczycie,
+//    liczniki energii co 30 s, pomiary/statystyki/łączność co minutę,
+//    parametry nominalne co godzinę, identyfikacja tylko po połączeniu.
+//  - Interwał odczytu zależy od stanu: szybki przy rozruchu i gwałtownych
+//    zmianach mocy, wydłużony w nocy (stan 0xA000 - brak napromieniowania),
+//    zwykły w pozostałych przypadkach.
+// Wycofanie po błędach zostaje w silniku odczytu - tu tylko udane odczyty.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "inverter_sample.hpp"
+#include "register_map.hpp"
+
+// Okres odczytu grupy rejestrów (0 - w każdym odczycie, GROUP_ONCE - tylko po reset())
+struct GroupRate {
+    uint8_t groups;
+    int period_s;
+};
+
+constexpr int GROUP_ONCE = -1;
+
+constexpr GroupRate GROUP_RATES[] = {
+    {REG_GROUP_POWER | REG_GROUP_ALARM, 0},
+    {REG_GROUP_ENERGY, 30},
+    {REG_GROUP_MEASURE | REG_GROUP_STATS | REG_GROUP_COMM, 60},
+    {REG_GROUP_CONFIG, 3600},
+    {REG_GROUP_IDENT, GROUP_ONCE},
+};
+constexpr size_t GROUP_RATE_COUNT = sizeof(GROUP_RATES) / sizeof(GROUP_RATES[0]);
+
+// Terminy grup rejestrów jednego urządzenia
+class GroupSchedule {
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    Clock::time_point next[GROUP_RATE_COUNT] = {};  // Domyślnie - od razu
+
+public:
+    // Grupy do odczytu teraz
+    uint8_t due(Clock::time_point now) const {
+        uint8_t mask = 0;
+        for (size_t i = 0; i < GROUP_RATE_COUNT; i++) {
+            if (GROUP_RATES[i].period_s == 0 || now >= next[i]) mask |= GROUP_RATES[i].groups;
+        }
+        return mask;
+    }
+
+    // Grupy odczytane z powodzeniem - następny termin za okres grupy
+    void done(uint8_t groups, Clock::time_point now) {
+        for (size_t i = 0; i < GROUP_RATE_COUNT; i++) {
+            if ((GROUP_RATES[i].groups & groups) == GROUP_RATES[i].groups) {
+                next[i] = GROUP_RATES[i].period_s == GROUP_ONCE ? Clock::time_point::max() :
+                    now + std::chrono::seconds(GROUP_RATES[i].period_s);
+            }
+        }
+    }
+
+    // Wszystkie grupy przy następnym odczycie (po połączeniu, na żądanie)
+    void reset() {
+        for (auto& t : next) t = Clock::time_point{};
+    }
+};
+
+enum class PollMode : uint8_t { Normal, Fast, Night };
+
+inline const char* pollModeName(PollMode mode) {
+    switch (mode) {
+        case PollMode::Fast: return "szybki";
+        case PollMode::Night: return "noc";
+        case PollMode::Normal: break;
+    }
+    return "zwykły";
+}
+
+// Interwał następnego odczytu na podstawie ostatnich próbek
+class AdaptiveInterval {
+public:
+    static constexpr double FAST_CHANGE_FRACTION = 0.10;  // Zmiana mocy > 10% skali - szybki odczyt
+    static constexpr double MIN_SCALE_W = 1000.0;         // Skala dla małych mocy
+    static constexpr int FAST_HOLD_POLLS = 6;             // Szybkie odczyty po ostatniej dużej zmianie
+    static constexpr uint16_t STATE_STANDBY_INIT = 0x0000;     // Rozruch (inicjalizacja)
+    static constexpr uint16_t STATE_NO_IRRADIATION = 0xA000;   // Noc
+
+private:
+    int normal_s;
+    int fast_s;   // 0 - bez szybkiego trybu
+    int night_s;  // 0 - bez nocnego trybu
+    bool has_previous = false;
+    double previous_power = 0.0;
+    uint16_t previous_state = 0;
+    int fast_left = 0;
+    PollMode current = PollMode::Normal;
+
+public:
+    AdaptiveInterval(int normal_interval_s = 10, int fast_interval_s = 0, int night_interval_s = 0)
+        : normal_s(std::max(1, normal_interval_s)), fast_s(fast_interval_s), night_s(night_interval_s) {}
+
+    // Udany odczyt; zwraca interwał do następnego (sekundy)
+    int next(const InverterSample& sample) {
+        uint16_t state = sample.state();
+        double power = sample.get<REG_ACTIVE_POWER>();
+        double rated = sample.device->rated_power_w;
+        double scale = std::max({rated, previous_power, MIN_SCALE_W});
+
+        bool changed = has_previous &&
+            (std::fabs(power - previous_power) > FAST_CHANGE_FRACTION * scale || state != previous_state);
+        if (changed || state == STATE_STANDBY_INIT) fast_left = FAST_HOLD_POLLS;
+        else if (fast_left > 0) fast_left--;
+
+        has_previous = true;
+        previous_power = power;
+        previous_state = state;
+
+        if (night_s > 0 && state == STATE_NO_IRRADIATION) {
+            fast_left = 0;
+            current = PollMode::Night;
+            return std::max(night_s, normal_s);
+        }
+        if (fast_s > 0 && fast_left > 0) {
+            current = PollMode::Fast;
+            return std::min(fast_s, normal_s);
+        }
+        current = PollMode::Normal;
+        return normal_s;
+    }
+
+    // Po błędzie odczytu porównanie z poprzednią próbką nie ma sensu
+    void forget() {
+        has_previous = false;
+        fast_left = 0;
+        current = PollMode::Normal;
+    }
+
+    PollMode mode() const { return current; }
+    int normalInterval() const { return normal_s; }
+};
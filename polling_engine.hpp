@@ -0,0 +1,559 @@
+#pragma once
+
+// Silnik odczytu wielu inwerterów na wspólnej puli wątków.
+// Urządzenia (IP, port, slave ID) pochodzą z pliku konfiguracyjnego INI.
+// Każde urządzenie ma własny termin następnego odczytu (z rozrzutem, żeby
+// urządzenia nie odpytywały bramki jednocześnie), a kilka wątków roboczych
+// obsługuje urządzenia w kolejności terminów. Urządzenia za tą samą bramką
+// (ten sam IP:port) dzielą jedno trwałe połączenie - bramka i tak obsługuje
+// zapytania po kolei. Awaria jednego urządzenia wydłuża tylko jego interwał.
+// Utracone połączenie jest nawiązywane od razu jeszcze raz (restart bramki),
+// a potem z wycofaniem wykładniczym z rozrzutem, nie rzadziej niż co interwał
+// odczytu przez pierwsze LINK_OFFLINE_S - dane wracają najpóźniej po jednym
+// interwale od powrotu bramki.
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "huawei_sun2000.hpp"
+#include "poll_scheduler.hpp"
+#include "sample_source.hpp"
+#include "snapshot.hpp"
+
+// Wczytuje listę urządzeń z pliku INI:
+//   [falownik1]
+//   ip = 10.88.45.1
+//   port = 6607
+//   slave = 1
+//   interval = 10
+//   fast_interval = 3
+//   night_interval = 300
+//   output = /var/www/html/dane1.json
+//   history = falownik1.tsdb
+// Linie zaczynające się od '#' lub ';' są komentarzami.
+inline bool loadDeviceConfig(const std::string& path, std::vector<DeviceConfig>& out, std::string& error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "Nie można otworzyć " + path;
+        return false;
+    }
+    auto trim = [](const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r");
+        size_t e = s.find_last_not_of(" \t\r");
+        return b == std::string::npos ? std::string() : s.substr(b, e - b + 1);
+    };
+    auto toInt = [](const std::string& s, int& v) {
+        char* end = nullptr;
+        long n = strtol(s.c_str(), &end, 10);
+        if (s.empty() || *end != '\0') return false;
+        v = int(n);
+        return true;
+    };
+
+    std::vector<DeviceConfig> devices;
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+        std::string where = path + ":" + std::to_string(line_no) + ": ";
+        if (line.front() == '[') {
+            if (line.back() != ']') {
+                error = where + "niezamknięta sekcja";
+                return false;
+            }
+            devices.emplace_back();
+            devices.back().name = trim(line.substr(1, line.size() - 2));
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            error = where + "oczekiwano klucz = wartość";
+            return false;
+        }
+        if (devices.empty()) {
+            error = where + "klucz poza sekcją [urządzenie]";
+            return false;
+        }
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        DeviceConfig& dev = devices.back();
+        bool ok = true;
+        if (key == "ip") dev.ip = value;
+        else if (key == "port") ok = toInt(value, dev.port) && dev.port > 0 && dev.port < 65536;
+        else if (key == "slave") ok = toInt(value, dev.slave_id) && dev.slave_id >= 0 && dev.slave_id <= 247;
+        else if (key == "interval") ok = toInt(value, dev.interval_s) && dev.interval_s > 0;
+        else if (key == "fast_interval") ok = toInt(value, dev.fast_interval_s) && dev.fast_interval_s >= 0;
+        else if (key == "night_interval") ok = toInt(value, dev.night_interval_s) && dev.night_interval_s >= 0;
+        else if (key == "output") dev.output = value;
+        else if (key == "history") dev.history = value;
+        else {
+            error = where + "nieznany klucz '" + key + "'";
+            return false;
+        }
+        if (!ok) {
+            error = where + "niepoprawna wartość '" + value + "' dla '" + key + "'";
+            return false;
+        }
+    }
+    for (const auto& dev : devices) {
+        if (dev.ip.empty()) {
+            error = path + ": brak adresu ip w sekcji [" + dev.name + "]";
+            return false;
+        }
+    }
+    if (devices.empty()) {
+        error = path + ": brak urządzeń";
+        return false;
+    }
+    out = std::move(devices);
+    return true;
+}
+
+class PollingEngine : public SampleSource {
+public:
+    static constexpr int MAX_BACKOFF_S = 300;     // Maksymalny interwał urządzenia z błędami
+    static constexpr int RECONNECT_FIRST_MS = 1000;  // Pierwsza przerwa po nieudanym połączeniu
+    static constexpr int RECONNECT_JITTER_PERCENT = 20;  // Rozrzut ponownych połączeń bramek
+    static constexpr int LINK_OFFLINE_S = 300;    // Po takiej przerwie próby połączenia do MAX_BACKOFF_S
+    static constexpr int LINK_SILENT_POLLS = 2;   // Cykle urządzenia bez odpowiedzi, po których sprawdzamy łącze
+    static constexpr int JITTER_PERCENT = 5;      // Rozrzut terminów (+/- procent interwału)
+    static constexpr int BUSY_RETRY_MS = 50;      // Ponowienie, gdy bramka jest zajęta
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Trwałe połączenie z bramką; pola poza link chronione przez io
+    struct Endpoint {
+        std::unique_ptr<HuaweiSun2000> link;
+        std::mutex io;
+        Clock::time_point retry_at{};
+        Clock::time_point down_since{};  // Utrata połączenia (albo start programu)
+        int attempts = 0;                // Nieudane próby połączenia od utraty
+        Clock::time_point last_answer{};  // Ostatnia odpowiedź dowolnego urządzenia (albo połączenie)
+        bool answered = false;           // Któreś urządzenie odpowiedziało na bieżącym połączeniu
+        int retry_interval_s = 0;        // Najkrótszy interwał odczytu urządzeń za bramką
+        bool ever_connected = false;
+        std::mt19937 rng{std::random_device{}()};
+    };
+
+    struct Device {
+        DeviceConfig config;
+        size_t endpoint;
+        DeviceStatus status;  // Chronione przez mutex silnika
+        std::unique_ptr<SeqlockSnapshot<DeviceStatus>> published;  // Kopia dla interfejsu
+        // Chronione przez io bramki (zerowane po połączeniu dla wszystkich urządzeń bramki)
+        GroupSchedule groups;
+        // Używane tylko przez wątek odczytujący urządzenie
+        AdaptiveInterval adaptive;
+        InverterSample last;        // Poprzednia próbka - pola grup pominiętych w odczycie
+        // Chronione przez mutex silnika
+        uint64_t generation = 0;    // Terminy w kolejce z inną generacją są nieaktualne
+        bool in_flight = false;
+        bool poll_now = false;      // Odczyt na żądanie w trakcie trwającego odczytu
+        bool refresh_all = false;   // Następny odczyt obejmuje wszystkie grupy
+        // Używane tylko przez wątek odczytujący urządzenie
+        int device_failures = 0;    // Kolejne nieudane odczyty przy sprawnym połączeniu
+        // Chronione przez io bramki
+        int silent_polls = 0;              // Kolejne odczyty bez żadnej odpowiedzi
+        Clock::time_point silent_since{};  // Pierwszy z nich
+    };
+
+    struct Due {
+        Clock::time_point at;
+        Clock::time_point deadline;  // Termin bez rozrzutu - podstawa następnego terminu
+        size_t device;
+        uint64_t generation;
+        bool operator>(const Due& o) const { return at > o.at; }
+    };
+
+    std::vector<Device> devices;
+    std::vector<std::unique_ptr<Endpoint>> endpoints;
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+    SampleCallback on_sample;
+    ChangeCallback on_change;
+    PollMetrics* metrics = nullptr;
+    std::mt19937 rng{std::random_device{}()};
+
+    Clock::duration jitter(int interval_s) {
+        int64_t span_ms = int64_t(interval_s) * 1000 * JITTER_PERCENT / 100;
+        if (span_ms <= 0) return Clock::duration::zero();
+        std::uniform_int_distribution<int64_t> dist(-span_ms, span_ms);
+        return std::chrono::milliseconds(dist(rng));
+    }
+
+    // Wynik jednej próby odczytu urządzenia
+    struct PollResult {
+        bool attempted = false;  // false - połączenie w trakcie wycofania
+        bool ok = false;
+        bool connected = false;
+        bool link_down = false;  // Brak połączenia - termin wyznacza retry_at, nie interwał
+        uint8_t groups = 0;      // Odczytane grupy rejestrów
+        LinkHealth health = LinkHealth::Connecting;
+        int attempts = 0;
+        std::string status;
+        Clock::time_point retry_at{};
+    };
+
+    static std::string endpointName(const Device& dev) {
+        return dev.config.ip + ":" + std::to_string(dev.config.port);
+    }
+
+    // Przerwa przed kolejną próbą połączenia: 1 s, 2 s, 4 s, ... nie dłużej niż
+    // interwał odczytu, a po LINK_OFFLINE_S bez połączenia do MAX_BACKOFF_S.
+    // Rozrzut rozsuwa próby bramek, które straciły połączenie razem (restart routera)
+    Clock::duration reconnectDelay(Endpoint& ep, Clock::time_point now) {
+        bool offline = now - ep.down_since >= std::chrono::seconds(LINK_OFFLINE_S);
+        int64_t cap_ms = int64_t(offline ? MAX_BACKOFF_S : ep.retry_interval_s) * 1000;
+        int shift = std::min(std::max(ep.attempts - 1, 0), 16);
+        int64_t delay_ms = std::min(cap_ms, int64_t(RECONNECT_FIRST_MS) << shift);
+        int64_t span_ms = delay_ms * RECONNECT_JITTER_PERCENT / 100;
+        std::uniform_int_distribution<int64_t> dist(-span_ms, span_ms);
+        return std::chrono::milliseconds(delay_ms + dist(ep.rng));
+    }
+
+    // Zamyka zerwane połączenie; następna próba bez czekania
+    static void dropLink(Endpoint& ep) {
+        ep.link->disconnect();
+        ep.retry_at = Clock::now();
+        if (ep.attempts == 0) ep.down_since = ep.retry_at;
+    }
+
+    // Nieudana próba połączenia (także zerwanie tuż po nawiązaniu) - wycofanie
+    void connectFailed(Endpoint& ep, PollResult& r) {
+        auto now = Clock::now();
+        if (ep.attempts == 0 && ep.ever_connected) ep.down_since = now;
+        ep.attempts++;
+        ep.retry_at = now + reconnectDelay(ep, now);
+        r.link_down = true;
+        r.retry_at = ep.retry_at;
+    }
+
+    // Nawiązuje połączenie z bramką; false - następna próba w ep.retry_at
+    bool connectEndpoint(Device& dev, Endpoint& ep, PollResult& r) {
+        if (!ep.link->connect()) {
+            int err = errno;
+            if (metrics != nullptr) PollMetrics::add(metrics->connect_failures);
+            connectFailed(ep, r);
+            r.status = "Błąd połączenia z " + endpointName(dev) + ": " + strerror(err) +
+                       " (próba " + std::to_string(ep.attempts) + ")";
+            return false;
+        }
+        if (metrics != nullptr) {
+            PollMetrics::add(metrics->connects);
+            if (ep.ever_connected) PollMetrics::add(metrics->reconnects);
+        }
+        ep.ever_connected = true;
+        ep.answered = false;
+        ep.last_answer = Clock::now();
+        // Po (ponownym) połączeniu wszystkie grupy - urządzenie mogło się zmienić
+        for (auto& other : devices) {
+            if (other.endpoint != dev.endpoint) continue;
+            other.groups.reset();
+            other.silent_polls = 0;
+        }
+        return true;
+    }
+
+    void readDevice(Device& dev, HuaweiSun2000& link, InverterSample& sample, PollResult& r) {
+        link.setSlave(dev.config.slave_id);
+        r.groups = dev.groups.due(Clock::now());
+        sample = dev.last;
+        r.ok = link.readInverterData(sample, r.groups);
+    }
+
+    static LinkHealth linkHealth(const Endpoint& ep, const PollResult& r, const InverterSample& sample) {
+        if (r.connected) return r.ok && sample.poll.failed_blocks == 0 ? LinkHealth::Healthy : LinkHealth::Degraded;
+        if (Clock::now() - ep.down_since >= std::chrono::seconds(LINK_OFFLINE_S)) return LinkHealth::Offline;
+        return ep.ever_connected ? LinkHealth::Reconnecting : LinkHealth::Connecting;
+    }
+
+    // Odczyt urządzenia; wywołujący trzyma ep.io
+    PollResult poll(Device& dev, Endpoint& ep, InverterSample& sample) {
+        PollResult r = pollLink(dev, ep, sample);
+        r.health = linkHealth(ep, r, sample);
+        r.attempts = ep.attempts;
+        return r;
+    }
+
+    PollResult pollLink(Device& dev, Endpoint& ep, InverterSample& sample) {
+        PollResult r;
+        HuaweiSun2000& link = *ep.link;
+        bool fresh = false;
+        if (!link.isConnected()) {
+            if (Clock::now() < ep.retry_at) {
+                r.status = "Ponowne łączenie z " + endpointName(dev) + " (próba " +
+                           std::to_string(ep.attempts + 1) + ")";
+                r.link_down = true;
+                r.retry_at = ep.retry_at;
+                return r;
+            }
+            r.attempted = true;
+            if (!connectEndpoint(dev, ep, r)) return r;
+            fresh = true;
+        }
+        r.attempted = true;
+        readDevice(dev, link, sample, r);
+        if (link.linkBroken() && !fresh) {
+            // Stare połączenie zerwane (zwykle restart bramki, która od razu przyjmuje
+            // nowe połączenia) - jedna próba od razu zamiast przerwy w danych
+            dropLink(ep);
+            if (!connectEndpoint(dev, ep, r)) return r;
+            fresh = true;
+            readDevice(dev, link, sample, r);
+        }
+        if (link.linkBroken()) {
+            // Zerwane tuż po nawiązaniu - bramka jeszcze nie gotowa
+            dropLink(ep);
+            connectFailed(ep, r);
+            r.ok = false;
+            r.status = "Połączenie zerwane: " + endpointName(dev);
+            return r;
+        }
+        if (!link.lastPollAnswered()) {
+            // Same timeouty: urządzenie milczy albo połączenie jest półotwarte (bramka
+            // zniknęła bez zamknięcia połączenia). Nowe połączenie tylko wtedy, gdy od
+            // początku ciszy nie odpowiedziało żadne urządzenie za bramką - wyłączony
+            // slave za wspólną bramką to błąd urządzenia z jego własnym wycofaniem
+            if (dev.silent_polls++ == 0) dev.silent_since = Clock::now();
+            if (dev.silent_polls >= LINK_SILENT_POLLS && ep.last_answer < dev.silent_since) {
+                bool answered = ep.answered;
+                dropLink(ep);
+                // Bramka przyjmuje połączenia, ale nic nie odpowiada - wycofanie jak przy
+                // nieudanym połączeniu zamiast łączenia w kółko
+                if (!answered) connectFailed(ep, r);
+                r.link_down = true;
+                r.retry_at = ep.retry_at;
+                r.status = "Brak odpowiedzi z " + endpointName(dev) + " - ponowne łączenie";
+                return r;
+            }
+        } else {
+            dev.silent_polls = 0;
+            ep.last_answer = Clock::now();
+            ep.answered = true;
+            ep.attempts = 0;
+        }
+        r.connected = true;
+        r.status = std::string(r.ok ? "Połączono z " : dev.silent_polls > 0 ? "Brak odpowiedzi z " :
+                               "Błąd odczytu z ") + endpointName(dev) + " (slave " +
+                   std::to_string(dev.config.slave_id) + ")";
+        return r;
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (queue.empty()) {
+                wake.wait(lock);
+                continue;
+            }
+            Due next = queue.top();
+            auto now = Clock::now();
+            if (now < next.at) {
+                wake.wait_until(lock, next.at);
+                continue;
+            }
+            queue.pop();
+            Device& dev = devices[next.device];
+            if (next.generation != dev.generation) continue;  // Zastąpiony przez odczyt na żądanie
+            Endpoint& ep = *endpoints[dev.endpoint];
+            std::unique_lock<std::mutex> io(ep.io, std::try_to_lock);
+            if (!io.owns_lock()) {
+                // Inny wątek rozmawia z tą bramką - spróbuj za chwilę zamiast blokować wątek
+                queue.push({now + std::chrono::milliseconds(BUSY_RETRY_MS), next.deadline, next.device,
+                            next.generation});
+                continue;
+            }
+            double lateness_ms = std::chrono::duration<double, std::milli>(now - next.at).count();
+            dev.in_flight = true;
+            if (dev.refresh_all) {
+                dev.groups.reset();
+                dev.refresh_all = false;
+            }
+            lock.unlock();
+
+            InverterSample sample;
+            PollResult r = poll(dev, ep, sample);
+            // Nowe terminy grup jeszcze pod io - connectEndpoint innego urządzenia za
+            // tą bramką zeruje grupy wszystkich jej urządzeń
+            if (r.ok) dev.groups.done(r.groups, Clock::now());
+            io.unlock();
+            if (r.attempted && on_sample) on_sample(next.device, sample, r.ok);
+
+            lock.lock();
+            DeviceStatus& st = dev.status;
+            st.connected = r.connected;
+            st.health = r.health;
+            st.reconnect_attempts = r.attempts;
+            snprintf(st.status, sizeof(st.status), "%s", r.status.c_str());
+            st.last_lateness_ms = lateness_ms;
+            if (r.attempted) {
+                st.polls++;
+                if (r.ok) {
+                    st.consecutive_failures = 0;
+                    st.last_ok_ms = sample.timestamp_ms;
+                } else {
+                    st.failures++;
+                    st.consecutive_failures++;
+                }
+            }
+            auto done = Clock::now();
+            int interval_s = dev.config.interval_s;
+            if (r.ok) {
+                // Udany odczyt: tryb (szybki / zwykły / nocny) z próbki
+                dev.last = sample;
+                interval_s = dev.adaptive.next(sample);
+                dev.device_failures = 0;
+            } else if (r.attempted) {
+                dev.adaptive.forget();
+                if (!r.link_down) dev.device_failures++;
+            }
+            // Wycofanie, gdy urządzenie nie odpowiada przy sprawnym połączeniu: interwał
+            // x2, x4, ... do MAX_BACKOFF_S. Brak połączenia ma własne wycofanie (retry_at)
+            if (dev.device_failures > 0 && !r.link_down) {
+                int shift = std::min(dev.device_failures, 10);
+                interval_s = std::min(MAX_BACKOFF_S, std::max(interval_s, interval_s << shift));
+            }
+            st.current_interval_s = interval_s;
+            st.mode = dev.adaptive.mode();
+            dev.published->store(st);
+
+            // Następny termin liczony od poprzedniego (bez dryfu); gdy odczyt się
+            // spóźnił o więcej niż interwał, liczymy od teraz
+            Clock::time_point deadline = next.deadline + std::chrono::seconds(interval_s);
+            if (deadline < done) deadline = done + std::chrono::seconds(interval_s);
+            Clock::time_point at = deadline + jitter(interval_s);
+            if (r.link_down) {
+                // Bez połączenia termin wyznacza wycofanie bramki (już z rozrzutem)
+                deadline = at = std::max(r.retry_at, done);
+            }
+            if (dev.poll_now) {
+                // Odczyt na żądanie przyszedł w trakcie - od razu następny
+                deadline = at = done;
+                dev.poll_now = false;
+            }
+            dev.in_flight = false;
+            queue.push({at, deadline, next.device, dev.generation});
+            wake.notify_one();
+            if (on_change) {
+                lock.unlock();
+                on_change(next.device);
+                lock.lock();
+            }
+        }
+    }
+
+public:
+    PollingEngine(const std::vector<DeviceConfig>& configs, int max_gap = REGISTER_PLAN_MAX_GAP,
+                  const ModbusLinkOptions& link_options = ModbusLinkOptions())
+        : metrics(link_options.metrics) {
+        for (const auto& cfg : configs) {
+            size_t ep = endpoints.size();
+            for (size_t i = 0; i < devices.size(); i++) {
+                if (devices[i].config.ip == cfg.ip && devices[i].config.port == cfg.port) {
+                    ep = devices[i].endpoint;
+                    break;
+                }
+            }
+            if (ep == endpoints.size()) {
+                endpoints.push_back(std::make_unique<Endpoint>());
+                endpoints.back()->link = std::make_unique<HuaweiSun2000>(cfg.ip, cfg.port, max_gap, cfg.slave_id,
+                                                                         link_options);
+                endpoints.back()->retry_interval_s = cfg.interval_s;
+            }
+            Endpoint& endpoint = *endpoints[ep];
+            endpoint.retry_interval_s = std::min(endpoint.retry_interval_s, cfg.interval_s);
+            devices.push_back(Device{cfg, ep, DeviceStatus{}, nullptr, GroupSchedule{},
+                                     AdaptiveInterval(cfg.interval_s, cfg.fast_interval_s, cfg.night_interval_s),
+                                     InverterSample{}, 0, false, false, false});
+            devices.back().status.current_interval_s = cfg.interval_s;
+            devices.back().published = std::make_unique<SeqlockSnapshot<DeviceStatus>>(devices.back().status);
+        }
+    }
+
+    ~PollingEngine() override { PollingEngine::stop(); }
+
+    PollingEngine(const PollingEngine&) = delete;
+    PollingEngine& operator=(const PollingEngine&) = delete;
+
+    // Uruchamia wątki robocze; pierwsze odczyty są rozłożone w czasie
+    void start(int worker_count, SampleCallback callback, ChangeCallback change = nullptr) override {
+        on_sample = std::move(callback);
+        on_change = std::move(change);
+        auto now = Clock::now();
+        for (auto& ep : endpoints) ep->down_since = now;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = false;
+            for (size_t i = 0; i < devices.size(); i++) {
+                auto offset = std::chrono::milliseconds(
+                    int64_t(devices[i].config.interval_s) * 1000 * int64_t(i) / int64_t(devices.size()));
+                queue.push({now + offset, now + offset, i, devices[i].generation});
+            }
+        }
+        int n = std::max(1, std::min(worker_count, int(devices.size())));
+        for (int i = 0; i < n; i++) workers.emplace_back([this] { workerLoop(); });
+    }
+
+    void stop() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        // Trwające odczyty kończą się od razu zamiast czekać na timeout
+        for (auto& ep : endpoints) ep->link->cancel();
+        for (auto& t : workers) t.join();
+        workers.clear();
+        for (auto& ep : endpoints) ep->link->disconnect();
+    }
+
+    // Odczyt urządzenia teraz, wszystkich grup rejestrów (klawisz 'r').
+    // Oczekujący termin przestaje obowiązywać; trwający odczyt kończy się normalnie,
+    // a następny startuje zaraz po nim. Połączenie w trakcie wycofania czeka dalej.
+    void pollNow(size_t device) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Device& dev = devices[device];
+            dev.refresh_all = true;
+            if (dev.in_flight) {
+                dev.poll_now = true;
+            } else {
+                dev.generation++;
+                auto now = Clock::now();
+                queue.push({now, now, device, dev.generation});
+            }
+        }
+        wake.notify_one();
+    }
+
+    size_t deviceCount() const override { return devices.size(); }
+    size_t endpointCount() const { return endpoints.size(); }
+    size_t workerCount() const { return workers.size(); }
+    const DeviceConfig& config(size_t device) const override { return devices[device].config; }
+
+    DeviceStatus status(size_t device, uint64_t* version = nullptr) const override {
+        DeviceStatus st;
+        uint64_t v = devices[device].published->load(st);
+        if (version != nullptr) *version = v;
+        return st;
+    }
+};
@@ -0,0 +1,174 @@
+#pragma once
+
+// Przyrostowy wykres mocy z bloków Unicode - gotowe wiersze tekstu,
+// bez zależności od FTXUI (interfejs tylko opakowuje wiersze w elementy).
+// Dla każdej kolumny pamiętany jest stos znaków (po jednym na wiersz).
+// Przy aktualizacji przeliczane są tylko kolumny, które się zmieniły
+// (zwykle najnowsza), a przesunięcie okna o kolumnę przesuwa zapamiętane
+// stosy zamiast liczyć je od nowa. Pełne przeskalowanie tylko przy zmianie
+// maksimum albo rozmiaru. Wiersze są składane w bufory o stałej pojemności.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "rollup.hpp"
+
+class PowerChart {
+public:
+    static constexpr int LABEL_SIZE = 16;
+
+private:
+    // Znaki wypełnienia komórki: pusta, 1/8, 1/4, 1/2, 3/4, pełna
+    static constexpr int GLYPH_COUNT = 6;
+    static const char* glyph(int g) {
+        static const char* const GLYPHS[GLYPH_COUNT] = {" ", "▏", "▎", "▌", "▊", "█"};
+        return GLYPHS[g];
+    }
+    static size_t glyphBytes(int g) { return g == 0 ? 1 : 3; }
+
+    int chart_width = 0;
+    int chart_height = 0;
+    int64_t origin = 0;               // Bezwzględny numer pierwszej kolumny
+    double max_power = 0.0;           // Skala osi Y
+    double data_max = 0.0;            // Maksimum danych w oknie
+    size_t total_samples = 0;
+    std::vector<ChartColumn> cols;    // Kolumny z ostatniej aktualizacji
+    std::vector<uint8_t> cells;       // Stosy znaków: cells[x * chart_height + y], y = 0 na dole
+    std::vector<std::string> rows;    // Od góry
+    std::vector<uint8_t> dirty;       // Wiersze do ponownego złożenia
+    std::vector<std::array<char, LABEL_SIZE>> labels;  // Etykiety osi Y (od góry)
+    std::string axis;
+
+    // Statystyki (do benchmarku): przeliczone kolumny i pełne przeskalowania
+    uint64_t columns_built = 0;
+    uint64_t rescales = 0;
+
+    // Znak komórki y dla słupka o wysokości level (w wierszach) - te same progi co dotychczasowy wykres
+    static int cellGlyph(double level, int y) {
+        double fill = level - y;
+        if (fill >= 1.0) return 5;
+        if (fill >= 0.75) return 4;
+        if (fill >= 0.5) return 3;
+        if (fill >= 0.25) return 2;
+        if (fill > 0.0) return 1;
+        return 0;
+    }
+
+    void buildColumn(int x) {
+        uint8_t* stack = &cells[size_t(x) * chart_height];
+        double level = cols[x].has_data ? double(cols[x].max) / max_power * chart_height : 0.0;
+        for (int y = 0; y < chart_height; y++) {
+            uint8_t g = uint8_t(cellGlyph(level, y));
+            if (stack[y] != g) {
+                stack[y] = g;
+                dirty[chart_height - 1 - y] = 1;
+            }
+        }
+        columns_built++;
+    }
+
+    void rescale() {
+        size_t cells_size = size_t(chart_width) * chart_height;
+        if (cells.size() != cells_size) cells.assign(cells_size, 0);
+        if (int(rows.size()) != chart_height) {
+            rows.resize(chart_height);
+            dirty.assign(chart_height, 1);
+            labels.resize(chart_height);
+        }
+        for (auto& r : rows) r.reserve(size_t(chart_width) * 3);  // Najdłuższy znak ma 3 bajty UTF-8
+        for (int x = 0; x < chart_width; x++) buildColumn(x);
+        std::fill(dirty.begin(), dirty.end(), 1);
+        for (int i = 0; i < chart_height; i++) {
+            double threshold = double(chart_height - i) / chart_height * max_power;
+            snprintf(labels[i].data(), LABEL_SIZE, "%6.0fW", threshold);
+        }
+        axis = "      └" + std::string(size_t(chart_width), '-') + "┘";
+        rescales++;
+    }
+
+    void composeRow(int i) {
+        std::string& r = rows[i];
+        r.clear();
+        int y = chart_height - 1 - i;
+        for (int x = 0; x < chart_width; x++) {
+            int g = cells[size_t(x) * chart_height + y];
+            r.append(glyph(g), glyphBytes(g));
+        }
+        dirty[i] = 0;
+    }
+
+public:
+    // Nowe kolumny okna zaczynającego się od kolumny first_column (numeracja bezwzględna,
+    // np. czas / szerokość kolumny). scale_max - najmniejsza skala osi Y (np. moc nominalna),
+    // dzięki której skala nie zmienia się z każdym nowym maksimum. Zwraca true, gdy zmienił
+    // się jakikolwiek wiersz.
+    bool update(const std::vector<ChartColumn>& columns, int height, int64_t first_column,
+                double scale_max = 0.0) {
+        int width = int(columns.size());
+        double peak = 0.0;
+        size_t samples = 0;
+        for (const auto& c : columns) {
+            if (!c.has_data) continue;
+            peak = std::max(peak, double(c.max));
+            samples += c.count;
+        }
+        double new_max = std::max(peak, scale_max);
+        if (new_max <= 0) new_max = 1.0;  // Unikaj dzielenia przez 0
+        data_max = peak;
+        total_samples = samples;
+
+        bool full = width != chart_width || height != chart_height || new_max != max_power;
+        int64_t shift = first_column - origin;
+        if (full || shift < 0 || shift >= width) {
+            chart_width = width;
+            chart_height = height;
+            max_power = new_max;
+            origin = first_column;
+            cols = columns;
+            rescale();
+        } else {
+            if (shift > 0) {
+                // Okno przesunęło się o kilka kolumn - przesuń zapamiętane stosy
+                size_t keep = size_t(width - shift);
+                std::move(cols.begin() + shift, cols.end(), cols.begin());
+                std::move(cells.begin() + shift * chart_height, cells.end(), cells.begin());
+                std::fill(cols.begin() + keep, cols.end(), ChartColumn{});
+                std::fill(cells.begin() + keep * chart_height, cells.end(), 0);
+                std::fill(dirty.begin(), dirty.end(), 1);
+                origin = first_column;
+            }
+            for (int x = 0; x < width; x++) {
+                const ChartColumn& c = columns[x];
+                if (c.has_data == cols[x].has_data && c.max == cols[x].max) {
+                    cols[x] = c;
+                    continue;
+                }
+                cols[x] = c;
+                buildColumn(x);
+            }
+        }
+        bool changed = false;
+        for (int i = 0; i < chart_height; i++) {
+            if (dirty[i]) {
+                composeRow(i);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    int width() const { return chart_width; }
+    int height() const { return chart_height; }
+    double maxPower() const { return max_power; }
+    double dataMaxPower() const { return data_max; }
+    size_t samples() const { return total_samples; }
+    const std::string& row(int i) const { return rows[i]; }       // i = 0 to górny wiersz
+    const char* label(int i) const { return labels[i].data(); }  // Etykieta osi Y wiersza i
+    const std::string& xAxis() const { return axis; }
+    uint64_t columnsBuilt() const { return columns_built; }
+    uint64_t rescaleCount() const { return rescales; }
+};
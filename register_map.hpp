@@ -0,0 +1,326 @@
+#pragma once
+
+// Deklaratywna mapa rejestrów Huawei SUN2000 (na podstawie
+// Huawei_SUN2000_Complete_Modbus_Map.md). Tabela jest constexpr, a dekodowanie
+// wszystkich pól generowane jest z niej w czasie kompilacji przez
+// specjalizacje RegDecoder - nowy rejestr to jedna linia w tabeli.
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "register_planner.hpp"
+
+enum class RegType : uint8_t { U16, I16, U32, I32, STR };
+
+// Grupy rejestrów (maska bitowa) - decydują o tym, co trafia do planu odczytu
+enum RegGroup : uint8_t {
+    REG_GROUP_IDENT   = 1 << 0,  // Identyfikacja (30000-30074)
+    REG_GROUP_POWER   = 1 << 1,  // PV, AC, stan pracy (32060-32090)
+    REG_GROUP_ENERGY  = 1 << 2,  // Liczniki energii (32106-32119)
+    REG_GROUP_ALARM   = 1 << 3,  // Statusy i alarmy bitowe (32002-32010)
+    REG_GROUP_MEASURE = 1 << 4,  // Izolacja, DC bus, jakość sieci (32100-32124)
+    REG_GROUP_STATS   = 1 << 5,  // Czasy pracy i maksima dzienne (32130-32144)
+    REG_GROUP_COMM    = 1 << 6,  // Łączność i optymalizatory (32180-32202)
+    REG_GROUP_CONFIG  = 1 << 7,  // Parametry nominalne (32400-32405)
+};
+
+// Grupy odczytywane cyklicznie (okresy poszczególnych grup - poll_scheduler.hpp)
+constexpr uint8_t REG_GROUPS_POLLED = REG_GROUP_POWER | REG_GROUP_ENERGY | REG_GROUP_ALARM |
+                                      REG_GROUP_MEASURE | REG_GROUP_STATS | REG_GROUP_COMM;
+
+// Identyfikatory pól - kolejność musi odpowiadać kolejności w REGISTER_MAP
+enum RegId : uint8_t {
+    // Identyfikacja
+    REG_MODEL, REG_SN, REG_FIRMWARE, REG_PRODUCTION_DATE, REG_EXTRA_INFO,
+    REG_DEVICE_TYPE, REG_RATED_POWER, REG_MAX_POWER, REG_PHASE_COUNT, REG_PV_STRING_COUNT,
+    // PV (DC)
+    REG_PV1_VOLTAGE, REG_PV2_VOLTAGE, REG_PV1_CURRENT, REG_PV2_CURRENT,
+    REG_INPUT_POWER, REG_PV2_POWER,
+    // AC
+    REG_PHASE_A_VOLTAGE, REG_PHASE_B_VOLTAGE, REG_PHASE_C_VOLTAGE,
+    REG_PHASE_A_CURRENT, REG_PHASE_B_CURRENT, REG_PHASE_C_CURRENT,
+    REG_PHASE_A_POWER, REG_ACTIVE_POWER, REG_REACTIVE_POWER, REG_POWER_FACTOR, REG_GRID_FREQUENCY,
+    // Stan i diagnostyka
+    REG_EFFICIENCY, REG_INTERNAL_TEMPERATURE, REG_HEATSINK_TEMPERATURE, REG_DEVICE_STATE, REG_FAULT_CODE,
+    // Statusy i alarmy bitowe
+    REG_STATE1, REG_STATE2, REG_STATE3, REG_ALARM1, REG_ALARM2, REG_ALARM3,
+    // Pomiary dodatkowe
+    REG_DC_BUS_VOLTAGE, REG_DC_BUS_CURRENT, REG_PV_POS_GROUND_VOLTAGE, REG_PV_NEG_GROUND_VOLTAGE,
+    REG_INSULATION_RESISTANCE, REG_LEAKAGE_CURRENT,
+    // Energia
+    REG_TOTAL_ENERGY, REG_DAILY_ENERGY, REG_MONTHLY_ENERGY, REG_YEARLY_ENERGY,
+    // Jakość sieci
+    REG_LINE_AB_VOLTAGE, REG_LINE_BC_VOLTAGE, REG_LINE_CA_VOLTAGE, REG_VOLTAGE_THD, REG_CURRENT_THD,
+    // Statystyki
+    REG_TOTAL_RUN_HOURS, REG_RUN_MINUTES_TODAY, REG_STARTS_TODAY, REG_TOTAL_STARTS,
+    REG_PEAK_POWER_TODAY, REG_PEAK_TEMPERATURE_TODAY, REG_PEAK_PV_VOLTAGE_TODAY, REG_PEAK_PV_CURRENT_TODAY,
+    // Komunikacja
+    REG_WIFI_STATUS, REG_WIFI_SIGNAL, REG_ETHERNET_STATUS, REG_RS485_STATUS, REG_CLOUD_STATUS,
+    REG_CLOUD_CONNECTIONS, REG_LAST_CLOUD_CONNECTION,
+    REG_OPTIMIZER_COUNT, REG_OPTIMIZERS_ONLINE, REG_OPTIMIZERS_ALARM,
+    // Konfiguracja
+    REG_NOMINAL_AC_VOLTAGE, REG_NOMINAL_FREQUENCY, REG_MAX_PV_VOLTAGE, REG_MIN_PV_VOLTAGE,
+    REG_MAX_PV_CURRENT, REG_NOMINAL_POWER,
+    REG_COUNT
+};
+
+struct RegisterDesc {
+    RegId id;
+    uint16_t address;
+    uint8_t words;       // Liczba rejestrów 16-bit
+    RegType type;
+    uint16_t divider;    // Dzielnik skali (wartość = surowa / dzielnik)
+    uint8_t decimals;    // Miejsca po przecinku w wyjściu (0 = liczba całkowita)
+    uint8_t group;
+    const char* key;     // Klucz w wyjściu JSON
+    const char* unit;
+};
+
+// Uwagi do tabeli:
+// - 32064 to jednocześnie moc PV1 i całkowita moc wejściowa - w tabeli jako moc wejściowa
+// - temperatury i sygnał WiFi są ze znakiem (zakres od -40°C / -100 dBm)
+inline constexpr RegisterDesc REGISTER_MAP[] = {
+    // id                          adres  sł  typ           dziel. dec grupa              klucz JSON                     jednostka
+    {REG_MODEL,                    30000, 15, RegType::STR,    1, 0, REG_GROUP_IDENT,   "model",                       ""},
+    {REG_SN,                       30015, 10, RegType::STR,    1, 0, REG_GROUP_IDENT,   "sn",                          ""},
+    {REG_FIRMWARE,                 30025,  5, RegType::STR,    1, 0, REG_GROUP_IDENT,   "firmware_version",            ""},
+    {REG_PRODUCTION_DATE,          30030,  5, RegType::STR,    1, 0, REG_GROUP_IDENT,   "production_date",             ""},
+    {REG_EXTRA_INFO,               30035, 15, RegType::STR,    1, 0, REG_GROUP_IDENT,   "extra_info",                  ""},
+    {REG_DEVICE_TYPE,              30070,  1, RegType::U16,    1, 0, REG_GROUP_IDENT,   "device_type",                 ""},
+    {REG_RATED_POWER,              30071,  1, RegType::U16,    1, 0, REG_GROUP_IDENT,   "rated_power",                 "W"},
+    {REG_MAX_POWER,                30072,  1, RegType::U16,    1, 0, REG_GROUP_IDENT,   "max_power",                   "W"},
+    {REG_PHASE_COUNT,              30073,  1, RegType::U16,    1, 0, REG_GROUP_IDENT,   "phase_count",                 ""},
+    {REG_PV_STRING_COUNT,          30074,  1, RegType::U16,    1, 0, REG_GROUP_IDENT,   "pv_string_count",             ""},
+
+    {REG_PV1_VOLTAGE,              32060,  1, RegType::U16,   10, 1, REG_GROUP_POWER,   "pv1_voltage",                 "V"},
+    {REG_PV2_VOLTAGE,              32061,  1, RegType::U16,   10, 1, REG_GROUP_POWER,   "pv2_voltage",                 "V"},
+    {REG_PV1_CURRENT,              32062,  1, RegType::U16,  100, 2, REG_GROUP_POWER,   "pv1_current",                 "A"},
+    {REG_PV2_CURRENT,              32063,  1, RegType::U16,  100, 2, REG_GROUP_POWER,   "pv2_current",                 "A"},
+    {REG_INPUT_POWER,              32064,  2, RegType::U32,    1, 1, REG_GROUP_POWER,   "input_power",                 "W"},
+    {REG_PV2_POWER,                32066,  2, RegType::U32,    1, 1, REG_GROUP_POWER,   "pv2_power",                   "W"},
+
+    {REG_PHASE_A_VOLTAGE,          32069,  1, RegType::U16,   10, 1, REG_GROUP_POWER,   "phase_A_voltage",             "V"},
+    {REG_PHASE_B_VOLTAGE,          32070,  1, RegType::U16,   10, 1, REG_GROUP_POWER,   "phase_B_voltage",             "V"},
+    {REG_PHASE_C_VOLTAGE,          32071,  1, RegType::U16,   10, 1, REG_GROUP_POWER,   "phase_C_voltage",             "V"},
+    {REG_PHASE_A_CURRENT,          32072,  2, RegType::I32, 1000, 2, REG_GROUP_POWER,   "phase_A_current",             "A"},
+    {REG_PHASE_B_CURRENT,          32074,  2, RegType::I32, 1000, 2, REG_GROUP_POWER,   "phase_B_current",             "A"},
+    {REG_PHASE_C_CURRENT,          32076,  2, RegType::I32, 1000, 2, REG_GROUP_POWER,   "phase_C_current",             "A"},
+    {REG_PHASE_A_POWER,            32078,  2, RegType::U32,    1, 1, REG_GROUP_POWER,   "phase_A_power",               "W"},
+    {REG_ACTIVE_POWER,             32080,  2, RegType::U32,    1, 1, REG_GROUP_POWER,   "active_power",                "W"},
+    {REG_REACTIVE_POWER,           32082,  2, RegType::I32,    1, 1, REG_GROUP_POWER,   "reactive_power",              "var"},
+    {REG_POWER_FACTOR,             32084,  1, RegType::U16, 1000, 3, REG_GROUP_POWER,   "power_factor",                ""},
+    {REG_GRID_FREQUENCY,           32085,  1, RegType::U16,  100, 2, REG_GROUP_POWER,   "grid_frequency",              "Hz"},
+
+    {REG_EFFICIENCY,               32086,  1, RegType::U16,  100, 2, REG_GROUP_POWER,   "efficiency",                  "%"},
+    {REG_INTERNAL_TEMPERATURE,     32087,  1, RegType::I16,   10, 1, REG_GROUP_POWER,   "internal_temperature",        "°C"},
+    {REG_HEATSINK_TEMPERATURE,     32088,  1, RegType::I16,   10, 1, REG_GROUP_POWER,   "heatsink_temperature",        "°C"},
+    {REG_DEVICE_STATE,             32089,  1, RegType::U16,    1, 0, REG_GROUP_POWER,   "device_state",                ""},
+    {REG_FAULT_CODE,               32090,  1, RegType::U16,    1, 0, REG_GROUP_POWER,   "fault_code",                  ""},
+
+    {REG_STATE1,                   32002,  1, RegType::U16,    1, 0, REG_GROUP_ALARM,   "state1",                      ""},
+    {REG_STATE2,                   32003,  1, RegType::U16,    1, 0, REG_GROUP_ALARM,   "state2",                      ""},
+    {REG_STATE3,                   32004,  1, RegType::U16,    1, 0, REG_GROUP_ALARM,   "state3",                      ""},
+    {REG_ALARM1,                   32008,  1, RegType::U16,    1, 0, REG_GROUP_ALARM,   "alarm1",                      ""},
+    {REG_ALARM2,                   32009,  1, RegType::U16,    1, 0, REG_GROUP_ALARM,   "alarm2",                      ""},
+    {REG_ALARM3,                   32010,  1, RegType::U16,    1, 0, REG_GROUP_ALARM,   "alarm3",                      ""},
+
+    {REG_DC_BUS_VOLTAGE,           32100,  1, RegType::U16,   10, 1, REG_GROUP_MEASURE, "dc_bus_voltage",              "V"},
+    {REG_DC_BUS_CURRENT,           32101,  1, RegType::U16,  100, 2, REG_GROUP_MEASURE, "dc_bus_current",              "A"},
+    {REG_PV_POS_GROUND_VOLTAGE,    32102,  1, RegType::U16,    1, 0, REG_GROUP_MEASURE, "pv_pos_ground_voltage",       "V"},
+    {REG_PV_NEG_GROUND_VOLTAGE,    32103,  1, RegType::U16,    1, 0, REG_GROUP_MEASURE, "pv_neg_ground_voltage",       "V"},
+    {REG_INSULATION_RESISTANCE,    32104,  1, RegType::U16,    1, 0, REG_GROUP_MEASURE, "insulation_resistance",       "kΩ"},
+    {REG_LEAKAGE_CURRENT,          32105,  1, RegType::U16, 1000, 3, REG_GROUP_MEASURE, "leakage_current",             "A"},
+
+    {REG_TOTAL_ENERGY,             32106,  2, RegType::U32,  100, 2, REG_GROUP_ENERGY,  "accumulated_energy_yield",    "kWh"},
+    {REG_DAILY_ENERGY,             32114,  2, RegType::U32,  100, 2, REG_GROUP_ENERGY,  "daily_yield_energy",          "kWh"},
+    {REG_MONTHLY_ENERGY,           32116,  2, RegType::U32,  100, 2, REG_GROUP_ENERGY,  "monthly_yield_energy",        "kWh"},
+    {REG_YEARLY_ENERGY,            32118,  2, RegType::U32,  100, 2, REG_GROUP_ENERGY,  "yearly_yield_energy",         "kWh"},
+
+    {REG_LINE_AB_VOLTAGE,          32120,  1, RegType::U16,   10, 1, REG_GROUP_MEASURE, "line_AB_voltage",             "V"},
+    {REG_LINE_BC_VOLTAGE,          32121,  1, RegType::U16,   10, 1, REG_GROUP_MEASURE, "line_BC_voltage",             "V"},
+    {REG_LINE_CA_VOLTAGE,          32122,  1, RegType::U16,   10, 1, REG_GROUP_MEASURE, "line_CA_voltage",             "V"},
+    {REG_VOLTAGE_THD,              32123,  1, RegType::U16,  100, 2, REG_GROUP_MEASURE, "voltage_thd",                 "%"},
+    {REG_CURRENT_THD,              32124,  1, RegType::U16,  100, 2, REG_GROUP_MEASURE, "current_thd",                 "%"},
+
+    {REG_TOTAL_RUN_HOURS,          32130,  2, RegType::U32,    1, 0, REG_GROUP_STATS,   "total_run_hours",             "h"},
+    {REG_RUN_MINUTES_TODAY,        32132,  2, RegType::U32,    1, 0, REG_GROUP_STATS,   "run_minutes_today",           "min"},
+    {REG_STARTS_TODAY,             32134,  1, RegType::U16,    1, 0, REG_GROUP_STATS,   "starts_today",                ""},
+    {REG_TOTAL_STARTS,             32135,  2, RegType::U32,    1, 0, REG_GROUP_STATS,   "total_starts",                ""},
+    {REG_PEAK_POWER_TODAY,         32140,  2, RegType::U32,    1, 0, REG_GROUP_STATS,   "peak_power_today",            "W"},
+    {REG_PEAK_TEMPERATURE_TODAY,   32142,  1, RegType::I16,   10, 1, REG_GROUP_STATS,   "peak_temperature_today",      "°C"},
+    {REG_PEAK_PV_VOLTAGE_TODAY,    32143,  1, RegType::U16,   10, 1, REG_GROUP_STATS,   "peak_pv_voltage_today",       "V"},
+    {REG_PEAK_PV_CURRENT_TODAY,    32144,  1, RegType::U16,  100, 2, REG_GROUP_STATS,   "peak_pv_current_today",       "A"},
+
+    {REG_WIFI_STATUS,              32180,  1, RegType::U16,    1, 0, REG_GROUP_COMM,    "wifi_status",                 ""},
+    {REG_WIFI_SIGNAL,              32181,  1, RegType::I16,    1, 0, REG_GROUP_COMM,    "wifi_signal_dbm",             "dBm"},
+    {REG_ETHERNET_STATUS,          32182,  1, RegType::U16,    1, 0, REG_GROUP_COMM,    "ethernet_status",             ""},
+    {REG_RS485_STATUS,             32183,  1, RegType::U16,    1, 0, REG_GROUP_COMM,    "rs485_status",                ""},
+    {REG_CLOUD_STATUS,             32184,  1, RegType::U16,    1, 0, REG_GROUP_COMM,    "cloud_status",                ""},
+    {REG_CLOUD_CONNECTIONS,        32185,  2, RegType::U32,    1, 0, REG_GROUP_COMM,    "cloud_connections",           ""},
+    {REG_LAST_CLOUD_CONNECTION,    32187,  2, RegType::U32,    1, 0, REG_GROUP_COMM,    "last_cloud_connection",       "s"},
+    {REG_OPTIMIZER_COUNT,          32200,  1, RegType::U16,    1, 0, REG_GROUP_COMM,    "optimizer_count",             ""},
+    {REG_OPTIMIZERS_ONLINE,        32201,  1, RegType::U16,    1, 0, REG_GROUP_COMM,    "optimizers_online",           ""},
+    {REG_OPTIMIZERS_ALARM,         32202,  1, RegType::U16,    1, 0, REG_GROUP_COMM,    "optimizers_alarm",            ""},
+
+    {REG_NOMINAL_AC_VOLTAGE,       32400,  1, RegType::U16,    1, 0, REG_GROUP_CONFIG,  "nominal_ac_voltage",          "V"},
+    {REG_NOMINAL_FREQUENCY,        32401,  1, RegType::U16,    1, 0, REG_GROUP_CONFIG,  "nominal_frequency",           "Hz"},
+    {REG_MAX_PV_VOLTAGE,           32402,  1, RegType::U16,    1, 0, REG_GROUP_CONFIG,  "max_pv_voltage",              "V"},
+    {REG_MIN_PV_VOLTAGE,           32403,  1, RegType::U16,    1, 0, REG_GROUP_CONFIG,  "min_pv_voltage",              "V"},
+    {REG_MAX_PV_CURRENT,           32404,  1, RegType::U16,    1, 0, REG_GROUP_CONFIG,  "max_pv_current",              "A"},
+    {REG_NOMINAL_POWER,            32405,  1, RegType::U16,    1, 0, REG_GROUP_CONFIG,  "nominal_power",               "W"},
+};
+
+constexpr bool registerMapConsistent() {
+    if (sizeof(REGISTER_MAP) / sizeof(REGISTER_MAP[0]) != REG_COUNT) return false;
+    for (size_t i = 0; i < REG_COUNT; i++) {
+        const RegisterDesc& d = REGISTER_MAP[i];
+        if (d.id != i || d.divider == 0) return false;
+        if (d.type == RegType::U32 || d.type == RegType::I32) { if (d.words != 2) return false; }
+        else if (d.type != RegType::STR && d.words != 1) return false;
+    }
+    return true;
+}
+static_assert(registerMapConsistent(), "REGISTER_MAP niezgodna z RegId");
+
+// --- Dekodery specjalizowane typem rejestru ---
+// raw()   - złożenie słów Modbus w 32-bitowy wzorzec bitowy
+// value() - interpretacja wzorca zgodnie ze znakiem typu
+
+template <RegType T> struct RegDecoder;
+
+template <> struct RegDecoder<RegType::U16> {
+    static uint32_t raw(const uint16_t* w) { return w[0]; }
+    static double value(uint32_t r) { return double(uint16_t(r)); }
+};
+
+template <> struct RegDecoder<RegType::I16> {
+    static uint32_t raw(const uint16_t* w) { return w[0]; }
+    static double value(uint32_t r) { return double(int16_t(uint16_t(r))); }
+};
+
+template <> struct RegDecoder<RegType::U32> {
+    static uint32_t raw(const uint16_t* w) { return (uint32_t(w[0]) << 16) | w[1]; }
+    static double value(uint32_t r) { return double(r); }
+};
+
+template <> struct RegDecoder<RegType::I32> {
+    static uint32_t raw(const uint16_t* w) { return (uint32_t(w[0]) << 16) | w[1]; }
+    static double value(uint32_t r) { return double(int32_t(r)); }
+};
+
+// Rejestry tekstowe: dwa znaki ASCII na rejestr, dopełnienie zerami/spacjami
+template <> struct RegDecoder<RegType::STR> {
+    static uint32_t raw(const uint16_t*) { return 0; }
+    static double value(uint32_t) { return 0.0; }
+    static size_t text(const uint16_t* w, int words, char* out, size_t out_size) {
+        size_t n = 0;
+        for (int i = 0; i < words && n + 1 < out_size; i++) {
+            char hi = char(w[i] >> 8), lo = char(w[i] & 0xFF);
+            if (hi == 0) break;
+            out[n++] = hi;
+            if (lo == 0 || n + 1 >= out_size) break;
+            out[n++] = lo;
+        }
+        while (n > 0 && out[n - 1] == ' ') n--;
+        out[n] = 0;
+        return n;
+    }
+};
+
+// Wartość w jednostkach fizycznych z surowego wzorca (rozgałęzienie po typie z tabeli)
+inline double regScaled(RegId id, uint32_t raw) {
+    const RegisterDesc& d = REGISTER_MAP[id];
+    double v = 0.0;
+    switch (d.type) {
+        case RegType::U16: v = RegDecoder<RegType::U16>::value(raw); break;
+        case RegType::I16: v = RegDecoder<RegType::I16>::value(raw); break;
+        case RegType::U32: v = RegDecoder<RegType::U32>::value(raw); break;
+        case RegType::I32: v = RegDecoder<RegType::I32>::value(raw); break;
+        case RegType::STR: break;
+    }
+    return d.divider == 1 ? v : v / d.divider;
+}
+
+// Wersja dla pola znanego w czasie kompilacji - bez rozgałęzień
+template <RegId ID>
+inline double regScaled(uint32_t raw) {
+    constexpr RegisterDesc d = REGISTER_MAP[ID];
+    double v = RegDecoder<d.type>::value(raw);
+    if constexpr (d.divider == 1) return v;
+    else return v / d.divider;
+}
+
+// Zdekodowane wartości wszystkich pól numerycznych (surowe wzorce + maska ważności)
+struct RegisterValues {
+    uint32_t raw[REG_COUNT] = {};
+    std::bitset<REG_COUNT> valid;
+
+    double value(RegId id) const { return regScaled(id, raw[id]); }
+    template <RegId ID> double get() const { return regScaled<ID>(raw[ID]); }
+    bool has(RegId id) const { return valid.test(id); }
+};
+
+// Dodaje do planu wszystkie rejestry z wybranych grup
+inline void planRegisterGroups(RegisterPlan& plan, uint8_t group_mask) {
+    for (const auto& d : REGISTER_MAP) {
+        if (d.group & group_mask) plan.want(d.address, d.words);
+    }
+}
+
+// Dekoder całej tabeli ze wspólnego bufora planu. Położenie pól w buforze
+// wyznaczane jest raz (bind), a samo dekodowanie jest rozwijane w czasie
+// kompilacji - każde pole ma własną, wyspecjalizowaną instrukcję odczytu.
+// Pola spoza planu nie są zmieniane, więc odczyt części grup uzupełnia
+// poprzednią próbkę.
+class RegisterDecoder {
+private:
+    struct FieldLocation {
+        int32_t block = -1;
+        uint32_t offset = 0;
+    };
+    FieldLocation locations[REG_COUNT];
+
+    template <size_t I>
+    void decodeField(const RegisterPlan& plan, RegisterValues& out) const {
+        constexpr RegisterDesc d = REGISTER_MAP[I];
+        if constexpr (d.type == RegType::STR) {
+            return;
+        } else {
+            const FieldLocation& loc = locations[I];
+            if (loc.block < 0) return;  // Pole spoza planu - zostaje poprzednia wartość
+            bool ok = plan.blocks()[loc.block].ok;
+            out.raw[I] = ok ? RegDecoder<d.type>::raw(plan.data() + loc.offset) : 0;
+            out.valid.set(I, ok);
+        }
+    }
+
+    template <size_t... I>
+    void decodeAll(const RegisterPlan& plan, RegisterValues& out, std::index_sequence<I...>) const {
+        (decodeField<I>(plan, out), ...);
+    }
+
+public:
+    // Wiąże pola tabeli z blokami zbudowanego planu
+    void bind(const RegisterPlan& plan) {
+        for (size_t i = 0; i < REG_COUNT; i++) {
+            const RegisterDesc& d = REGISTER_MAP[i];
+            locations[i].block = plan.locate(d.address, d.words, locations[i].offset);
+        }
+    }
+
+    void decode(const RegisterPlan& plan, RegisterValues& out) const {
+        decodeAll(plan, out, std::make_index_sequence<REG_COUNT>{});
+    }
+
+    // Odczyt pola tekstowego (identyfikacja)
+    size_t decodeText(const RegisterPlan& plan, RegId id, char* out, size_t out_size) const {
+        const FieldLocation& loc = locations[id];
+        if (loc.block < 0 || !plan.blocks()[loc.block].ok) {
+            if (out_size > 0) out[0] = 0;
+            return 0;
+        }
+        return RegDecoder<RegType::STR>::text(plan.data() + loc.offset, REGISTER_MAP[id].words, out, out_size);
+    }
+};
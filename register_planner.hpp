@@ -0,0 +1,134 @@
+#pragma once
+
+// Planer odczytu rejestrów Modbus.
+// Przyjmuje deklaratywną listę potrzebnych rejestrów, scala je w jak najmniejszą
+// liczbę ciągłych bloków (limit 125 rejestrów na zapytanie 0x03) i udostępnia
+// dekodowanie wszystkich pól ze wspólnego bufora.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Limit rejestrów w jednym zapytaniu Read Holding Registers (specyfikacja Modbus)
+constexpr int MODBUS_BLOCK_MAX_REGISTERS = 125;
+
+// Domyślna maksymalna przerwa (w rejestrach) pomiędzy zakresami, które wolno
+// odczytać jednym zapytaniem. Odczyt kilkunastu zbędnych rejestrów jest dużo
+// tańszy niż dodatkowa wymiana przez dongle WiFi.
+constexpr int REGISTER_PLAN_MAX_GAP = 16;
+
+// Pojedynczy ciągły blok do odczytu jednym zapytaniem
+struct RegisterBlock {
+    uint16_t start = 0;
+    uint16_t count = 0;
+    uint32_t offset = 0;  // Pozycja bloku we wspólnym buforze
+    bool ok = false;      // Czy ostatni odczyt bloku się powiódł
+};
+
+// Statystyki jednego cyklu odczytu
+struct PollStats {
+    int round_trips = 0;     // Liczba zapytań Modbus
+    int failed_blocks = 0;   // Liczba bloków, których nie udało się odczytać
+    int registers = 0;       // Łączna liczba odczytanych rejestrów
+    double wall_ms = 0.0;    // Czas trwania całego odczytu
+};
+
+class RegisterPlan {
+private:
+    struct Span {
+        uint16_t address;
+        uint16_t count;
+    };
+
+    std::vector<Span> wanted;
+    std::vector<RegisterBlock> plan_blocks;
+    std::vector<uint16_t> words;
+    bool built = false;
+
+    const RegisterBlock* findBlock(uint16_t address, uint16_t count) const {
+        // Bloków jest kilka, wyszukiwanie binarne po adresie początkowym
+        auto it = std::upper_bound(plan_blocks.begin(), plan_blocks.end(), address,
+            [](uint16_t a, const RegisterBlock& b) { return a < b.start; });
+        if (it == plan_blocks.begin()) return nullptr;
+        --it;
+        if (uint32_t(address) + count > uint32_t(it->start) + it->count) return nullptr;
+        return &*it;
+    }
+
+public:
+    // Dodaje zakres rejestrów potrzebny do dekodowania
+    void want(uint16_t address, uint16_t count = 1) {
+        wanted.push_back({address, count});
+        built = false;
+    }
+
+    // Scala zakresy w bloki: sortuje, łączy nakładające się i bliskie (przerwa <= max_gap)
+    // zakresy, pilnując limitu długości pojedynczego zapytania.
+    void build(int max_gap = REGISTER_PLAN_MAX_GAP) {
+        std::vector<Span> spans = wanted;
+        std::sort(spans.begin(), spans.end(),
+            [](const Span& a, const Span& b) { return a.address < b.address; });
+
+        plan_blocks.clear();
+        for (const auto& s : spans) {
+            uint32_t s_end = uint32_t(s.address) + s.count;
+            if (!plan_blocks.empty()) {
+                RegisterBlock& last = plan_blocks.back();
+                uint32_t last_end = uint32_t(last.start) + last.count;
+                uint32_t merged_end = std::max(last_end, s_end);
+                bool close_enough = s.address <= last_end + uint32_t(max_gap);
+                if (close_enough && merged_end - last.start <= uint32_t(MODBUS_BLOCK_MAX_REGISTERS)) {
+                    last.count = uint16_t(merged_end - last.start);
+                    continue;
+                }
+            }
+            plan_blocks.push_back({s.address, s.count, 0, false});
+        }
+
+        uint32_t offset = 0;
+        for (auto& b : plan_blocks) {
+            b.offset = offset;
+            offset += b.count;
+        }
+        words.assign(offset, 0);
+        built = true;
+    }
+
+    bool isBuilt() const { return built; }
+    std::vector<RegisterBlock>& blocks() { return plan_blocks; }
+    const std::vector<RegisterBlock>& blocks() const { return plan_blocks; }
+
+    // Miejsce w buforze, do którego trafia odczyt danego bloku
+    uint16_t* blockData(const RegisterBlock& b) { return words.data() + b.offset; }
+    const uint16_t* data() const { return words.data(); }
+
+    // Indeks bloku zawierającego zakres (lub -1) oraz pozycja zakresu w buforze
+    int locate(uint16_t address, uint16_t count, uint32_t& offset) const {
+        const RegisterBlock* b = findBlock(address, count);
+        if (b == nullptr) return -1;
+        offset = b->offset + (address - b->start);
+        return int(b - plan_blocks.data());
+    }
+
+    // Czy rejestr został poprawnie odczytany w ostatnim cyklu
+    bool valid(uint16_t address, uint16_t count = 1) const {
+        const RegisterBlock* b = findBlock(address, count);
+        return b != nullptr && b->ok;
+    }
+
+    uint16_t u16(uint16_t address) const {
+        const RegisterBlock* b = findBlock(address, 1);
+        if (b == nullptr) return 0;
+        return words[b->offset + (address - b->start)];
+    }
+
+    // Wartości 32-bitowe zapisane są big endian (starsze słowo pierwsze)
+    uint32_t u32(uint16_t address) const {
+        const RegisterBlock* b = findBlock(address, 2);
+        if (b == nullptr) return 0;
+        const uint16_t* w = words.data() + b->offset + (address - b->start);
+        return (uint32_t(w[0]) << 16) | w[1];
+    }
+
+    int32_t i32(uint16_t address) const { return int32_t(u32(address)); }
+};
@@ -0,0 +1,302 @@
+#pragma once
+
+// Odtwarzanie zapisanych próbek przez ten sam potok co odczyt na żywo
+// (bilans energii, publikacja, historia, interfejs, HTTP). Źródłem jest plik
+// historii (TimeSeriesStore, jedno urządzenie) albo zapis ramek Modbus
+// (--capture, wiele urządzeń rozpoznawanych po adresie), dekodowany tak jak
+// odpowiedzi z urządzenia.
+//
+// Tempo: speed = 1 - czas rzeczywisty, speed = 1000 - tysiąc razy szybciej,
+// speed = 0 - bez czekania (przepustowość potoku). Terminy kolejnych próbek
+// liczone są od startu odtwarzania, więc czas obsługi próbki nie kumuluje
+// opóźnienia. Jeden wątek podaje próbki w kolejności zapisu - wyniki są
+// powtarzalne niezależnie od tempa.
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_capture.hpp"
+#include "sample_source.hpp"
+#include "snapshot.hpp"
+#include "timeseries_store.hpp"
+
+struct ReplayOptions {
+    double speed = 1.0;  // Krotność czasu rzeczywistego (0 - bez czekania)
+};
+
+class ReplaySource : public SampleSource {
+public:
+    // Wywoływane z wątku odtwarzania po ostatniej próbce
+    using FinishCallback = std::function<void()>;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Device {
+        DeviceConfig config;
+        DeviceStatus status;  // Tylko wątek odtwarzania
+        std::unique_ptr<SeqlockSnapshot<DeviceStatus>> published;
+        CaptureDecoder decoder;
+        InverterSample last;  // Pola grup pominiętych w ramce
+        int64_t last_timestamp_ms = 0;
+        uint16_t port = 0;
+        uint8_t slave = 0;
+        char host[sizeof(CaptureFrameHeader::host)] = "";
+    };
+
+    ReplayOptions options;
+    std::vector<Device> devices;
+    CaptureReader capture;
+    TimeSeriesStore history;
+    bool from_capture = false;
+    size_t total = 0;
+    int64_t first_timestamp_ms = 0;
+    std::string error;
+
+    SampleCallback on_sample;
+    ChangeCallback on_change;
+    FinishCallback on_finish;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool skip_wait = false;
+    Clock::time_point started{};
+    Clock::time_point pace_start{};  // Start osi czasu (przesuwany przez 'r'), pod mutex
+    Clock::time_point finished_at{};
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<int64_t> clock_ms{0};
+
+    void addDevice(const std::string& name, const char* host, uint16_t port, uint8_t slave) {
+        devices.emplace_back();
+        Device& dev = devices.back();
+        dev.config.name = name;
+        dev.config.ip = host;
+        dev.config.port = port;
+        dev.config.slave_id = slave;
+        dev.port = port;
+        dev.slave = slave;
+        snprintf(dev.host, sizeof(dev.host), "%s", host);
+        snprintf(dev.status.status, sizeof(dev.status.status), "Odtwarzanie: oczekiwanie");
+        dev.published = std::make_unique<SeqlockSnapshot<DeviceStatus>>(dev.status);
+    }
+
+    size_t deviceFor(const CaptureFrameHeader& h) const {
+        for (size_t i = 0; i < devices.size(); i++) {
+            const Device& dev = devices[i];
+            if (dev.port == h.port && dev.slave == h.slave && strncmp(dev.host, h.host, sizeof(dev.host)) == 0) {
+                return i;
+            }
+        }
+        return devices.size();
+    }
+
+    // Czeka do terminu próbki; false, gdy odtwarzanie zatrzymano
+    bool waitFor(int64_t timestamp_ms) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (options.speed > 0) {
+            double offset_ms = double(timestamp_ms - first_timestamp_ms) / options.speed;
+            auto due = pace_start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(offset_ms));
+            wake.wait_until(lock, due, [this] { return stopping || skip_wait; });
+            if (skip_wait) {
+                // 'r' - ta próbka od razu, kolejne w tym samym tempie od teraz
+                auto now = Clock::now();
+                if (due > now) pace_start -= due - now;
+                skip_wait = false;
+            }
+        }
+        return !stopping;
+    }
+
+    void deliver(size_t index, size_t position, const InverterSample& sample, bool ok) {
+        Device& dev = devices[index];
+        if (on_sample) on_sample(index, sample, ok);
+        DeviceStatus& st = dev.status;
+        st.connected = true;
+        st.health = ok && sample.poll.failed_blocks == 0 ? LinkHealth::Healthy : LinkHealth::Degraded;
+        st.polls++;
+        if (ok) {
+            st.consecutive_failures = 0;
+            st.last_ok_ms = sample.timestamp_ms;
+        } else {
+            st.failures++;
+            st.consecutive_failures++;
+        }
+        // Interwał zapisu zamiast interwału odczytu
+        if (dev.last_timestamp_ms > 0 && sample.timestamp_ms > dev.last_timestamp_ms) {
+            st.current_interval_s = int((sample.timestamp_ms - dev.last_timestamp_ms + 500) / 1000);
+        }
+        dev.last_timestamp_ms = sample.timestamp_ms;
+        snprintf(st.status, sizeof(st.status), "Odtwarzanie %zu/%zu", position + 1, total);
+        dev.published->store(st);
+        clock_ms.store(sample.timestamp_ms, std::memory_order_relaxed);
+        delivered.fetch_add(1, std::memory_order_relaxed);
+        if (on_change) on_change(index);
+    }
+
+    void replayCapture() {
+        size_t offset = CaptureReader::firstFrame();
+        CaptureFrame frame;
+        for (size_t position = 0; capture.next(offset, frame); position++) {
+            size_t index = deviceFor(frame.header);
+            if (index == devices.size()) continue;
+            if (!waitFor(frame.header.timestamp_ms)) return;
+            Device& dev = devices[index];
+            InverterSample sample = dev.last;
+            bool ok = dev.decoder.decode(frame, sample);
+            if (ok) dev.last = sample;
+            deliver(index, position, sample, ok);
+        }
+    }
+
+    void replayHistory() {
+        InverterSample sample;
+        for (size_t i = 0; i < history.size(); i++) {
+            const TimeSeriesRecord& rec = history.at(i);
+            if (!rec.intact()) continue;
+            if (!waitFor(rec.timestamp_ms)) return;
+            rec.toSample(sample);
+            // Historia nie przechowuje tekstów identyfikacji - tylko parametry nominalne
+            if (sample.device == &UNKNOWN_DEVICE && sample.regs.valid.test(REG_RATED_POWER)) {
+                DeviceDescriptor d;
+                fillDescriptorValues(d, sample.regs);
+                sample.device = DescriptorRegistry::instance().intern(d);
+            }
+            deliver(0, i, sample, sample.regs.valid.any());
+        }
+    }
+
+    void run() {
+        if (from_capture) replayCapture();
+        else replayHistory();
+
+        finished_at = Clock::now();
+        bool stopped;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = stopping;
+        }
+        for (size_t i = 0; i < devices.size() && !stopped; i++) {
+            Device& dev = devices[i];
+            dev.status.connected = false;
+            dev.status.health = LinkHealth::Offline;
+            snprintf(dev.status.status, sizeof(dev.status.status), "Odtwarzanie zakończone (%llu próbek)",
+                     static_cast<unsigned long long>(dev.status.polls));
+            dev.published->store(dev.status);
+            if (on_change) on_change(i);
+        }
+        done.store(true, std::memory_order_release);
+        if (!stopped && on_finish) on_finish();
+    }
+
+public:
+    ReplaySource() = default;
+    ~ReplaySource() override { ReplaySource::stop(); }
+
+    ReplaySource(const ReplaySource&) = delete;
+    ReplaySource& operator=(const ReplaySource&) = delete;
+
+    // Rozpoznaje format pliku i ustala listę urządzeń (przed start())
+    bool open(const std::string& path, const ReplayOptions& replay_options = ReplayOptions()) {
+        options = replay_options;
+        devices.clear();
+        total = 0;
+        from_capture = CaptureReader::detect(path);
+        if (from_capture) {
+            if (!capture.open(path)) {
+                error = capture.lastError();
+                return false;
+            }
+            // Urządzenia w kolejności pierwszego wystąpienia w zapisie
+            size_t offset = CaptureReader::firstFrame();
+            CaptureFrame frame;
+            while (capture.next(offset, frame)) {
+                const CaptureFrameHeader& h = frame.header;
+                if (total++ == 0) first_timestamp_ms = h.timestamp_ms;
+                if (deviceFor(h) != devices.size()) continue;
+                char host[sizeof(h.host) + 1] = {};
+                memcpy(host, h.host, sizeof(h.host));
+                addDevice(std::string(host) + ":" + std::to_string(h.port) + "/" + std::to_string(h.slave),
+                          host, h.port, h.slave);
+            }
+        } else {
+            if (!history.open(path, true)) {
+                error = history.lastError();
+                return false;
+            }
+            total = history.size();
+            if (total > 0) first_timestamp_ms = history.at(0).timestamp_ms;
+            size_t slash = path.find_last_of('/');
+            addDevice(slash == std::string::npos ? path : path.substr(slash + 1), "", 0, 0);
+        }
+        if (total == 0) {
+            error = "Brak próbek do odtworzenia w " + path;
+            return false;
+        }
+        return true;
+    }
+
+    void setFinishCallback(FinishCallback callback) { on_finish = std::move(callback); }
+
+    // worker_count bez znaczenia - kolejność próbek wymaga jednego wątku
+    void start(int, SampleCallback callback, ChangeCallback change = nullptr) override {
+        on_sample = std::move(callback);
+        on_change = std::move(change);
+        started = pace_start = Clock::now();
+        worker = std::thread([this] { run(); });
+    }
+
+    void stop() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    // Odtwarzanie ma jedną oś czasu - 'r' podaje od razu następną próbkę
+    void pollNow(size_t) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            skip_wait = true;
+        }
+        wake.notify_all();
+    }
+
+    size_t deviceCount() const override { return devices.size(); }
+    const DeviceConfig& config(size_t device) const override { return devices[device].config; }
+
+    DeviceStatus status(size_t device, uint64_t* version = nullptr) const override {
+        DeviceStatus st;
+        uint64_t v = devices[device].published->load(st);
+        if (version != nullptr) *version = v;
+        return st;
+    }
+
+    // Czas odtwarzanego zapisu (oś wykresu), przed pierwszą próbką - początek zapisu
+    int64_t clockMs() const override {
+        int64_t t = clock_ms.load(std::memory_order_relaxed);
+        return t > 0 ? t : first_timestamp_ms;
+    }
+
+    size_t sampleCount() const { return total; }
+    uint64_t samplesDelivered() const { return delivered.load(std::memory_order_relaxed); }
+    bool finished() const { return done.load(std::memory_order_acquire); }
+    // Czas odtwarzania (do zakończenia albo do teraz)
+    double elapsedSeconds() const {
+        auto end = finished() ? finished_at : Clock::now();
+        return std::chrono::duration<double>(end - started).count();
+    }
+    const std::string& lastError() const { return error; }
+};
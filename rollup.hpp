@@ -0,0 +1,168 @@
+#pragma once
+
+// Wielorozdzielcze agregaty historii (rollup) dla wykresów.
+// Każdy poziom to bufor cykliczny kubełków o stałej szerokości czasowej
+// (np. 10 s, 1 min, 10 min, 1 h) z min/max/średnią/ostatnią wartością.
+// Nowa próbka aktualizuje po jednym kubełku na poziom - O(1).
+// Wykres wybiera poziom dopasowany do szerokości kolumny, więc koszt
+// rysowania zależy od szerokości terminala, a nie od długości historii.
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct RollupBucket {
+    int64_t start_ms = 0;
+    float min = 0.0f;
+    float max = 0.0f;
+    float last = 0.0f;
+    uint32_t count = 0;
+    double sum = 0.0;
+
+    double avg() const { return count > 0 ? sum / count : 0.0; }
+};
+
+// Zagregowana kolumna wykresu
+struct ChartColumn {
+    float min = 0.0f;
+    float max = 0.0f;
+    float avg = 0.0f;
+    float last = 0.0f;
+    bool has_data = false;
+    uint32_t count = 0;  // Liczba próbek w kolumnie
+};
+
+class RollupTier {
+private:
+    int64_t resolution;
+    std::vector<RollupBucket> ring;
+    size_t head = 0;    // Indeks najnowszego kubełka
+    size_t filled = 0;
+
+    // Kubełek k-ty od najstarszego
+    const RollupBucket& logical(size_t k) const {
+        return ring[(head + ring.size() - filled + 1 + k) % ring.size()];
+    }
+
+public:
+    RollupTier(int64_t resolution_ms, size_t capacity)
+        : resolution(resolution_ms), ring(std::max<size_t>(capacity, 1)) {}
+
+    int64_t resolutionMs() const { return resolution; }
+    size_t size() const { return filled; }
+    size_t capacity() const { return ring.size(); }
+
+    // Najstarsza chwila obejmowana przez poziom
+    int64_t oldestMs() const { return filled > 0 ? logical(0).start_ms : 0; }
+
+    void add(int64_t ts_ms, double value) {
+        int64_t start = ts_ms - ((ts_ms % resolution) + resolution) % resolution;
+        float v = float(value);
+        if (filled > 0) {
+            RollupBucket& cur = ring[head];
+            if (start == cur.start_ms) {
+                cur.min = std::min(cur.min, v);
+                cur.max = std::max(cur.max, v);
+                cur.last = v;
+                cur.sum += value;
+                cur.count++;
+                return;
+            }
+            if (start < cur.start_ms) return;  // Próbka spóźniona - pomijana
+        }
+        head = filled > 0 ? (head + 1) % ring.size() : 0;
+        if (filled < ring.size()) filled++;
+        ring[head] = RollupBucket{start, v, v, v, 1, value};
+    }
+
+    // Indeks (logiczny) pierwszego kubełka z start_ms >= ts
+    size_t lowerBound(int64_t ts) const {
+        size_t lo = 0, hi = filled;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (logical(mid).start_ms < ts) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Agreguje kubełki z [from_ms, from_ms + width * column_ms) do kolumn
+    void columns(int64_t from_ms, int64_t column_ms, int width, ChartColumn* out) const {
+        std::fill(out, out + width, ChartColumn{});
+        int64_t to_ms = from_ms + int64_t(width) * column_ms;
+        for (size_t k = lowerBound(from_ms); k < filled; k++) {
+            const RollupBucket& b = logical(k);
+            if (b.start_ms >= to_ms) break;
+            int col = int((b.start_ms - from_ms) / column_ms);
+            ChartColumn& c = out[col];
+            if (!c.has_data) {
+                c.min = b.min;
+                c.max = b.max;
+                c.has_data = true;
+            } else {
+                c.min = std::min(c.min, b.min);
+                c.max = std::max(c.max, b.max);
+            }
+            // Średnia ważona liczbą próbek w kubełkach
+            c.avg = float((double(c.avg) * c.count + b.sum) / (c.count + b.count));
+            c.count += b.count;
+            c.last = b.last;
+        }
+    }
+};
+
+class RollupEngine {
+private:
+    std::vector<RollupTier> tiers;  // Od najdrobniejszego
+    int64_t newest_ms = std::numeric_limits<int64_t>::min();
+
+public:
+    // Domyślne poziomy: 10 s (24 h), 1 min (7 dni), 10 min (30 dni), 1 h (1 rok)
+    RollupEngine() {
+        tiers.emplace_back(10 * 1000LL, 8640);
+        tiers.emplace_back(60 * 1000LL, 10080);
+        tiers.emplace_back(600 * 1000LL, 4320);
+        tiers.emplace_back(3600 * 1000LL, 8760);
+    }
+
+    void add(int64_t ts_ms, double value) {
+        for (auto& t : tiers) t.add(ts_ms, value);
+        newest_ms = std::max(newest_ms, ts_ms);
+    }
+
+    bool empty() const { return tiers.front().size() == 0; }
+    int64_t newestMs() const { return newest_ms; }
+    const std::vector<RollupTier>& levels() const { return tiers; }
+
+    // Wybiera najgrubszy poziom obejmujący całe okno, którego kubełek mieści się
+    // w jednej kolumnie - każda kolumna dostaje dane, a liczba przeglądanych
+    // kubełków jest ograniczona przez szerokość wykresu, nie przez historię.
+    const RollupTier& tierFor(int64_t window_ms, int width) const {
+        int64_t column_ms = std::max<int64_t>(1, window_ms / std::max(1, width));
+        const RollupTier* best = nullptr;
+        for (const auto& t : tiers) {
+            if (covers(t, window_ms) && t.resolutionMs() <= column_ms) best = &t;
+        }
+        if (best != nullptr) return *best;
+        // Kolumna węższa niż najdrobniejszy kubełek - najdrobniejszy poziom obejmujący okno
+        for (const auto& t : tiers) {
+            if (covers(t, window_ms)) return t;
+        }
+        return tiers.back();
+    }
+
+    // Kolumny wykresu dla okna kończącego się w end_ms
+    void chartColumns(int64_t end_ms, int64_t window_ms, int width, std::vector<ChartColumn>& out) const {
+        out.resize(size_t(std::max(0, width)));
+        if (width <= 0) return;
+        int64_t column_ms = std::max<int64_t>(1, window_ms / width);
+        const RollupTier& tier = tierFor(window_ms, width);
+        tier.columns(end_ms - int64_t(width) * column_ms, column_ms, width, out.data());
+    }
+
+private:
+    static bool covers(const RollupTier& t, int64_t window_ms) {
+        return int64_t(t.capacity()) * t.resolutionMs() >= window_ms;
+    }
+};
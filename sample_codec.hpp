@@ -0,0 +1,755 @@
+#pragma once
+
+// Zwarty zapis binarny próbek - eksport zamiast JSON z napisami liczb.
+//
+// Wartości są zapisywane jako surowe liczby całkowite rejestrów, czyli liczby
+// stałoprzecinkowe w skali z REGISTER_MAP (napięcie 0.1 V, prąd fazy 0.001 A,
+// energia 0.01 kWh) - bez strat i bez zmiennoprzecinkowych zaokrągleń.
+// Dwa formaty:
+//
+// - Próbka (SampleWireWriter): jeden rekord bez stanu - datagram, linia potoku,
+//   publikacja --json-format binary. Liczby jako varint (ze znakiem: zigzag),
+//   maska ważności pól, identyfikacja urządzenia. Około 200 bajtów zamiast
+//   1.6 kB JSON w jednej linii.
+//
+// - Blok kolumnowy (SampleBlockWriter, archiwum historii): do BLOCK_SAMPLES
+//   próbek jednego urządzenia zapisanych kolumnami. Czas jako delta-of-delta
+//   (stały interwał odczytu to jeden bit na próbkę), każda kolumna kompresowana
+//   XOR z poprzednią wartością jak w Gorilli (Pelkonen i in., VLDB 2015):
+//   niezmieniona wartość - jeden bit, zmiana - tylko bity znaczące. Kolumny
+//   stałe w całym bloku (konfiguracja, alarmy) zajmują kilka bajtów na blok.
+//
+// Plik archiwum to bloki jeden za drugim (SampleBlockHeader | identyfikacja |
+// strumień bitów), każdy z własnym CRC32. Blok jest dopisywany jednym write(),
+// ucięty ogon jest przy odczycie pomijany.
+
+#include <algorithm>
+#include <bitset>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "inverter_sample.hpp"
+#include "timeseries_store.hpp"
+
+// --- Pola kodeka: wszystkie pola mapy rejestrów (indeks = RegId) i koszt odczytu ---
+
+enum CodecField : size_t {
+    CODEC_PING_MS = REG_COUNT,
+    CODEC_POLL_ROUND_TRIPS,
+    CODEC_POLL_TIME,  // Czas odczytu w 0.1 ms
+    CODEC_FIELD_COUNT
+};
+
+inline uint32_t codecValue(const InverterSample& s, size_t field) {
+    switch (field) {
+        case CODEC_PING_MS: return uint16_t(s.ping_ms);
+        case CODEC_POLL_ROUND_TRIPS: return uint32_t(s.poll.round_trips);
+        case CODEC_POLL_TIME: return uint32_t(std::lround(std::max(0.0, s.poll.wall_ms) * 10.0));
+        default: return s.regs.raw[field];
+    }
+}
+
+// Pola kosztu odczytu są zawsze ważne
+inline bool codecValid(const InverterSample& s, size_t field) {
+    return field >= REG_COUNT || s.regs.valid.test(field);
+}
+
+inline void setCodecValue(InverterSample& s, size_t field, uint32_t value, bool valid) {
+    switch (field) {
+        case CODEC_PING_MS: s.ping_ms = int16_t(uint16_t(value)); break;
+        case CODEC_POLL_ROUND_TRIPS: s.poll.round_trips = int(value); break;
+        case CODEC_POLL_TIME: s.poll.wall_ms = value / 10.0; break;
+        default:
+            s.regs.raw[field] = valid ? value : 0;
+            s.regs.valid.set(field, valid);
+    }
+}
+
+// Wartość ze znakiem zgodnie z typem pola (do zapisu zigzag)
+inline int64_t codecSigned(size_t field, uint32_t raw) {
+    if (field == CODEC_PING_MS) return int16_t(uint16_t(raw));
+    if (field < REG_COUNT) {
+        switch (REGISTER_MAP[field].type) {
+            case RegType::I16: return int16_t(uint16_t(raw));
+            case RegType::I32: return int32_t(raw);
+            default: break;
+        }
+    }
+    return raw;
+}
+
+inline uint32_t codecRaw(size_t field, int64_t value) {
+    if (field == CODEC_PING_MS) return uint16_t(int16_t(value));
+    if (field < REG_COUNT && REGISTER_MAP[field].type == RegType::I16) return uint16_t(int16_t(value));
+    return uint32_t(value);
+}
+
+// --- Liczby o zmiennej długości ---
+
+inline uint64_t zigzagEncode(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+inline int64_t zigzagDecode(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+inline void appendVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(char(uint8_t(v) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+
+inline bool readVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// Identyfikacja urządzenia: cztery napisy z długością i parametry nominalne
+inline void appendDescriptor(std::string& out, const DeviceDescriptor& d) {
+    const char* texts[] = {d.model, d.sn, d.firmware_version, d.production_date};
+    size_t sizes[] = {sizeof(d.model), sizeof(d.sn), sizeof(d.firmware_version), sizeof(d.production_date)};
+    for (size_t i = 0; i < 4; i++) {
+        size_t n = strnlen(texts[i], sizes[i] - 1);
+        out.push_back(char(n));
+        out.append(texts[i], n);
+    }
+    for (uint16_t v : {d.device_type, d.rated_power_w, d.max_power_w, d.phase_count, d.pv_string_count}) {
+        appendVarint(out, v);
+    }
+}
+
+inline bool readDescriptor(const uint8_t*& p, const uint8_t* end, DeviceDescriptor& d) {
+    char* texts[] = {d.model, d.sn, d.firmware_version, d.production_date};
+    size_t sizes[] = {sizeof(d.model), sizeof(d.sn), sizeof(d.firmware_version), sizeof(d.production_date)};
+    for (size_t i = 0; i < 4; i++) {
+        if (p >= end) return false;
+        size_t n = *p++;
+        if (n >= sizes[i] || size_t(end - p) < n) return false;
+        memcpy(texts[i], p, n);
+        texts[i][n] = 0;
+        p += n;
+    }
+    uint16_t* values[] = {&d.device_type, &d.rated_power_w, &d.max_power_w, &d.phase_count, &d.pv_string_count};
+    for (uint16_t* v : values) {
+        uint64_t x;
+        if (!readVarint(p, end, x)) return false;
+        *v = uint16_t(x);
+    }
+    return true;
+}
+
+// Internowanie z pamięcią ostatniego opisu - kolejne próbki tego samego
+// urządzenia nie sięgają do rejestru opisów
+class DescriptorCache {
+private:
+    DeviceDescriptor last;
+    const DeviceDescriptor* interned = &UNKNOWN_DEVICE;
+
+public:
+    const DeviceDescriptor* intern(const DeviceDescriptor& d) {
+        if (!(d == last)) {
+            last = d;
+            interned = DescriptorRegistry::instance().intern(d);
+        }
+        return interned;
+    }
+};
+
+// --- Pojedyncza próbka ---
+
+constexpr uint8_t SAMPLE_WIRE_VERSION = 1;
+
+class SampleWireWriter {
+private:
+    std::string out;
+
+public:
+    SampleWireWriter() { out.reserve(512); }
+
+    // Zwrócona referencja jest ważna do następnego wywołania
+    const std::string& write(const InverterSample& s) {
+        out.clear();
+        out.push_back(char(SAMPLE_WIRE_VERSION));
+        appendVarint(out, zigzagEncode(s.timestamp_ms));
+        appendDescriptor(out, *s.device);
+        size_t mask_at = out.size();
+        out.append((REG_COUNT + 7) / 8, '\0');
+        for (size_t f = 0; f < CODEC_FIELD_COUNT; f++) {
+            if (!codecValid(s, f)) continue;
+            if (f < REG_COUNT) out[mask_at + f / 8] = char(uint8_t(out[mask_at + f / 8]) | (1u << (f % 8)));
+            appendVarint(out, zigzagEncode(codecSigned(f, codecValue(s, f))));
+        }
+        return out;
+    }
+};
+
+class SampleWireReader {
+private:
+    DescriptorCache descriptors;
+
+public:
+    // Rekord -> próbka; 0 przy błędzie, inaczej liczba odczytanych bajtów
+    size_t read(const uint8_t* data, size_t size, InverterSample& s) {
+        const uint8_t* p = data;
+        const uint8_t* end = data + size;
+        uint64_t v;
+        if (p >= end || *p++ != SAMPLE_WIRE_VERSION || !readVarint(p, end, v)) return 0;
+        s = InverterSample();
+        s.timestamp_ms = zigzagDecode(v);
+        DeviceDescriptor d;
+        if (!readDescriptor(p, end, d)) return 0;
+        s.device = descriptors.intern(d);
+        const size_t mask_size = (REG_COUNT + 7) / 8;
+        if (size_t(end - p) < mask_size) return 0;
+        const uint8_t* mask = p;
+        p += mask_size;
+        for (size_t f = 0; f < CODEC_FIELD_COUNT; f++) {
+            bool valid = f >= REG_COUNT || ((mask[f / 8] >> (f % 8)) & 1);
+            if (!valid) continue;
+            if (!readVarint(p, end, v)) return 0;
+            setCodecValue(s, f, codecRaw(f, zigzagDecode(v)), true);
+        }
+        return size_t(p - data);
+    }
+};
+
+// --- Strumień bitów (od najstarszego bitu) ---
+
+class BitWriter {
+private:
+    std::string& out;
+    uint64_t acc = 0;
+    int used = 0;
+
+public:
+    explicit BitWriter(std::string& buffer) : out(buffer) {}
+
+    // n <= 32 najmłodszych bitów value
+    void write(uint32_t value, int n) {
+        acc = (acc << n) | (uint64_t(value) & ((uint64_t(1) << n) - 1));
+        used += n;
+        while (used >= 8) {
+            used -= 8;
+            out.push_back(char(uint8_t(acc >> used)));
+        }
+    }
+
+    void bit(bool b) { write(b, 1); }
+
+    void flush() {
+        if (used > 0) out.push_back(char(uint8_t(acc << (8 - used))));
+        used = 0;
+    }
+};
+
+class BitReader {
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t window = 0;  // Kolejne bity od najstarszego
+    int bits = 0;         // Ważne bity w window
+    size_t pos = 0;       // Odczytane bity
+    size_t size_bits;
+
+    void refill() {
+        if (end - p >= 8) {
+            // Młodsze bity poza liczonymi bajtami to te same dane, które dołoży następne uzupełnienie
+            uint64_t w;
+            memcpy(&w, p, 8);
+            window |= __builtin_bswap64(w) >> bits;
+            int take = (64 - bits) >> 3;
+            p += take;
+            bits += take * 8;
+        } else {
+            while (bits <= 56) {
+                window |= uint64_t(p < end ? *p++ : 0) << (56 - bits);
+                bits += 8;
+            }
+        }
+    }
+
+public:
+    BitReader(const uint8_t* bytes, size_t length) : p(bytes), end(bytes + length), size_bits(length * 8) {}
+
+    // n <= 32
+    uint32_t read(int n) {
+        if (n == 0) return 0;
+        if (bits < n) refill();
+        uint32_t v = uint32_t(window >> (64 - n));
+        window <<= n;
+        bits -= n;
+        pos += size_t(n);
+        return v;
+    }
+
+    bool bit() { return read(1) != 0; }
+    // Czy odczyt wyszedł poza dane (uszkodzony blok)
+    bool overrun() const { return pos > size_bits; }
+};
+
+// --- Blok kolumnowy ---
+
+constexpr char SAMPLE_BLOCK_MAGIC[4] = {'S', '2', 'K', 'B'};
+constexpr uint16_t SAMPLE_BLOCK_VERSION = 1;
+
+struct SampleBlockHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t field_count;      // CODEC_FIELD_COUNT przy zapisie
+    uint32_t size;             // Cały blok: nagłówek, identyfikacja i strumień bitów
+    uint32_t count;            // Liczba próbek
+    int64_t first_timestamp_ms;
+    int64_t last_timestamp_ms;  // Wybór bloków po czasie bez dekodowania
+    uint32_t crc;              // CRC32 wszystkiego za nagłówkiem
+    uint32_t reserved;
+};
+
+static_assert(sizeof(SampleBlockHeader) == 40, "Stały układ nagłówka bloku");
+
+// Tryb kolumny (2 bity) - ważność pola w bloku
+enum : uint32_t { COLUMN_NONE = 0, COLUMN_ALL = 1, COLUMN_MASK = 2, COLUMN_CONSTANT = 3 };
+
+class SampleBlockWriter {
+public:
+    static constexpr size_t BLOCK_SAMPLES = 1024;  // Niecałe 3 doby próbek co 10 s (bez nocy)
+    // Odstęp kolumn w buforach: 4 KB trafiałoby zawsze w ten sam zbiór cache L1
+    static constexpr size_t COLUMN_STRIDE = BLOCK_SAMPLES + 16;
+
+private:
+    static constexpr size_t MASK_WORDS = BLOCK_SAMPLES / 64;
+
+    std::vector<int64_t> timestamps;
+    std::vector<uint32_t> columns;    // CODEC_FIELD_COUNT x COLUMN_STRIDE
+    std::vector<uint64_t> validity;   // CODEC_FIELD_COUNT x MASK_WORDS
+    const DeviceDescriptor* device = &UNKNOWN_DEVICE;
+    size_t count = 0;
+    std::string out;
+
+    // Wartości ważnych wierszy kolumny: XOR z poprzednią wartością
+    static void writeXor(BitWriter& bits, const uint32_t* values, const uint64_t* mask, size_t n) {
+        uint32_t prev = 0;
+        int prev_lead = 33, prev_trail = 0;  // Brak okna bitów znaczących
+        for (size_t i = 0; i < n; i++) {
+            if (!((mask[i / 64] >> (i % 64)) & 1)) continue;
+            uint32_t x = values[i] ^ prev;
+            prev = values[i];
+            if (x == 0) {
+                bits.bit(false);
+                continue;
+            }
+            int lead = __builtin_clz(x), trail = __builtin_ctz(x);
+            if (lead >= prev_lead && trail >= prev_trail) {
+                // '10': bity znaczące w oknie poprzedniej zmiany
+                bits.write(0b10, 2);
+                bits.write(x >> prev_trail, 32 - prev_lead - prev_trail);
+            } else {
+                // '11': nowe okno - zera wiodące (5 bitów), długość - 1 (5 bitów), bity
+                int length = 32 - lead - trail;
+                bits.write(0b11, 2);
+                bits.write(uint32_t(lead), 5);
+                bits.write(uint32_t(length - 1), 5);
+                bits.write(x >> trail, length);
+                prev_lead = lead;
+                prev_trail = trail;
+            }
+        }
+    }
+
+    static void writeTimestamps(BitWriter& bits, const int64_t* ts, size_t n) {
+        int64_t prev_delta = 0;
+        for (size_t i = 1; i < n; i++) {
+            int64_t delta = ts[i] - ts[i - 1];
+            int64_t dod = delta - prev_delta;
+            prev_delta = delta;
+            if (dod == 0) {
+                bits.bit(false);
+            } else if (dod >= -64 && dod < 64) {
+                bits.write(0b10, 2);
+                bits.write(uint32_t(dod), 7);
+            } else if (dod >= -256 && dod < 256) {
+                bits.write(0b110, 3);
+                bits.write(uint32_t(dod), 9);
+            } else if (dod >= -2048 && dod < 2048) {
+                bits.write(0b1110, 4);
+                bits.write(uint32_t(dod), 12);
+            } else {
+                bits.write(0b1111, 4);
+                bits.write(uint32_t(uint64_t(dod) >> 32), 32);
+                bits.write(uint32_t(dod), 32);
+            }
+        }
+    }
+
+public:
+    SampleBlockWriter()
+        : timestamps(BLOCK_SAMPLES), columns(CODEC_FIELD_COUNT * COLUMN_STRIDE),
+          validity(CODEC_FIELD_COUNT * MASK_WORDS) {
+        out.reserve(64 * 1024);
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == BLOCK_SAMPLES; }
+    const DeviceDescriptor* blockDevice() const { return device; }
+
+    // Blok ma próbki jednego urządzenia: wymaga !full() i (empty() albo tego samego s.device)
+    void add(const InverterSample& s) {
+        if (count == 0) {
+            device = s.device;
+            std::fill(validity.begin(), validity.end(), 0);
+        }
+        timestamps[count] = s.timestamp_ms;
+        const uint64_t bit = uint64_t(1) << (count % 64);
+        for (size_t f = 0; f < REG_COUNT; f++) {
+            columns[f * COLUMN_STRIDE + count] = s.regs.raw[f];
+            if (s.regs.valid[f]) validity[f * MASK_WORDS + count / 64] |= bit;
+        }
+        for (size_t f = REG_COUNT; f < CODEC_FIELD_COUNT; f++) {
+            columns[f * COLUMN_STRIDE + count] = codecValue(s, f);
+            validity[f * MASK_WORDS + count / 64] |= bit;
+        }
+        count++;
+    }
+
+    // Koduje zebrane próbki i zaczyna nowy blok; referencja ważna do następnego wywołania
+    const std::string& finish() {
+        out.clear();
+        out.resize(sizeof(SampleBlockHeader));
+        appendDescriptor(out, *device);
+        BitWriter bits(out);
+        writeTimestamps(bits, timestamps.data(), count);
+        for (size_t f = 0; f < CODEC_FIELD_COUNT; f++) {
+            const uint32_t* values = &columns[f * COLUMN_STRIDE];
+            const uint64_t* mask = &validity[f * MASK_WORDS];
+            size_t valid = 0;
+            for (size_t w = 0; w < MASK_WORDS; w++) valid += size_t(__builtin_popcountll(mask[w]));
+            if (valid == 0) {
+                bits.write(COLUMN_NONE, 2);
+                continue;
+            }
+            if (valid == count) {
+                if (std::all_of(values + 1, values + count, [&](uint32_t v) { return v == values[0]; })) {
+                    bits.write(COLUMN_CONSTANT, 2);
+                    bits.write(values[0], 32);
+                    continue;
+                }
+                bits.write(COLUMN_ALL, 2);
+            } else {
+                bits.write(COLUMN_MASK, 2);
+                for (size_t i = 0; i < count; i++) bits.bit((mask[i / 64] >> (i % 64)) & 1);
+            }
+            writeXor(bits, values, mask, count);
+        }
+        bits.flush();
+
+        SampleBlockHeader h{};
+        memcpy(h.magic, SAMPLE_BLOCK_MAGIC, sizeof(h.magic));
+        h.version = SAMPLE_BLOCK_VERSION;
+        h.field_count = uint16_t(CODEC_FIELD_COUNT);
+        h.size = uint32_t(out.size());
+        h.count = uint32_t(count);
+        h.first_timestamp_ms = count > 0 ? timestamps[0] : 0;
+        h.last_timestamp_ms = count > 0 ? timestamps[count - 1] : 0;
+        h.crc = crc32(out.data() + sizeof(h), out.size() - sizeof(h));
+        memcpy(&out[0], &h, sizeof(h));
+        count = 0;
+        return out;
+    }
+};
+
+class SampleBlockReader {
+private:
+    DescriptorCache descriptors;
+    // Kolumny dekodowane osobno, potem składane w wiersze - zapis do próbek po
+    // kolei zamiast skakania co sizeof(InverterSample) przy każdej kolumnie
+    std::vector<uint32_t> columns;  // CODEC_FIELD_COUNT x COLUMN_STRIDE
+    std::vector<uint8_t> valid;     // Jak columns
+    std::vector<int64_t> timestamps;
+    std::string error;
+
+    static void readXor(BitReader& bits, uint32_t* values, const uint8_t* valid, size_t n) {
+        uint32_t prev = 0;
+        int prev_lead = 0, prev_trail = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (!valid[i]) {
+                values[i] = 0;
+                continue;
+            }
+            if (bits.bit()) {
+                if (bits.bit()) {
+                    prev_lead = int(bits.read(5));
+                    int length = int(bits.read(5)) + 1;
+                    prev_trail = std::max(0, 32 - prev_lead - length);
+                    prev ^= bits.read(length) << prev_trail;
+                } else {
+                    prev ^= bits.read(32 - prev_lead - prev_trail) << prev_trail;
+                }
+            }
+            values[i] = prev;
+        }
+    }
+
+    bool fail(const char* what) {
+        error = what;
+        return false;
+    }
+
+public:
+    SampleBlockReader()
+        : columns(CODEC_FIELD_COUNT * SampleBlockWriter::COLUMN_STRIDE),
+          valid(CODEC_FIELD_COUNT * SampleBlockWriter::COLUMN_STRIDE),
+          timestamps(SampleBlockWriter::BLOCK_SAMPLES) {}
+
+    // Blok -> próbki (out dostaje tyle próbek, ile ma blok)
+    bool decode(const uint8_t* block, size_t size, std::vector<InverterSample>& out) {
+        constexpr size_t N = SampleBlockWriter::COLUMN_STRIDE;
+        SampleBlockHeader h;
+        if (size < sizeof(h)) return fail("Ucięty nagłówek bloku");
+        memcpy(&h, block, sizeof(h));
+        if (memcmp(h.magic, SAMPLE_BLOCK_MAGIC, sizeof(h.magic)) != 0 || h.version != SAMPLE_BLOCK_VERSION) {
+            return fail("Niezgodny format bloku");
+        }
+        if (h.field_count != CODEC_FIELD_COUNT) return fail("Niezgodny układ pól bloku (inna mapa rejestrów)");
+        if (h.size < sizeof(h) || h.size > size || h.count > SampleBlockWriter::BLOCK_SAMPLES) {
+            return fail("Niespójny rozmiar bloku");
+        }
+        if (crc32(block + sizeof(h), h.size - sizeof(h)) != h.crc) return fail("Błąd CRC bloku");
+
+        const uint8_t* p = block + sizeof(h);
+        const uint8_t* end = block + h.size;
+        DeviceDescriptor d;
+        if (!readDescriptor(p, end, d)) return fail("Uszkodzona identyfikacja bloku");
+        const DeviceDescriptor* device = descriptors.intern(d);
+
+        const size_t count = h.count;
+        BitReader bits(p, size_t(end - p));
+        int64_t ts = h.first_timestamp_ms, delta = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (i > 0) {
+                int64_t dod = 0;
+                if (bits.bit()) {
+                    if (!bits.bit()) dod = int8_t(uint8_t(bits.read(7) << 1)) >> 1;
+                    else if (!bits.bit()) dod = int16_t(uint16_t(bits.read(9) << 7)) >> 7;
+                    else if (!bits.bit()) dod = int16_t(uint16_t(bits.read(12) << 4)) >> 4;
+                    else {
+                        uint64_t high = bits.read(32);
+                        dod = int64_t((high << 32) | bits.read(32));
+                    }
+                }
+                delta += dod;
+                ts += delta;
+            }
+            timestamps[i] = ts;
+        }
+
+        for (size_t f = 0; f < CODEC_FIELD_COUNT; f++) {
+            uint32_t* values = &columns[f * N];
+            uint8_t* mask = &valid[f * N];
+            uint32_t mode = bits.read(2);
+            if (mode == COLUMN_CONSTANT) {
+                std::fill(values, values + count, bits.read(32));
+                std::fill(mask, mask + count, 1);
+                continue;
+            }
+            for (size_t i = 0; i < count; i++) mask[i] = mode == COLUMN_MASK ? bits.bit() : mode == COLUMN_ALL;
+            readXor(bits, values, mask, count);
+        }
+        if (bits.overrun()) return fail("Ucięty strumień bitów bloku");
+
+        // Składanie wierszy kafelkami po TILE próbek - kolumna kafelka to jedna linia cache
+        constexpr size_t TILE = 16;
+        out.resize(count);
+        for (size_t first = 0; first < count; first += TILE) {
+            size_t n = std::min(TILE, count - first);
+            InverterSample* rows = &out[first];
+            uint64_t valid_bits[TILE][2] = {};
+            for (size_t f = 0; f < REG_COUNT; f++) {
+                const uint32_t* values = &columns[f * N + first];
+                const uint8_t* mask = &valid[f * N + first];
+                for (size_t i = 0; i < n; i++) {
+                    rows[i].regs.raw[f] = values[i];
+                    valid_bits[i][f / 64] |= uint64_t(mask[i]) << (f % 64);
+                }
+            }
+            for (size_t i = 0; i < n; i++) {
+                InverterSample& s = rows[i];
+                s.timestamp_ms = timestamps[first + i];
+                s.device = device;
+                s.poll = PollStats();
+                s.regs.valid = (std::bitset<REG_COUNT>(valid_bits[i][1]) << 64) |
+                               std::bitset<REG_COUNT>(valid_bits[i][0]);
+                for (size_t f = REG_COUNT; f < CODEC_FIELD_COUNT; f++) {
+                    setCodecValue(s, f, columns[f * N + first + i], true);
+                }
+            }
+        }
+        return true;
+    }
+
+    const std::string& lastError() const { return error; }
+};
+
+// Dopisywanie bloków do pliku archiwum (jak zapis ramek: O_APPEND, jeden write()).
+// Każde urządzenie ma własny otwarty blok, więc przeplatane próbki kilku
+// urządzeń nadal dają pełne bloki.
+class SampleArchiveWriter {
+private:
+    int fd = -1;
+    std::vector<std::unique_ptr<SampleBlockWriter>> blocks;
+    uint64_t blocks_written = 0;
+    uint64_t bytes_written = 0;
+    std::string error;
+
+    bool writeBlock(SampleBlockWriter& block) {
+        const std::string& data = block.finish();
+        if (::write(fd, data.data(), data.size()) != ssize_t(data.size())) {
+            error = std::string("Zapis bloku: ") + strerror(errno);
+            return false;
+        }
+        blocks_written++;
+        bytes_written += data.size();
+        return true;
+    }
+
+public:
+    SampleArchiveWriter() = default;
+    SampleArchiveWriter(const SampleArchiveWriter&) = delete;
+    SampleArchiveWriter& operator=(const SampleArchiveWriter&) = delete;
+    ~SampleArchiveWriter() { close(); }
+
+    // truncate - nowe archiwum zamiast dopisywania do istniejącego
+    bool open(const std::string& path, bool truncate = false) {
+        close();
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+        if (fd < 0) {
+            error = "Nie można otworzyć " + path + ": " + strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    // Próbka trafia do bloku swojego urządzenia; pełny blok jest zapisywany
+    bool append(const InverterSample& s) {
+        if (fd < 0) return false;
+        SampleBlockWriter* block = nullptr;
+        for (auto& b : blocks) {
+            if (b->blockDevice() == s.device) block = b.get();
+        }
+        if (block == nullptr) {
+            blocks.push_back(std::make_unique<SampleBlockWriter>());
+            block = blocks.back().get();
+        }
+        if (block->full() && !writeBlock(*block)) return false;
+        block->add(s);
+        return true;
+    }
+
+    // Zapis niepełnych bloków
+    bool flush() {
+        if (fd < 0) return true;
+        for (auto& b : blocks) {
+            if (!b->empty() && !writeBlock(*b)) return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd >= 0) {
+            flush();
+            ::close(fd);
+        }
+        fd = -1;
+    }
+
+    uint64_t blocksWritten() const { return blocks_written; }
+    uint64_t bytesWritten() const { return bytes_written; }
+    const std::string& lastError() const { return error; }
+};
+
+// Odczyt pliku archiwum (mapowany w pamięć, tylko do odczytu)
+class SampleArchiveReader {
+private:
+    int fd = -1;
+    const uint8_t* map = nullptr;
+    size_t map_size = 0;
+    SampleBlockReader reader;
+    std::string error;
+
+public:
+    SampleArchiveReader() = default;
+    SampleArchiveReader(const SampleArchiveReader&) = delete;
+    SampleArchiveReader& operator=(const SampleArchiveReader&) = delete;
+    ~SampleArchiveReader() { close(); }
+
+    // Czy plik zaczyna się nagłówkiem bloku
+    static bool detect(const std::string& path) {
+        char magic[sizeof(SAMPLE_BLOCK_MAGIC)] = {};
+        int f = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (f < 0) return false;
+        bool ok = ::read(f, magic, sizeof(magic)) == ssize_t(sizeof(magic)) &&
+                  memcmp(magic, SAMPLE_BLOCK_MAGIC, sizeof(magic)) == 0;
+        ::close(f);
+        return ok;
+    }
+
+    bool open(const std::string& path) {
+        close();
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) != 0) {
+            error = "Nie można otworzyć " + path + ": " + strerror(errno);
+            close();
+            return false;
+        }
+        map_size = size_t(st.st_size);
+        if (map_size == 0) return true;
+        void* p = ::mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            error = "mmap " + path + ": " + strerror(errno);
+            close();
+            return false;
+        }
+        map = static_cast<const uint8_t*>(p);
+        ::madvise(const_cast<uint8_t*>(map), map_size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if (map != nullptr) ::munmap(const_cast<uint8_t*>(map), map_size);
+        map = nullptr;
+        map_size = 0;
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    size_t fileSize() const { return map_size; }
+
+    // Próbki bloku od pozycji offset (przesuwanej za blok); false na końcu pliku
+    // albo przy uciętym / uszkodzonym bloku (opis w lastError)
+    bool next(size_t& offset, std::vector<InverterSample>& samples) {
+        if (map == nullptr || offset >= map_size) return false;
+        if (!reader.decode(map + offset, map_size - offset, samples)) {
+            error = reader.lastError() + " (offset " + std::to_string(offset) + ")";
+            return false;
+        }
+        SampleBlockHeader h;
+        memcpy(&h, map + offset, sizeof(h));
+        offset += h.size;
+        return true;
+    }
+
+    const std::string& lastError() const { return error; }
+};
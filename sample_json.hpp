@@ -0,0 +1,141 @@
+#pragma once
+
+// Serializacja InverterSample do JSON bez pośrednich obiektów.
+// Wynik jest budowany w buforze wielokrotnego użytku - po pierwszym zapisie
+// kolejne próbki nie alokują pamięci. Format pól zgodny z dotychczasowym
+// wyjściem (wartości ułamkowe jako napisy z ustaloną precyzją).
+
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "energy_accounting.hpp"
+#include "inverter_sample.hpp"
+
+class SampleJsonWriter {
+private:
+    std::string out;
+    bool pretty;
+    bool first_field = true;
+
+    void appendRaw(const char* s, size_t n) { out.append(s, n); }
+    void appendRaw(const char* s) { out.append(s); }
+
+    void appendEscaped(const char* s) {
+        out.push_back('"');
+        for (; *s; ++s) {
+            char c = *s;
+            if (c == '"' || c == '\\') {
+                out.push_back('\\');
+                out.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char esc[8];
+                int n = snprintf(esc, sizeof(esc), "\\u%04x", unsigned(c));
+                out.append(esc, size_t(n));
+            } else {
+                out.push_back(c);
+            }
+        }
+        out.push_back('"');
+    }
+
+    void beginField(const char* key) {
+        if (!first_field) out.push_back(',');
+        first_field = false;
+        if (pretty) out.append("\n  ");
+        out.push_back('"');
+        out.append(key);
+        out.append(pretty ? "\": " : "\":");
+    }
+
+    void appendInt(int64_t v) {
+        char buf[24];
+        auto r = std::to_chars(buf, buf + sizeof(buf), v);
+        out.append(buf, size_t(r.ptr - buf));
+    }
+
+    // Liczba o stałej precyzji jako napis JSON ("12.3")
+    void appendFixedString(double v, int decimals) {
+        char buf[40];
+        auto r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed, decimals);
+        out.push_back('"');
+        out.append(buf, size_t(r.ptr - buf));
+        out.push_back('"');
+    }
+
+public:
+    explicit SampleJsonWriter(bool pretty_output = true) : pretty(pretty_output) {
+        out.reserve(4096);
+    }
+
+    void setPretty(bool p) { pretty = p; }
+    bool isPretty() const { return pretty; }
+
+    // Serializuje próbkę (z bilansem energii, jeśli podany); zwrócona referencja
+    // jest ważna do następnego wywołania
+    const std::string& write(const InverterSample& s, const EnergyLedger* energy = nullptr) {
+        out.clear();
+        first_field = true;
+        out.push_back('{');
+
+        char time_buf[32];
+        formatSampleTime(s.timestamp_ms, time_buf, sizeof(time_buf));
+        beginField("timestamp");
+        appendEscaped(time_buf);
+
+        beginField("model");
+        appendEscaped(s.device->model);
+
+        beginField("device_status");
+        const char* status = deviceStatusName(s.state());
+        if (status != nullptr) {
+            appendEscaped(status);
+        } else {
+            out.append("\"Nieznany (");
+            appendInt(s.state());
+            out.append(")\"");
+        }
+
+        // Wszystkie pola numeryczne; nieodczytane (nieudany blok) jako null, nie 0
+        for (const auto& desc : REGISTER_MAP) {
+            if (desc.type == RegType::STR || !(desc.group & REG_GROUPS_POLLED)) continue;
+            beginField(desc.key);
+            if (!s.regs.has(desc.id)) {
+                out.append("null");
+            } else if (desc.decimals == 0) {
+                appendInt(int64_t(s.value(desc.id)));
+            } else {
+                appendFixedString(s.value(desc.id), desc.decimals);
+            }
+        }
+
+        beginField("sn");
+        appendEscaped(s.device->sn);
+        beginField("firmware_version");
+        appendEscaped(s.device->firmware_version);
+        beginField("ping_ms");
+        appendInt(s.ping_ms);
+
+        beginField("poll_round_trips");
+        appendInt(s.poll.round_trips);
+        beginField("poll_time_ms");
+        appendFixedString(s.poll.wall_ms, 1);
+
+        // Produkcja z bilansu (całka mocy uzgodniona z licznikami) w okresach próbki
+        if (energy != nullptr) {
+            beginField("energy_hour_kwh");
+            appendFixedString(energy->hours.energyAt(s.timestamp_ms) / 1000.0, 2);
+            beginField("energy_today_kwh");
+            appendFixedString(energy->days.energyAt(s.timestamp_ms) / 1000.0, 2);
+            beginField("energy_month_kwh");
+            appendFixedString(energy->months.energyAt(s.timestamp_ms) / 1000.0, 2);
+        }
+
+        if (pretty) out.push_back('\n');
+        out.push_back('}');
+        return out;
+    }
+
+    const std::string& buffer() const { return out; }
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+// Wspólny interfejs odczytu z urządzeń i odtwarzania zapisu: konfiguracja
+// urządzenia, jego stan i źródło próbek. Bez zależności od transportu Modbus,
+// więc odtwarzanie i benchmarki nie wymagają libmodbus.
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "inverter_sample.hpp"
+#include "poll_scheduler.hpp"
+
+struct DeviceConfig {
+    std::string name;
+    std::string ip;
+    int port = 6607;
+    int slave_id = 0;
+    int interval_s = 10;
+    int fast_interval_s = 3;     // Przy rozruchu i szybkich zmianach mocy (0 - wyłączone)
+    int night_interval_s = 300;  // W nocy, stan 0xA000 (0 - wyłączone)
+    std::string output;   // Cel publikacji JSON (pusty - bez publikacji)
+    std::string history;  // Plik historii (pusty - bez zapisu)
+};
+
+// Stan łącza z urządzeniem
+enum class LinkHealth : uint8_t {
+    Connecting,    // Jeszcze nie połączono
+    Healthy,       // Ostatni odczyt kompletny
+    Degraded,      // Połączenie jest, ale część lub całość odczytu nieudana
+    Reconnecting,  // Połączenie utracone, ponowne łączenie z wycofaniem
+    Offline,       // Długa przerwa - ponowne próby coraz rzadziej
+};
+
+inline const char* linkHealthName(LinkHealth health) {
+    switch (health) {
+        case LinkHealth::Connecting: return "łączenie";
+        case LinkHealth::Healthy: return "OK";
+        case LinkHealth::Degraded: return "błędy";
+        case LinkHealth::Reconnecting: return "wznawia";
+        case LinkHealth::Offline: return "brak";
+    }
+    return "?";
+}
+
+// Stan urządzenia widziany przez interfejs (trywialnie kopiowalny - publikowany bez blokad)
+struct DeviceStatus {
+    bool connected = false;
+    LinkHealth health = LinkHealth::Connecting;
+    char status[96] = "Oczekiwanie na pierwszy odczyt";
+    uint64_t polls = 0;
+    uint64_t failures = 0;
+    int consecutive_failures = 0;
+    int current_interval_s = 0;   // Interwał po uwzględnieniu trybu i wycofania po błędach
+    PollMode mode = PollMode::Normal;
+    double last_lateness_ms = 0;  // Opóźnienie startu odczytu względem terminu
+    int64_t last_ok_ms = 0;       // Czas ostatniego udanego odczytu (0 - jeszcze nie było)
+    int reconnect_attempts = 0;   // Nieudane próby połączenia od utraty łącza
+};
+
+// Źródło próbek dla publikacji, historii, interfejsu i HTTP: odczyt z urządzeń
+// (PollingEngine) albo odtwarzanie zapisu (ReplaySource, replay_source.hpp)
+class SampleSource {
+public:
+    // Wywoływane z wątku roboczego po każdym odczycie (także nieudanym).
+    // Jedno urządzenie nigdy nie jest obsługiwane przez dwa wątki naraz.
+    using SampleCallback = std::function<void(size_t device, const InverterSample& sample, bool ok)>;
+    // Wywoływane po opublikowaniu nowego stanu urządzenia (próbka i status są już widoczne)
+    using ChangeCallback = std::function<void(size_t device)>;
+
+    virtual ~SampleSource() = default;
+
+    virtual void start(int worker_count, SampleCallback callback, ChangeCallback change = nullptr) = 0;
+    virtual void stop() = 0;
+    // Następna próbka urządzenia od razu (klawisz 'r')
+    virtual void pollNow(size_t device) = 0;
+    void pollAllNow() {
+        for (size_t i = 0; i < deviceCount(); i++) pollNow(i);
+    }
+
+    virtual size_t deviceCount() const = 0;
+    virtual const DeviceConfig& config(size_t device) const = 0;
+    // Bez blokad - interfejs nie czeka na wątki odczytu;
+    // version (opcjonalnie) rośnie przy każdej zmianie statusu
+    virtual DeviceStatus status(size_t device, uint64_t* version = nullptr) const = 0;
+    // Bieżący czas danych (oś wykresu): zegar systemowy, przy odtwarzaniu czas zapisu
+    virtual int64_t clockMs() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+// Przekazywanie danych z wątków odczytu do interfejsu bez blokad.
+//
+// SeqlockSnapshot<T> - ostatnia wartość (np. najnowsza próbka). Jeden pisarz,
+// dowolna liczba czytelników. Pisarz nigdy nie czeka; czytelnik kopiuje
+// wartość i powtarza kopię, jeśli w międzyczasie trwał zapis. Dane trzymane
+// są w słowach atomowych (dostęp relaxed), więc nie ma wyścigu danych
+// w sensie modelu pamięci C++, a na x86 kopia to zwykłe instrukcje mov.
+//
+// SpscRing<T> - kolejka jeden pisarz / jeden czytelnik o stałej pojemności.
+// Służy do przekazania każdej próbki (np. mocy do agregatów wykresu),
+// gdy sama ostatnia wartość nie wystarcza. Pełna kolejka odrzuca nowe
+// elementy zamiast blokować pisarza.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+template <typename T>
+class SeqlockSnapshot {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqlockSnapshot wymaga typu trywialnie kopiowalnego");
+
+public:
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+private:
+    std::atomic<uint64_t> sequence{0};  // Nieparzysta w trakcie zapisu
+    std::atomic<uint64_t> words[WORDS];
+
+public:
+    SeqlockSnapshot() { store(T{}); }
+    explicit SeqlockSnapshot(const T& initial) { store(initial); }
+
+    SeqlockSnapshot(const SeqlockSnapshot&) = delete;
+    SeqlockSnapshot& operator=(const SeqlockSnapshot&) = delete;
+
+    // Publikacja nowej wartości; wołana tylko z jednego wątku naraz
+    void store(const T& value) {
+        uint64_t buf[WORDS] = {};
+        memcpy(buf, &value, sizeof(T));
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) words[i].store(buf[i], std::memory_order_relaxed);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Kopia ostatniej spójnej wartości; zwraca jej wersję
+    uint64_t load(T& out) const {
+        uint64_t buf[WORDS];
+        uint64_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            while (before & 1) before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++) buf[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while (before != after);
+        memcpy(&out, buf, sizeof(T));
+        return before / 2;
+    }
+
+    // Numer publikacji (rośnie przy każdym store) - pozwala pominąć kopię bez zmian
+    uint64_t version() const { return sequence.load(std::memory_order_acquire) / 2; }
+};
+
+template <typename T>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing wymaga typu trywialnie kopiowalnego");
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};  // Następny do odczytu (czytelnik)
+    alignas(64) std::atomic<size_t> tail{0};  // Następny do zapisu (pisarz)
+    std::atomic<uint64_t> dropped{0};
+
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+public:
+    explicit SpscRing(size_t capacity = 256) : slots(roundUp(capacity < 2 ? 2 : capacity)), mask(slots.size() - 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Pisarz; false gdy kolejka pełna (element odrzucony)
+    bool push(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Czytelnik; false gdy pusta
+    bool pop(T& out) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        out = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return slots.size(); }
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+};
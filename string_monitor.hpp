@@ -0,0 +1,299 @@
+#pragma once
+
+// Monitor stringów PV (wejść MPPT) jednego urządzenia. Każdy string i całe
+// urządzenie to kanał; historia kanałów leży w buforze cyklicznym w układzie
+// struktury tablic: wspólna oś czasu i osobna ciągła tablica float na każdą
+// wielkość każdego kanału. Statystyki długich okien (średnia, min/max,
+// niedopasowanie stringów) to proste pętle po tablicach float, które
+// kompilator zamienia na instrukcje wektorowe. Bufor przydzielany raz, przy
+// pierwszym pomiarze - dopisywanie kolejnych nie alokuje.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "inverter_sample.hpp"
+
+// Stringi w mapie rejestrów (PV1/PV2: 32060-32063)
+constexpr int PV_STRINGS_PER_DEVICE = 2;
+
+// Domyślna pojemność historii - 16384 pomiary (ok. 45 h przy odczycie co 10 s)
+constexpr size_t STRING_HISTORY_CAPACITY = 16384;
+
+// String z niższym napięciem w całym oknie uznawany za niepodłączony
+constexpr float STRING_CONNECTED_MIN_VOLTAGE_V = 20.0f;
+// Niedopasowanie oceniane dopiero od tego średniego prądu najlepszego stringu (noc, świt)
+constexpr float STRING_MISMATCH_MIN_CURRENT_A = 0.5f;
+// Progi niedopasowania prądów: ostrzeżenie i alarm (ułamek prądu najlepszego stringu)
+constexpr float STRING_MISMATCH_WARNING = 0.05f;
+constexpr float STRING_MISMATCH_ALERT = 0.15f;
+
+// Pomiar stringów jednego urządzenia przekazywany z wątku odczytu (SpscRing)
+struct StringPoint {
+    int64_t timestamp_ms = 0;
+    float voltage[PV_STRINGS_PER_DEVICE] = {};
+    float current[PV_STRINGS_PER_DEVICE] = {};
+    float input_power = 0.0f;                 // Moc DC całego urządzenia (32064)
+    uint8_t strings = PV_STRINGS_PER_DEVICE;  // Stringi według identyfikacji (30074)
+};
+
+static_assert(std::is_trivially_copyable<StringPoint>::value, "StringPoint musi być trywialnie kopiowalny");
+
+// Pomiar stringów z próbki; false, gdy rejestry stringów nie zostały odczytane
+inline bool stringPointFromSample(const InverterSample& s, StringPoint& p) {
+    static constexpr RegId VOLTAGES[] = {REG_PV1_VOLTAGE, REG_PV2_VOLTAGE};
+    static constexpr RegId CURRENTS[] = {REG_PV1_CURRENT, REG_PV2_CURRENT};
+    static_assert(sizeof(VOLTAGES) / sizeof(VOLTAGES[0]) == PV_STRINGS_PER_DEVICE, "Rejestry stringów");
+    int reported = s.device->pv_string_count;
+    p.timestamp_ms = s.timestamp_ms;
+    p.strings = uint8_t(reported >= 1 && reported <= PV_STRINGS_PER_DEVICE ? reported : PV_STRINGS_PER_DEVICE);
+    float dc_power = 0.0f;
+    for (int k = 0; k < PV_STRINGS_PER_DEVICE; k++) {
+        bool used = k < p.strings;
+        if (used && (!s.regs.has(VOLTAGES[k]) || !s.regs.has(CURRENTS[k]))) return false;
+        p.voltage[k] = used ? float(s.value(VOLTAGES[k])) : 0.0f;
+        p.current[k] = used ? float(s.value(CURRENTS[k])) : 0.0f;
+        dc_power += p.voltage[k] * p.current[k];
+    }
+    p.input_power = s.regs.has(REG_INPUT_POWER) ? float(s.get<REG_INPUT_POWER>()) : dc_power;
+    return true;
+}
+
+// Suma i skrajne wartości fragmentu tablicy
+struct FloatSpanStats {
+    double sum = 0.0;
+    float min = std::numeric_limits<float>::infinity();
+    float max = -std::numeric_limits<float>::infinity();
+};
+
+// Dolicza n wartości do statystyki. Cztery niezależne akumulatory (jeden rejestr
+// SSE) ustalają kolejność sumowania, więc kompilator używa instrukcji wektorowych
+// bez -ffast-math; sumy częściowe float przenoszone do double co blok, żeby długie
+// okna nie traciły dokładności. Więcej akumulatorów przy -O2 ląduje na stosie.
+inline void accumulateSpan(const float* values, size_t n, FloatSpanStats& acc) {
+    constexpr size_t LANES = 4, BLOCK = 1024;
+    size_t full = n - n % LANES;
+    size_t i = 0;
+    if (full > 0) {
+        float sum[LANES] = {}, lo[LANES], hi[LANES];
+        for (size_t k = 0; k < LANES; k++) lo[k] = hi[k] = values[k];
+        while (i < full) {
+            size_t end = std::min(full, i + BLOCK);
+            for (; i < end; i += LANES) {
+                for (size_t k = 0; k < LANES; k++) {
+                    float x = values[i + k];
+                    sum[k] += x;
+                    lo[k] = x < lo[k] ? x : lo[k];
+                    hi[k] = x > hi[k] ? x : hi[k];
+                }
+            }
+            for (size_t k = 0; k < LANES; k++) {
+                acc.sum += sum[k];
+                sum[k] = 0.0f;
+            }
+        }
+        for (size_t k = 0; k < LANES; k++) {
+            acc.min = std::min(acc.min, lo[k]);
+            acc.max = std::max(acc.max, hi[k]);
+        }
+    }
+    for (; i < n; i++) {
+        acc.sum += values[i];
+        acc.min = std::min(acc.min, values[i]);
+        acc.max = std::max(acc.max, values[i]);
+    }
+}
+
+// Statystyka kanału w oknie czasu
+struct StringWindowStats {
+    uint32_t count = 0;  // 0 - brak pomiarów w oknie
+    float mean = 0.0f;
+    float min = 0.0f;
+    float max = 0.0f;
+};
+
+// Niedopasowanie stringów w oknie
+struct StringMismatch {
+    float ratio = 0.0f;   // (najlepszy - najsłabszy) / najlepszy, średnie prądy
+    int weakest = -1;     // Najsłabszy string; -1 - nie oceniono
+    int connected = 0;    // Stringi z napięciem w oknie
+};
+
+class StringMonitor {
+public:
+    static constexpr int CHANNELS = PV_STRINGS_PER_DEVICE + 1;
+    static constexpr int DEVICE_CHANNEL = PV_STRINGS_PER_DEVICE;  // Całe urządzenie
+
+    // Wielkości kanału; dla urządzenia: średnie napięcie podłączonych stringów,
+    // suma prądów i moc wejściowa
+    enum Quantity : int { VOLTAGE, CURRENT, POWER, QUANTITY_COUNT };
+
+private:
+    size_t capacity_;
+    size_t mask;
+    std::vector<int64_t> times;  // Oś czasu wspólna dla wszystkich kanałów
+    std::vector<float> planes;   // CHANNELS * QUANTITY_COUNT tablic po capacity_ wartości
+    uint64_t written = 0;        // Wszystkie dopisane pomiary
+    size_t filled = 0;
+    int strings_ = PV_STRINGS_PER_DEVICE;
+
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    float* writablePlane(int channel, Quantity q) {
+        return planes.data() + size_t(channel * QUANTITY_COUNT + q) * capacity_;
+    }
+
+    // Fizyczny indeks k-tego pomiaru od najstarszego
+    size_t physical(size_t k) const { return size_t(written - filled + k) & mask; }
+
+    // Fizyczne odcinki (najwyżej dwa - zawinięcie bufora) pomiarów logicznych [first, last)
+    template <typename F>
+    void forEachSegment(size_t first, size_t last, F&& fn) const {
+        size_t start = physical(first);
+        size_t n = last - first;
+        size_t head = std::min(n, capacity_ - start);
+        if (head > 0) fn(start, head);
+        if (n > head) fn(size_t(0), n - head);
+    }
+
+    // Statystyka pomiarów logicznych [first, last)
+    StringWindowStats spanStats(int channel, Quantity q, size_t first, size_t last) const {
+        StringWindowStats out;
+        if (first >= last) return out;
+        const float* values = plane(channel, q);
+        FloatSpanStats acc;
+        forEachSegment(first, last, [&](size_t start, size_t n) { accumulateSpan(values + start, n, acc); });
+        out.count = uint32_t(last - first);
+        out.mean = float(acc.sum / out.count);
+        out.min = acc.min;
+        out.max = acc.max;
+        return out;
+    }
+
+public:
+    explicit StringMonitor(size_t capacity = STRING_HISTORY_CAPACITY)
+        : capacity_(roundUp(std::max<size_t>(capacity, 2))), mask(capacity_ - 1) {}
+
+    size_t size() const { return filled; }
+    size_t capacity() const { return capacity_; }
+    int strings() const { return strings_; }
+    int64_t oldestMs() const { return filled > 0 ? times[physical(0)] : 0; }
+    int64_t newestMs() const { return filled > 0 ? times[physical(filled - 1)] : 0; }
+
+    const float* plane(int channel, Quantity q) const {
+        return planes.data() + size_t(channel * QUANTITY_COUNT + q) * capacity_;
+    }
+    // Ostatni pomiar kanału (0 - brak pomiarów)
+    float latest(int channel, Quantity q) const { return filled > 0 ? plane(channel, q)[physical(filled - 1)] : 0.0f; }
+
+    // Dopisuje pomiar; spóźniony lub powtórzony (czas nie rośnie) jest pomijany
+    void add(const StringPoint& p) {
+        if (filled > 0 && p.timestamp_ms <= newestMs()) return;
+        if (times.empty()) {
+            times.resize(capacity_);
+            planes.resize(capacity_ * CHANNELS * QUANTITY_COUNT);
+        }
+        size_t i = size_t(written) & mask;
+        times[i] = p.timestamp_ms;
+        float voltage_sum = 0.0f, current_sum = 0.0f;
+        int connected = 0;
+        for (int k = 0; k < PV_STRINGS_PER_DEVICE; k++) {
+            writablePlane(k, VOLTAGE)[i] = p.voltage[k];
+            writablePlane(k, CURRENT)[i] = p.current[k];
+            writablePlane(k, POWER)[i] = p.voltage[k] * p.current[k];
+            if (p.voltage[k] >= STRING_CONNECTED_MIN_VOLTAGE_V) {
+                voltage_sum += p.voltage[k];
+                connected++;
+            }
+            current_sum += p.current[k];
+        }
+        writablePlane(DEVICE_CHANNEL, VOLTAGE)[i] = connected > 0 ? voltage_sum / connected : 0.0f;
+        writablePlane(DEVICE_CHANNEL, CURRENT)[i] = current_sum;
+        writablePlane(DEVICE_CHANNEL, POWER)[i] = p.input_power;
+        strings_ = p.strings;
+        written++;
+        if (filled < capacity_) filled++;
+    }
+
+    void clear() {
+        written = 0;
+        filled = 0;
+    }
+
+    // Indeks (logiczny) pierwszego pomiaru z czasem >= ts
+    size_t lowerBound(int64_t ts) const {
+        size_t lo = 0, hi = filled;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (times[physical(mid)] < ts) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Statystyka kanału w oknie [from_ms, to_ms)
+    StringWindowStats stats(int channel, Quantity q, int64_t from_ms, int64_t to_ms) const {
+        return spanStats(channel, q, lowerBound(from_ms), lowerBound(to_ms));
+    }
+
+    // Niedopasowanie prądów podłączonych stringów w oknie [from_ms, to_ms)
+    StringMismatch mismatch(int64_t from_ms, int64_t to_ms) const {
+        StringMismatch out;
+        size_t first = lowerBound(from_ms), last = lowerBound(to_ms);
+        if (first >= last) return out;
+        float best = 0.0f, worst = std::numeric_limits<float>::infinity();
+        for (int k = 0; k < strings_; k++) {
+            if (spanStats(k, VOLTAGE, first, last).max < STRING_CONNECTED_MIN_VOLTAGE_V) continue;
+            float mean = spanStats(k, CURRENT, first, last).mean;
+            out.connected++;
+            best = std::max(best, mean);
+            if (mean < worst) {
+                worst = mean;
+                out.weakest = k;
+            }
+        }
+        if (out.connected < 2 || best < STRING_MISMATCH_MIN_CURRENT_A) {
+            out.weakest = -1;
+            return out;
+        }
+        out.ratio = (best - worst) / best;
+        return out;
+    }
+
+    // Średnie kanału w width równych kolumnach okna [from_ms, to_ms); NaN - kolumna bez pomiarów
+    void columnMeans(int channel, Quantity q, int64_t from_ms, int64_t to_ms, int width, float* out) const {
+        if (width <= 0) return;
+        int64_t span = std::max<int64_t>(1, to_ms - from_ms);
+        size_t first = lowerBound(from_ms);
+        for (int c = 0; c < width; c++) {
+            size_t last = lowerBound(from_ms + span * (c + 1) / width);
+            out[c] = first < last ? spanStats(channel, q, first, last).mean :
+                                    std::numeric_limits<float>::quiet_NaN();
+            first = last;
+        }
+    }
+};
+
+// Wykres w jednej linii (▁ do █) ze średnich kolumn; skala [0, scale_max], NaN - spacja
+inline std::string sparkline(const float* values, int width, float scale_max) {
+    static const char* const LEVELS[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+    std::string out;
+    out.reserve(size_t(std::max(width, 0)) * 3);
+    for (int c = 0; c < width; c++) {
+        if (std::isnan(values[c])) {
+            out += ' ';
+            continue;
+        }
+        int level = scale_max > 0.0f ? int(values[c] / scale_max * 8.0f) : 0;
+        out += LEVELS[std::clamp(level, 0, 7)];
+    }
+    return out;
+}
@@ -0,0 +1,1081 @@
+// Mikrobenchmarki ścieżek krytycznych sun_ftxui.
+// Każdy test podaje czas na operację i liczbę alokacji sterty na operację.
+// Sekcje: odczyt z lokalnego zastępcy Modbus TCP, dekodowanie rejestrów, JSON,
+// eksport binarny, historia, wykres w kilku rozmiarach terminala i cały potok
+// odtwarzania. --output dopisuje wyniki jako linię JSON z etykietą kompilacji,
+// --compare zestawia przebiegi (np. -march=bonnell i kompilację ogólną).
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <new>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "anomaly_detector.hpp"
+#include "energy_accounting.hpp"
+#include "frame_capture.hpp"
+#include "inverter_sample.hpp"
+#include "modbus_tcp_client.hpp"
+#include "power_chart.hpp"
+#include "replay_source.hpp"
+#include "rollup.hpp"
+#include "sample_codec.hpp"
+#include "sample_json.hpp"
+#include "string_monitor.hpp"
+#include "timeseries_store.hpp"
+
+using namespace std;
+
+// Flagi kompilacji zapisywane z wynikami (Makefile.ftxui podaje ARCH_FLAGS i OPTIMIZATION_FLAGS)
+#ifndef SUN_BENCH_FLAGS
+#define SUN_BENCH_FLAGS ""
+#endif
+
+// --- Licznik alokacji ---
+static atomic<uint64_t> g_allocations(0);
+
+// noinline: GCC po wstawieniu myli pary new/free (-Wmismatched-new-delete)
+__attribute__((noinline)) void* operator new(size_t n) {
+    g_allocations.fetch_add(1, memory_order_relaxed);
+    void* p = malloc(n ? n : 1);
+    if (p == nullptr) throw bad_alloc();
+    return p;
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct BenchResult {
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+// Wynik do zapisu maszynowego (--output)
+struct BenchRecord {
+    string section;
+    string name;
+    double value;
+    string unit;
+    double allocs_per_op;  // -1 - nie dotyczy
+};
+
+static vector<BenchRecord> g_records;
+static string g_section;  // Bieżąca sekcja
+
+// Wartość pomocnicza (rozmiar, przepustowość) obok czasów runBench
+static void recordValue(const char* name, double value, const char* unit) {
+    g_records.push_back({g_section, name, value, unit, -1.0});
+}
+
+template <typename F>
+BenchResult runBench(const char* name, int iterations, F&& fn) {
+    for (int i = 0; i < iterations / 10 + 1; i++) fn(i);  // rozgrzewka
+    uint64_t allocs_before = g_allocations.load();
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) fn(i);
+    auto elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    BenchResult r{elapsed / iterations, double(g_allocations.load() - allocs_before) / iterations};
+    printf("%-56s %12.1f ns/op %10.2f alloc/op\n", name, r.ns_per_op, r.allocs_per_op);
+    g_records.push_back({g_section, name, r.ns_per_op, "ns/op", r.allocs_per_op});
+    return r;
+}
+
+// Przykładowa próbka z typowymi wartościami dziennymi
+static InverterSample makeSample(int i) {
+    InverterSample s;
+    s.timestamp_ms = 1750000000000LL + int64_t(i) * 10000;
+    auto set = [&](RegId id, uint32_t raw) { s.regs.raw[id] = raw; s.regs.valid.set(id); };
+    set(REG_PV1_VOLTAGE, 3521); set(REG_PV2_VOLTAGE, 3498);
+    set(REG_PV1_CURRENT, 812); set(REG_PV2_CURRENT, 798);
+    set(REG_INPUT_POWER, 5650 + i % 50);
+    set(REG_PHASE_A_VOLTAGE, 2301); set(REG_PHASE_B_VOLTAGE, 2315); set(REG_PHASE_C_VOLTAGE, 2298);
+    set(REG_PHASE_A_CURRENT, 7890); set(REG_PHASE_B_CURRENT, 7912); set(REG_PHASE_C_CURRENT, 7875);
+    set(REG_ACTIVE_POWER, 5480 + i % 50); set(REG_POWER_FACTOR, 999); set(REG_GRID_FREQUENCY, 5001);
+    set(REG_EFFICIENCY, 9812); set(REG_INTERNAL_TEMPERATURE, 452); set(REG_DEVICE_STATE, 0x0200);
+    set(REG_TOTAL_ENERGY, 1234567); set(REG_DAILY_ENERGY, 2345);
+    static const DeviceDescriptor* device = [] {
+        DeviceDescriptor d;
+        snprintf(d.model, sizeof(d.model), "SUN2000-8KTL-M1");
+        snprintf(d.sn, sizeof(d.sn), "HV1234567890");
+        snprintf(d.firmware_version, sizeof(d.firmware_version), "V100R001C0");
+        d.rated_power_w = 8000;
+        d.phase_count = 3;
+        return DescriptorRegistry::instance().intern(d);
+    }();
+    s.device = device;
+    return s;
+}
+
+// --- Dotychczasowa ścieżka: próbka -> napisy -> ordered_json -> dump -> stod ---
+namespace legacy {
+
+using json = nlohmann::ordered_json;
+
+inline string to_fixed_1(double val) { ostringstream oss; oss << fixed << setprecision(1) << val; return oss.str(); }
+inline string to_fixed_2(double val) { ostringstream oss; oss << fixed << setprecision(2) << val; return oss.str(); }
+
+struct InverterData {
+    string timestamp, model, sn, firmware_version, device_status;
+    double active_power = 0, input_power = 0, efficiency = 0, temperature = 0, daily_energy = 0,
+           total_energy = 0, frequency = 0, phase_A_voltage = 0, phase_B_voltage = 0, phase_C_voltage = 0,
+           phase_A_current = 0, phase_B_current = 0, phase_C_current = 0;
+    int wifi_signal = -65, ping_ms = 0;
+};
+
+inline json toJson(const InverterSample& s) {
+    json data;
+    time_t t = time_t(s.timestamp_ms / 1000);
+    stringstream ss;
+    ss << put_time(localtime(&t), "%Y-%m-%d %H:%M:%S");
+    data["timestamp"] = ss.str();
+    data["model"] = s.device->model;
+    data["device_status"] = "On-grid";
+    data["internal_temperature"] = to_fixed_1(s.get<REG_INTERNAL_TEMPERATURE>());
+    data["daily_yield_energy"] = to_fixed_2(s.get<REG_DAILY_ENERGY>());
+    data["accumulated_energy_yield"] = to_fixed_2(s.get<REG_TOTAL_ENERGY>());
+    data["active_power"] = to_fixed_1(s.get<REG_ACTIVE_POWER>());
+    data["input_power"] = to_fixed_1(s.get<REG_INPUT_POWER>());
+    data["efficiency"] = to_fixed_2(s.get<REG_EFFICIENCY>());
+    data["grid_frequency"] = to_fixed_2(s.get<REG_GRID_FREQUENCY>());
+    data["phase_A_voltage"] = to_fixed_1(s.get<REG_PHASE_A_VOLTAGE>());
+    data["phase_B_voltage"] = to_fixed_1(s.get<REG_PHASE_B_VOLTAGE>());
+    data["phase_C_voltage"] = to_fixed_1(s.get<REG_PHASE_C_VOLTAGE>());
+    data["phase_A_current"] = to_fixed_2(s.get<REG_PHASE_A_CURRENT>());
+    data["phase_B_current"] = to_fixed_2(s.get<REG_PHASE_B_CURRENT>());
+    data["phase_C_current"] = to_fixed_2(s.get<REG_PHASE_C_CURRENT>());
+    data["sn"] = s.device->sn;
+    data["firmware_version"] = s.device->firmware_version;
+    data["wifi_signal_dbm"] = -65;
+    data["ping_ms"] = 15;
+    return data;
+}
+
+inline InverterData fromJson(json& j) {
+    auto safe_stod = [](const json& val, double def = 0.0) -> double {
+        if (val.is_string()) { try { return stod(val.get<string>()); } catch (...) { return def; } }
+        else if (val.is_number()) return val.get<double>();
+        return def;
+    };
+    InverterData d;
+    d.timestamp = j.value("timestamp", "N/A");
+    d.model = j.value("model", "N/A");
+    d.sn = j.value("sn", "N/A");
+    d.firmware_version = j.value("firmware_version", "N/A");
+    d.device_status = j.value("device_status", "N/A");
+    d.active_power = safe_stod(j["active_power"]);
+    d.input_power = safe_stod(j["input_power"]);
+    d.efficiency = safe_stod(j["efficiency"]);
+    d.temperature = safe_stod(j["internal_temperature"]);
+    d.daily_energy = safe_stod(j["daily_yield_energy"]);
+    d.total_energy = safe_stod(j["accumulated_energy_yield"]);
+    d.frequency = safe_stod(j["grid_frequency"]);
+    d.phase_A_voltage = safe_stod(j["phase_A_voltage"]);
+    d.phase_B_voltage = safe_stod(j["phase_B_voltage"]);
+    d.phase_C_voltage = safe_stod(j["phase_C_voltage"]);
+    d.phase_A_current = safe_stod(j["phase_A_current"]);
+    d.phase_B_current = safe_stod(j["phase_B_current"]);
+    d.phase_C_current = safe_stod(j["phase_C_current"]);
+    d.wifi_signal = j.value("wifi_signal_dbm", -65);
+    d.ping_ms = j.value("ping_ms", 0);
+    return d;
+}
+
+// Dotychczasowy wykres: kopia całej historii pod blokadą, próbkowanie punktów,
+// wiersze sklejane znak po znaku, etykiety przez stringstream (bez elementów FTXUI)
+inline size_t chartFrame(const deque<double>& power_history, int chart_width, int chart_height) {
+    deque<double> history = power_history;
+    double max_power = *max_element(history.begin(), history.end());
+    if (max_power <= 0) max_power = 1.0;
+    vector<double> display_data(chart_width, 0.0);
+    vector<bool> has_data(chart_width, false);
+    int data_size = int(history.size());
+    for (int i = 0; i < chart_width; i++) {
+        int data_idx = (i * data_size) / chart_width;
+        if (data_idx < data_size) {
+            display_data[i] = history[data_idx];
+            has_data[i] = true;
+        }
+    }
+    size_t bytes = 0;
+    for (int y = chart_height - 1; y >= 0; y--) {
+        double threshold = (double(y + 1) / chart_height) * max_power;
+        stringstream ylabel;
+        ylabel << setw(6) << fixed << setprecision(0) << threshold << "W";
+        string chart_line;
+        for (int x = 0; x < chart_width; x++) {
+            double ratio = display_data[x] / max_power;
+            double y_pos = double(y) / chart_height;
+            if (!has_data[x]) chart_line += " ";
+            else if (ratio >= y_pos + (1.0 / chart_height)) chart_line += "█";
+            else if (ratio >= y_pos + (0.75 / chart_height)) chart_line += "▊";
+            else if (ratio >= y_pos + (0.5 / chart_height)) chart_line += "▌";
+            else if (ratio >= y_pos + (0.25 / chart_height)) chart_line += "▎";
+            else if (ratio > y_pos) chart_line += "▏";
+            else chart_line += " ";
+        }
+        bytes += ylabel.str().size() + chart_line.size();
+    }
+    return bytes;
+}
+
+}  // namespace legacy
+
+// Moc w ciągu doby (krzywa dzienna z szumem) - dane do benchmarku wykresu
+static double dayPower(int64_t ts_ms) {
+    double hour = double(ts_ms / 1000 % 86400) / 3600.0;
+    double base = hour > 5 && hour < 21 ? 8000.0 * sin((hour - 5) / 16 * 3.14159265) : 0.0;
+    return max(0.0, base + double((ts_ms / 10000) % 97) - 48.0);
+}
+
+static volatile size_t g_sink;
+
+// Próbka z przebiegiem dobowym: moc, prądy i napięcia zmienne jak w pracy,
+// czas odczytu z rozrzutem kilkudziesięciu ms - dane do benchmarku kompresji
+static InverterSample daySample(int i) {
+    InverterSample s = makeSample(i);
+    uint32_t noise = uint32_t(i) * 2654435761u;
+    s.timestamp_ms += int64_t(noise % 80);
+    double power = dayPower(s.timestamp_ms);
+    auto set = [&](RegId id, double value) {
+        s.regs.raw[id] = uint32_t(llround(value * REGISTER_MAP[id].divider));
+    };
+    set(REG_INPUT_POWER, power * 1.02);
+    set(REG_ACTIVE_POWER, power);
+    set(REG_PV1_CURRENT, power / 2 / 352.0);
+    set(REG_PV2_CURRENT, power / 2 / 350.0);
+    for (RegId id : {REG_PHASE_A_CURRENT, REG_PHASE_B_CURRENT, REG_PHASE_C_CURRENT}) {
+        set(id, power / 3 / 230.0 + double((noise >> (id % 8)) % 20) / 1000.0);
+    }
+    for (RegId id : {REG_PHASE_A_VOLTAGE, REG_PHASE_B_VOLTAGE, REG_PHASE_C_VOLTAGE}) {
+        set(id, 229.0 + double((noise >> (id % 8)) % 30) / 10.0);
+    }
+    set(REG_GRID_FREQUENCY, 49.98 + double(noise % 5) / 100.0);
+    set(REG_INTERNAL_TEMPERATURE, 25.0 + power / 400.0);
+    set(REG_DAILY_ENERGY, double(i) * 0.001);
+    s.poll.round_trips = 6;
+    s.poll.wall_ms = 40.0 + double(noise % 200) / 10.0;
+    s.ping_ms = int16_t(2 + noise % 5);
+    return s;
+}
+
+// Wpisuje wartości próbki do bufora planu tak, jak leżą w rejestrach inwertera
+static void fillPlan(RegisterPlan& plan, const InverterSample& s) {
+    for (auto& block : plan.blocks()) block.ok = true;
+    for (size_t id = 0; id < REG_COUNT; id++) {
+        const RegisterDesc& d = REGISTER_MAP[id];
+        uint32_t offset;
+        int b = plan.locate(d.address, d.words, offset);
+        if (b < 0 || d.type == RegType::STR) continue;
+        const RegisterBlock& block = plan.blocks()[b];
+        uint16_t* w = plan.blockData(block) + (d.address - block.start);
+        if (d.words == 2) {
+            w[0] = uint16_t(s.regs.raw[id] >> 16);
+            w[1] = uint16_t(s.regs.raw[id] & 0xFFFF);
+        } else {
+            w[0] = uint16_t(s.regs.raw[id]);
+        }
+    }
+}
+
+// Zapis ramek jak z --capture: próbki makeSample zakodowane w planie grup odczytu
+static bool writeCaptureFile(const char* path, int samples) {
+    FrameCapture capture;
+    if (!capture.open(path)) return false;
+    RegisterPlan plan;
+    planRegisterGroups(plan, REG_GROUPS_POLLED);
+    plan.build();
+    vector<uint8_t> buffer;
+    for (int i = 0; i < samples; i++) {
+        InverterSample s = makeSample(i);
+        fillPlan(plan, s);
+        if (!capture.append(s.timestamp_ms, "127.0.0.1", 502, 1, REG_GROUPS_POLLED, plan, 0, buffer)) return false;
+    }
+    return true;
+}
+
+// Plik tymczasowy dla sekcji zapisujących na dysk; pusty napis przy błędzie
+static string tempPath(const char* prefix) {
+    string path = string("/tmp/") + prefix + "_XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) {
+        perror("mkstemp");
+        return string();
+    }
+    close(fd);
+    return path;
+}
+
+// Zastępca urządzenia Modbus TCP w osobnym wątku: odpowiada na FC03 wartościami
+// z tabeli rejestrów, bez opóźnień - pomiar samej ścieżki klienta i dekodowania
+class ModbusStandIn {
+private:
+    int listen_fd = -1;
+    atomic<int> conn_fd{-1};
+    int port = 0;
+    vector<uint16_t> registers = vector<uint16_t>(65536, 0);
+    thread worker;
+
+    void serve() {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        conn_fd = fd;
+        uint8_t rx[1024];
+        size_t rx_len = 0;
+        vector<uint8_t> tx;
+        for (;;) {
+            ssize_t got = recv(fd, rx + rx_len, sizeof(rx) - rx_len, 0);
+            if (got <= 0) break;
+            rx_len += size_t(got);
+            size_t pos = 0;
+            tx.clear();
+            while (rx_len - pos >= 12) {
+                const uint8_t* f = rx + pos;
+                uint16_t start = uint16_t((f[8] << 8) | f[9]);
+                uint16_t count = uint16_t((f[10] << 8) | f[11]);
+                pos += 12;
+                size_t at = tx.size();
+                bool ok = f[7] == 0x03 && count >= 1 && count <= 125 && size_t(start) + count <= registers.size();
+                size_t pdu = ok ? 2 + 2 * size_t(count) : 2;
+                tx.resize(at + 7 + pdu);
+                uint8_t* r = tx.data() + at;
+                memcpy(r, f, 4);  // Identyfikator transakcji i protokołu
+                r[4] = uint8_t((pdu + 1) >> 8);
+                r[5] = uint8_t((pdu + 1) & 0xFF);
+                r[6] = f[6];
+                if (ok) {
+                    r[7] = 0x03;
+                    r[8] = uint8_t(count * 2);
+                    for (uint16_t k = 0; k < count; k++) {
+                        r[9 + 2 * k] = uint8_t(registers[start + k] >> 8);
+                        r[10 + 2 * k] = uint8_t(registers[start + k] & 0xFF);
+                    }
+                } else {
+                    r[7] = uint8_t(f[7] | 0x80);
+                    r[8] = 0x02;  // Niedozwolony adres
+                }
+            }
+            memmove(rx, rx + pos, rx_len - pos);
+            rx_len -= pos;
+            if (!tx.empty() && send(fd, tx.data(), tx.size(), MSG_NOSIGNAL) != ssize_t(tx.size())) break;
+        }
+        conn_fd = -1;
+        ::close(fd);
+    }
+
+public:
+    ~ModbusStandIn() { stop(); }
+
+    bool start(const InverterSample& s) {
+        for (size_t id = 0; id < REG_COUNT; id++) {
+            const RegisterDesc& d = REGISTER_MAP[id];
+            if (d.type == RegType::STR) continue;
+            if (d.words == 2) {
+                registers[d.address] = uint16_t(s.regs.raw[id] >> 16);
+                registers[d.address + 1] = uint16_t(s.regs.raw[id] & 0xFFFF);
+            } else {
+                registers[d.address] = uint16_t(s.regs.raw[id]);
+            }
+        }
+        listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd < 0) return false;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd, 1) != 0 ||
+            getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return false;
+        }
+        port = ntohs(addr.sin_port);
+        worker = thread([this] { serve(); });
+        return true;
+    }
+
+    void stop() {
+        if (listen_fd >= 0) shutdown(listen_fd, SHUT_RDWR);
+        int fd = conn_fd.load();
+        if (fd >= 0) shutdown(fd, SHUT_RDWR);
+        if (worker.joinable()) worker.join();
+        if (listen_fd >= 0) ::close(listen_fd);
+        listen_fd = -1;
+    }
+
+    int tcpPort() const { return port; }
+};
+
+// --- Sekcje ---
+
+static bool benchJson() {
+    const int N = 20000;
+    printf("=== Próbka -> JSON -> dashboard (%d iteracji) ===\n", N);
+
+    runBench("legacy: to_fixed + ordered_json + stod", N, [](int i) {
+        InverterSample s = makeSample(i);
+        legacy::json j = legacy::toJson(s);
+        string out = j.dump(2);
+        legacy::InverterData d = legacy::fromJson(j);
+        g_sink = out.size() + d.model.size();
+    });
+
+    SampleJsonWriter writer(true);
+    InverterSample shared_copy;
+    runBench("typed: InverterSample + SampleJsonWriter", N, [&](int i) {
+        InverterSample s = makeSample(i);
+        const string& out = writer.write(s);
+        shared_copy = s;
+        g_sink = out.size() + size_t(shared_copy.timestamp_ms);
+    });
+
+    // Analiza strumienia (asymetria, sprawność, częstotliwość, derating) przy każdej próbce
+    AnomalyDetector detector;
+    AlarmEvent anomaly_events[AnomalyDetector::MAX_EVENTS];
+    runBench("AnomalyDetector::update", N, [&](int i) {
+        InverterSample s = makeSample(i);
+        g_sink = detector.update(s, anomaly_events);
+    });
+    return true;
+}
+
+// Bufor planu -> RegisterValues -> próbka: pełny odczyt i szybki odczyt (moc, alarmy)
+static bool benchDecode() {
+    const int N = 200000;
+    printf("\n=== Dekodowanie rejestrów (%d iteracji) ===\n", N);
+    struct Case {
+        const char* name;
+        uint8_t groups;
+    };
+    for (const Case& c : {Case{"RegisterDecoder: grupy cykliczne", REG_GROUPS_POLLED},
+                          Case{"RegisterDecoder: moc + alarmy", uint8_t(REG_GROUP_POWER | REG_GROUP_ALARM)}}) {
+        RegisterPlan plan;
+        planRegisterGroups(plan, c.groups);
+        plan.build();
+        fillPlan(plan, makeSample(0));
+        RegisterDecoder decoder;
+        decoder.bind(plan);
+        InverterSample s;
+        runBench(c.name, N, [&](int) {
+            decoder.decode(plan, s.regs);
+            finishInverterSample(plan, decoder, c.groups, 0, s);
+            g_sink = s.regs.raw[REG_ACTIVE_POWER];
+        });
+    }
+    return true;
+}
+
+// Eksport binarny: rekord pojedynczej próbki i bloki kolumnowe archiwum
+// (czas na próbkę, dla bloków - z rozłożonym kosztem finish()/decode())
+static bool benchCodec() {
+    const int CODEC_N = int(SampleBlockWriter::BLOCK_SAMPLES) * 16;
+    printf("\n=== Eksport binarny: %d próbek z przebiegiem dobowym ===\n", CODEC_N);
+    vector<InverterSample> samples;
+    for (int i = 0; i < CODEC_N; i++) samples.push_back(daySample(i));
+
+    SampleJsonWriter compact(false);
+    size_t json_bytes = 0;
+    runBench("SampleJsonWriter (compact)", CODEC_N, [&](int i) {
+        json_bytes = compact.write(samples[size_t(i) % samples.size()]).size();
+        g_sink = json_bytes;
+    });
+
+    SampleWireWriter wire_writer;
+    SampleWireReader wire_reader;
+    size_t wire_bytes = 0;
+    runBench("SampleWireWriter::write", CODEC_N, [&](int i) {
+        wire_bytes = wire_writer.write(samples[size_t(i) % samples.size()]).size();
+        g_sink = wire_bytes;
+    });
+    const string record = wire_writer.write(samples[0]);
+    InverterSample decoded;
+    runBench("SampleWireReader::read", CODEC_N, [&](int) {
+        g_sink = wire_reader.read(reinterpret_cast<const uint8_t*>(record.data()), record.size(), decoded);
+    });
+
+    SampleBlockWriter block_writer;
+    vector<string> blocks;
+    for (const auto& s : samples) {
+        block_writer.add(s);
+        if (block_writer.full()) blocks.push_back(block_writer.finish());
+    }
+    size_t block_bytes = 0;
+    for (const auto& b : blocks) block_bytes += b.size();
+    runBench("SampleBlockWriter add + finish", CODEC_N, [&](int i) {
+        block_writer.add(samples[size_t(i) % samples.size()]);
+        if (block_writer.full()) g_sink = block_writer.finish().size();
+    });
+    SampleBlockReader block_reader;
+    vector<InverterSample> block_samples;
+    bool blocks_ok = true;
+    runBench("SampleBlockReader::decode", CODEC_N, [&](int i) {
+        if (size_t(i) % SampleBlockWriter::BLOCK_SAMPLES != 0) return;
+        const string& b = blocks[size_t(i) / SampleBlockWriter::BLOCK_SAMPLES % blocks.size()];
+        blocks_ok &= block_reader.decode(reinterpret_cast<const uint8_t*>(b.data()), b.size(), block_samples);
+    });
+    bool same = blocks_ok && block_samples.size() == SampleBlockWriter::BLOCK_SAMPLES;
+    const InverterSample* expected = &samples[samples.size() - SampleBlockWriter::BLOCK_SAMPLES];
+    for (size_t i = 0; same && i < block_samples.size(); i++) {
+        same = block_samples[i].timestamp_ms == expected[i].timestamp_ms &&
+               memcmp(block_samples[i].regs.raw, expected[i].regs.raw, sizeof(expected[i].regs.raw)) == 0;
+    }
+    printf("%-56s %9zu B JSON %6zu B rekord %8.1f B blok %s\n", "  bajtów na próbkę", json_bytes, wire_bytes,
+           double(block_bytes) / CODEC_N, same ? "" : "(BŁĄD DEKODOWANIA)");
+    recordValue("bajtów na próbkę: JSON", double(json_bytes), "B");
+    recordValue("bajtów na próbkę: rekord", double(wire_bytes), "B");
+    recordValue("bajtów na próbkę: blok", double(block_bytes) / CODEC_N, "B");
+    return same;
+}
+
+// Historia na dysku: dopisywanie próbek (z powiększaniem pliku) i odczyt zakresu jak /history
+static bool benchHistory() {
+    const int HISTORY_N = 200000, RANGE_N = 20000;
+    printf("\n=== Historia: %d próbek ===\n", HISTORY_N);
+    string path = tempPath("sun_bench_history");
+    if (path.empty()) return false;
+    TimeSeriesStore store;
+    if (!store.open(path)) {
+        fprintf(stderr, "Historia: %s\n", store.lastError().c_str());
+        unlink(path.c_str());
+        return false;
+    }
+    int next = 0;  // Rozgrzewka też dopisuje - czas musi rosnąć
+    runBench("TimeSeriesStore::append", HISTORY_N, [&](int) {
+        InverterSample s = makeSample(next++);
+        g_sink = store.append(s);
+    });
+    size_t total = store.size();
+    size_t points = 0;
+    runBench("TimeSeriesStore::range 1 h + moc", RANGE_N, [&](int i) {
+        int64_t from = store.at(size_t(i) * 7919 % (total - 400)).timestamp_ms;
+        auto range = store.range(from, from + 3600 * 1000);
+        double sum = 0;
+        for (size_t k = range.first; k < range.second; k++) sum += store.at(k).value(REG_ACTIVE_POWER);
+        points = range.second - range.first;
+        g_sink = size_t(sum);
+    });
+    printf("%-56s %12zu rekordów/zakres %6.1f MB pliku\n", "  odczyt", points,
+           double(total * sizeof(TimeSeriesRecord)) / 1e6);
+    recordValue("rekordów w zakresie 1 h", double(points), "rekordów");
+    bool ok = store.size() == size_t(next);
+    store.close();
+    unlink(path.c_str());
+    return ok;
+}
+
+// Wykres: okno 24 h, nowa próbka co klatkę (co 10 s czasu historii), kilka rozmiarów terminala
+static bool benchChart() {
+    const int64_t WINDOW_MS = 24 * 3600LL * 1000, STEP_MS = 10000;
+    struct Size {
+        int width, height;
+    };
+    for (Size size : {Size{80, 15}, Size{120, 20}, Size{200, 50}}) {
+        const int CHART_W = size.width, CHART_H = size.height;
+        const int64_t column_ms = WINDOW_MS / CHART_W;
+        for (int points : {1000, 100000}) {
+            printf("\n=== Klatka wykresu %dx%d, historia %d punktów ===\n", CHART_W, CHART_H, points);
+            int iterations = points > 10000 ? 500 : 5000;
+            int64_t t0 = 1750000000000LL;
+            string suffix = " " + to_string(CHART_W) + "x" + to_string(CHART_H) + ", " + to_string(points) + " pkt";
+            int64_t t = t0 + int64_t(points) * STEP_MS;
+
+            // Dotychczasowe rysowanie - punkt odniesienia tylko dla typowego terminala
+            if (CHART_W == 120) {
+                deque<double> history;
+                for (int i = 0; i < points; i++) history.push_back(dayPower(t0 + i * STEP_MS));
+                runBench(("legacy: kopia historii + sklejanie" + suffix).c_str(), iterations, [&](int) {
+                    history.pop_front();
+                    history.push_back(dayPower(t));
+                    t += STEP_MS;
+                    g_sink = legacy::chartFrame(history, CHART_W, CHART_H);
+                });
+            }
+
+            RollupEngine rollup;
+            for (int i = 0; i < points; i++) rollup.add(t0 + i * STEP_MS, dayPower(t0 + i * STEP_MS));
+            vector<ChartColumn> columns;
+            PowerChart chart;
+            t = t0 + int64_t(points) * STEP_MS;
+            uint64_t built_before = 0, rescales_before = 0;
+            runBench(("rollup + PowerChart (przyrostowo)" + suffix).c_str(), iterations, [&](int i) {
+                if (i == iterations / 10 + 1) {
+                    built_before = chart.columnsBuilt();  // Pomiar bez rozgrzewki
+                    rescales_before = chart.rescaleCount();
+                }
+                rollup.add(t, dayPower(t));
+                int64_t end_column = t / column_ms + 1;
+                rollup.chartColumns(end_column * column_ms, WINDOW_MS, CHART_W, columns);
+                chart.update(columns, CHART_H, end_column - CHART_W);
+                t += STEP_MS;
+                g_sink = chart.row(0).size();
+            });
+            double rebuilt = double(chart.columnsBuilt() - built_before) / iterations;
+            printf("%-56s %12.2f kolumn/klatkę %6llu przeskalowań\n", "  przeliczone kolumny", rebuilt,
+                   (unsigned long long)(chart.rescaleCount() - rescales_before));
+            recordValue(("przeliczone kolumny" + suffix).c_str(), rebuilt, "kolumn/klatkę");
+
+            PowerChart full;
+            runBench(("rollup + pełne przeliczenie" + suffix).c_str(), iterations, [&](int) {
+                int64_t end_column = t / column_ms + 1;
+                rollup.chartColumns(end_column * column_ms, WINDOW_MS, CHART_W, columns);
+                full = PowerChart();
+                full.update(columns, CHART_H, end_column - CHART_W);
+                g_sink = full.row(0).size();
+            });
+        }
+    }
+    return true;
+}
+
+// Stringi PV: dopisywanie pomiaru oraz statystyki i niedopasowanie okna 24 h dla całej
+// instalacji; odniesienie - te same statystyki po tablicy pomiarów (tablica struktur)
+static bool benchStrings() {
+    const int DEVICES = 24, WEAK_DEVICE = 5;
+    const int64_t STEP_MS = 10000, WINDOW_MS = 24 * 3600LL * 1000;
+    const int POINTS = int(WINDOW_MS / STEP_MS) + 1000;
+    printf("\n=== Stringi PV: %d urządzeń (%d stringów), okno 24 h ===\n", DEVICES,
+           DEVICES * PV_STRINGS_PER_DEVICE);
+    const int64_t t0 = 1750000000000LL;
+    // Prąd proporcjonalny do mocy; w jednym urządzeniu PV2 daje 80% prądu PV1
+    auto point = [&](int device, int i) {
+        StringPoint p;
+        p.timestamp_ms = t0 + int64_t(i) * STEP_MS;
+        double power = dayPower(p.timestamp_ms);
+        for (int k = 0; k < PV_STRINGS_PER_DEVICE; k++) {
+            p.voltage[k] = power > 0 ? float(350.0 - 4.0 * k + (i + device) % 7) : 0.0f;
+            p.current[k] = float(power / 700.0 * (device == WEAK_DEVICE && k == 1 ? 0.8 : 1.0));
+        }
+        p.input_power = float(power * 1.02);
+        return p;
+    };
+    vector<StringMonitor> monitors(DEVICES);
+    vector<vector<StringPoint>> points(DEVICES);
+    for (int d = 0; d < DEVICES; d++) {
+        points[d].reserve(POINTS);
+        for (int i = 0; i < POINTS; i++) {
+            monitors[d].add(point(d, i));
+            points[d].push_back(point(d, i));
+        }
+    }
+    int64_t to_ms = t0 + int64_t(POINTS) * STEP_MS, from_ms = to_ms - WINDOW_MS;
+
+    StringMonitor single;
+    int next = 0;  // Rozgrzewka też dopisuje - czas musi rosnąć
+    runBench("StringMonitor::add (bufor zawinięty)", 200000, [&](int) {
+        single.add(point(0, next++));
+        g_sink = single.size();
+    });
+
+    using Q = StringMonitor::Quantity;
+    StringMismatch weak;
+    float soa_mean = 0.0f;
+    runBench("SoA: niedopasowanie + statystyki kanałów, instalacja", 500, [&](int) {
+        for (int d = 0; d < DEVICES; d++) {
+            StringMismatch m = monitors[d].mismatch(from_ms, to_ms);
+            if (d == WEAK_DEVICE) weak = m;
+            for (int k = 0; k < StringMonitor::CHANNELS; k++) {
+                StringWindowStats st = monitors[d].stats(k, Q::CURRENT, from_ms, to_ms);
+                if (d == 0 && k == 0) soa_mean = st.mean;
+            }
+        }
+    });
+    // Te same zapytania po tablicy pomiarów: każde przejście czyta całe pomiary z krokiem struktury
+    auto aosStats = [](const vector<StringPoint>& pts, size_t first, auto&& value) {
+        double sum = 0.0;
+        float lo = numeric_limits<float>::infinity(), hi = -lo;
+        for (size_t i = first; i < pts.size(); i++) {
+            float x = value(pts[i]);
+            sum += x;
+            lo = min(lo, x);
+            hi = max(hi, x);
+        }
+        return StringWindowStats{uint32_t(pts.size() - first), float(sum / double(pts.size() - first)), lo, hi};
+    };
+    float aos_mean = 0.0f;
+    runBench("AoS: te same zapytania po vector<StringPoint>", 500, [&](int) {
+        for (int d = 0; d < DEVICES; d++) {
+            const vector<StringPoint>& pts = points[d];
+            size_t first = size_t(lower_bound(pts.begin(), pts.end(), from_ms,
+                                              [](const StringPoint& p, int64_t ts) { return p.timestamp_ms < ts; }) -
+                                  pts.begin());
+            float best = 0.0f, worst = numeric_limits<float>::infinity();
+            for (int k = 0; k < PV_STRINGS_PER_DEVICE; k++) {
+                if (aosStats(pts, first, [k](const StringPoint& p) { return p.voltage[k]; }).max <
+                    STRING_CONNECTED_MIN_VOLTAGE_V) continue;
+                float mean = aosStats(pts, first, [k](const StringPoint& p) { return p.current[k]; }).mean;
+                best = max(best, mean);
+                worst = min(worst, mean);
+            }
+            g_sink = size_t((best - worst) * 1000.0f);
+            for (int k = 0; k < PV_STRINGS_PER_DEVICE; k++) {
+                StringWindowStats st = aosStats(pts, first, [k](const StringPoint& p) { return p.current[k]; });
+                if (d == 0 && k == 0) aos_mean = st.mean;
+            }
+            g_sink = size_t(aosStats(pts, first, [](const StringPoint& p) {
+                return p.current[0] + p.current[1];
+            }).mean);
+        }
+    });
+
+    vector<float> columns(120);
+    runBench("StringMonitor::columnMeans 120 kolumn x 3 kanały", 5000, [&](int) {
+        for (int k = 0; k < StringMonitor::CHANNELS; k++) {
+            monitors[0].columnMeans(k, Q::CURRENT, from_ms, to_ms, int(columns.size()), columns.data());
+        }
+        g_sink = sparkline(columns.data(), int(columns.size()), 12.0f).size();
+    });
+    printf("%-56s %11.1f%% PV%d %6.1f MB historii\n", "  niedopasowanie słabego urządzenia", weak.ratio * 100.0,
+           weak.weakest + 1, double(DEVICES) * monitors[0].capacity() *
+           (sizeof(int64_t) + sizeof(float) * StringMonitor::CHANNELS * StringMonitor::QUANTITY_COUNT) / 1e6);
+    recordValue("niedopasowanie słabego urządzenia", weak.ratio * 100.0, "%");
+    return weak.weakest == 1 && fabs(weak.ratio - 0.2f) < 0.01f && fabs(soa_mean - aos_mean) < 1e-3f * aos_mean;
+}
+
+// Cykl odczytu przez loopback: zapytania planu przez ModbusTcpClient (jak HuaweiSun2000
+// w trybie domyślnym, bez libmodbus), dekodowanie i dokończenie próbki
+static bool benchPoll() {
+    const int POLL_N = 5000;
+    printf("\n=== Odczyt z lokalnego zastępcy Modbus TCP: %d cykli ===\n", POLL_N);
+    ModbusStandIn stand_in;
+    if (!stand_in.start(makeSample(0))) {
+        perror("Zastępca Modbus TCP");
+        return false;
+    }
+    RegisterPlan plan;
+    planRegisterGroups(plan, REG_GROUPS_POLLED);
+    plan.build();
+    RegisterDecoder decoder;
+    decoder.bind(plan);
+    vector<ModbusTcpClient::Request> requests(plan.blocks().size());
+    InverterSample s;
+    int failed = 0;
+    bool ok = true;
+    // Jedno połączenie - zastępca obsługuje jednego klienta, głębokość potoku zmienia się w locie
+    ModbusTcpClient client("127.0.0.1", stand_in.tcpPort(), 1000, ModbusTcpClient::DEFAULT_PIPELINE);
+    if (!client.connect()) {
+        perror("Połączenie z zastępcą");
+        return false;
+    }
+    for (int depth : {1, ModbusTcpClient::DEFAULT_PIPELINE}) {
+        string name = "odczyt planu: " + to_string(depth) + (depth == 1 ? " zapytanie" : " zapytania") +
+                      " w locie + dekodowanie";
+        runBench(name.c_str(), POLL_N, [&](int) {
+            auto& blocks = plan.blocks();
+            // Ograniczenie głębokości potoku: zapytania w porcjach po depth
+            for (size_t first = 0; first < blocks.size(); first += size_t(depth)) {
+                size_t n = min(blocks.size() - first, size_t(depth));
+                for (size_t i = first; i < first + n; i++) {
+                    requests[i].start = blocks[i].start;
+                    requests[i].count = blocks[i].count;
+                    requests[i].dest = plan.blockData(blocks[i]);
+                }
+                client.transact(1, requests.data() + first, n);
+            }
+            for (size_t i = 0; i < blocks.size(); i++) {
+                blocks[i].ok = requests[i].ok;
+                if (!requests[i].ok) failed++;
+            }
+            decoder.decode(plan, s.regs);
+            finishInverterSample(plan, decoder, REG_GROUPS_POLLED, 0, s);
+            g_sink = s.regs.raw[REG_ACTIVE_POWER];
+        });
+    }
+    ok = failed == 0 && s.regs.raw[REG_ACTIVE_POWER] == makeSample(0).regs.raw[REG_ACTIVE_POWER];
+    printf("%-56s %12zu zapytań/cykl %6d błędów %s\n", "  plan", requests.size(), failed,
+           ok ? "" : "(BŁĄD ODCZYTU)");
+    recordValue("zapytań na cykl", double(requests.size()), "zapytań");
+    client.close();
+    stand_in.stop();
+    return ok;
+}
+
+// Cały potok przy odtwarzaniu bez czekania: dekodowanie ramek, bilans energii,
+// analiza anomalii, JSON, historia na dysku i agregaty wykresu (bez FTXUI - rysowanie kolumn PowerChart)
+static bool benchReplay() {
+    const int REPLAY_N = 100000;
+    const int CHART_W = 120, CHART_H = 20;
+    const int64_t WINDOW_MS = 24 * 3600LL * 1000;
+    const int64_t column_ms = WINDOW_MS / CHART_W;
+    printf("\n=== Odtwarzanie zapisu ramek: %d próbek, tempo max ===\n", REPLAY_N);
+    string capture_path = tempPath("sun_bench_capture");
+    string history_path = tempPath("sun_bench_history");
+    if (capture_path.empty() || history_path.empty()) return false;
+    ReplaySource replay;
+    if (!writeCaptureFile(capture_path.c_str(), REPLAY_N) || !replay.open(capture_path, ReplayOptions{0.0})) {
+        fprintf(stderr, "Zapis ramek: %s\n", replay.lastError().c_str());
+        unlink(capture_path.c_str());
+        unlink(history_path.c_str());
+        return false;
+    }
+    EnergyAccountant energy;
+    AnomalyDetector detector;
+    AlarmEvent anomaly_events[AnomalyDetector::MAX_EVENTS];
+    SampleJsonWriter writer(false);
+    TimeSeriesStore history_store;
+    history_store.open(history_path);
+    RollupEngine rollup;
+    PowerChart chart;
+    vector<ChartColumn> columns;
+    mutex finish_mutex;
+    condition_variable finish_wake;
+    bool replay_done = false;
+    replay.setFinishCallback([&] {
+        lock_guard<mutex> lock(finish_mutex);
+        replay_done = true;
+        finish_wake.notify_all();
+    });
+    uint64_t allocs_before = g_allocations.load();
+    replay.start(1, [&](size_t, const InverterSample& s, bool ok) {
+        if (ok) {
+            energy.update(s);
+            detector.update(s, anomaly_events);
+        }
+        g_sink = writer.write(s, &energy.ledger()).size();
+        history_store.append(s);
+        rollup.add(s.timestamp_ms, s.get<REG_ACTIVE_POWER>());
+        int64_t end_column = s.timestamp_ms / column_ms + 1;
+        rollup.chartColumns(end_column * column_ms, WINDOW_MS, CHART_W, columns);
+        chart.update(columns, CHART_H, end_column - CHART_W);
+    });
+    {
+        unique_lock<mutex> lock(finish_mutex);
+        finish_wake.wait(lock, [&] { return replay_done; });
+    }
+    replay.stop();
+    double delivered = double(replay.samplesDelivered());
+    double seconds = replay.elapsedSeconds();
+    double ns_per_sample = seconds * 1e9 / delivered;
+    double allocs = double(g_allocations.load() - allocs_before) / delivered;
+    printf("%-56s %12.1f ns/op %10.2f alloc/op\n", "replay: ramka -> cały potok", ns_per_sample, allocs);
+    printf("%-56s %12.0f próbek/s %8.0f rekordów historii\n", "  przepustowość", delivered / seconds,
+           double(history_store.size()));
+    g_records.push_back({g_section, "replay: ramka -> cały potok", ns_per_sample, "ns/op", allocs});
+    recordValue("przepustowość odtwarzania", delivered / seconds, "próbek/s");
+    history_store.close();
+    unlink(capture_path.c_str());
+    unlink(history_path.c_str());
+    return true;
+}
+
+// --- Wyniki do porównań ---
+
+static string cpuModel() {
+    ifstream in("/proc/cpuinfo");
+    string line;
+    while (getline(in, line)) {
+        if (line.compare(0, 10, "model name") != 0) continue;
+        size_t colon = line.find(':');
+        if (colon != string::npos) return line.substr(line.find_first_not_of(" \t", colon + 1));
+    }
+    return "nieznany";
+}
+
+// Dopisuje przebieg jako jedną linię JSON: metadane kompilacji i wszystkie wyniki
+static bool appendResults(const string& path, const string& label, const string& sections) {
+    nlohmann::ordered_json run;
+    char time_buf[32];
+    time_t now = time(nullptr);
+    struct tm tm_local;
+    localtime_r(&now, &tm_local);
+    strftime(time_buf, sizeof(time_buf), "%Y-%m-%dT%H:%M:%S", &tm_local);
+    run["time"] = time_buf;
+    run["label"] = label;
+    run["compiler"] = __VERSION__;
+    run["flags"] = SUN_BENCH_FLAGS;
+    run["cpu"] = cpuModel();
+    run["sections"] = sections.empty() ? "wszystkie" : sections;
+    run["results"] = nlohmann::ordered_json::array();
+    for (const auto& r : g_records) {
+        nlohmann::ordered_json item;
+        item["section"] = r.section;
+        item["name"] = r.name;
+        item["value"] = r.value;
+        item["unit"] = r.unit;
+        if (r.allocs_per_op >= 0) item["allocs_per_op"] = r.allocs_per_op;
+        run["results"].push_back(move(item));
+    }
+    ofstream out(path, ios::app);
+    out << run.dump() << '\n';
+    out.flush();
+    if (!out) {
+        fprintf(stderr, "Nie można zapisać %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    printf("\nWyniki dopisane do %s (etykieta %s)\n", path.c_str(), label.c_str());
+    return true;
+}
+
+// Porównanie przebiegów z pliku --output: kolumna na etykietę z najnowszym wynikiem
+// każdego testu (przebiegi z --filter uzupełniają się), a przy jednej etykiecie -
+// dwa ostatnie przebiegi. Zmiana ostatniej kolumny względem pierwszej
+static bool compareResults(const string& path) {
+    ifstream in(path);
+    if (!in) {
+        fprintf(stderr, "Nie można otworzyć %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    vector<nlohmann::json> runs;
+    string line;
+    try {
+        while (getline(in, line)) {
+            if (!line.empty()) runs.push_back(nlohmann::json::parse(line));
+        }
+    } catch (const nlohmann::json::exception& e) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+        return false;
+    }
+    if (runs.empty()) {
+        fprintf(stderr, "%s: brak przebiegów\n", path.c_str());
+        return false;
+    }
+
+    struct Column {
+        string label;
+        string time;
+        vector<const nlohmann::json*> runs;  // Od najstarszego
+    };
+    vector<Column> columns;
+    for (const auto& run : runs) {
+        string label = run.value("label", string());
+        auto it = find_if(columns.begin(), columns.end(), [&](const Column& c) { return c.label == label; });
+        if (it == columns.end()) it = columns.insert(columns.end(), Column{label, string(), {}});
+        it->time = run.value("time", string());
+        it->runs.push_back(&run);
+    }
+    if (columns.size() == 1 && runs.size() > 1) {
+        Column previous{columns[0].label + " (poprz.)", runs[runs.size() - 2].value("time", string()),
+                        {&runs[runs.size() - 2]}};
+        columns[0].runs = {&runs.back()};
+        columns.insert(columns.begin(), previous);
+    }
+
+    // Wiersze w kolejności pierwszego wystąpienia; wartość - najnowsza w kolumnie
+    vector<pair<string, string>> rows;
+    vector<string> units;
+    for (const auto& c : columns) {
+        for (const auto* run : c.runs) {
+            for (const auto& r : (*run)["results"]) {
+                pair<string, string> key(r["section"].get<string>(), r["name"].get<string>());
+                if (find(rows.begin(), rows.end(), key) == rows.end()) {
+                    rows.push_back(key);
+                    units.push_back(r["unit"].get<string>());
+                }
+            }
+        }
+    }
+    auto valueOf = [](const Column& c, const pair<string, string>& key) {
+        double v = NAN;
+        for (const auto* run : c.runs) {
+            for (const auto& r : (*run)["results"]) {
+                if (r["section"] == key.first && r["name"] == key.second) v = r["value"].get<double>();
+            }
+        }
+        return v;
+    };
+
+    printf("%-56s %-14s", "", "");
+    for (const auto& c : columns) printf(" %19.19s", c.label.c_str());
+    printf(columns.size() > 1 ? " %9s\n" : "\n", "zmiana");
+    printf("%-56s %-14s", "", "");
+    for (const auto& c : columns) printf(" %19.19s", c.time.c_str());
+    printf("\n");
+    string section;
+    for (size_t row = 0; row < rows.size(); row++) {
+        const auto& key = rows[row];
+        if (key.first != section) {
+            section = key.first;
+            printf("[%s]\n", section.c_str());
+        }
+        printf("  %-54.54s %-14s", key.second.c_str(), units[row].c_str());
+        double first = NAN, last = NAN;
+        for (const auto& c : columns) {
+            double v = valueOf(c, key);
+            if (std::isnan(v)) {
+                printf(" %19s", "-");
+                continue;
+            }
+            printf(" %19.*f", fabs(v) < 100 ? 2 : 1, v);
+            if (std::isnan(first)) first = v;
+            last = v;
+        }
+        if (columns.size() > 1 && first > 0 && !std::isnan(valueOf(columns.back(), key)) &&
+            !std::isnan(valueOf(columns.front(), key))) {
+            printf(" %+8.1f%%", (last / first - 1.0) * 100.0);
+        }
+        printf("\n");
+    }
+    return true;
+}
+
+struct BenchSection {
+    const char* name;
+    bool (*run)();
+};
+
+static const BenchSection SECTIONS[] = {
+    {"json", benchJson},
+    {"decode", benchDecode},
+    {"codec", benchCodec},
+    {"history", benchHistory},
+    {"chart", benchChart},
+    {"strings", benchStrings},
+    {"poll", benchPoll},
+    {"replay", benchReplay},
+};
+
+static void printUsage(const char* program) {
+    printf("Użycie: %s [opcje]\n", program);
+    printf("  --filter json,chart   tylko wybrane sekcje:");
+    for (const auto& section : SECTIONS) printf(" %s", section.name);
+    printf("\n");
+    printf("  --output PLIK         dopisz wyniki jako linię JSON (do porównań między kompilacjami)\n");
+    printf("  --label NAZWA         etykieta przebiegu w PLIKU (np. bonnell, generic)\n");
+    printf("  --compare PLIK        porównaj ostatnie przebiegi każdej etykiety z PLIKU\n");
+}
+
+int main(int argc, char* argv[]) {
+    string filter, output, label = "default", compare;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) filter = argv[++i];
+        else if (arg == "--output" && has_value) output = argv[++i];
+        else if (arg == "--label" && has_value) label = argv[++i];
+        else if (arg == "--compare" && has_value) compare = argv[++i];
+        else {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+    }
+    if (!compare.empty()) return compareResults(compare) ? 0 : 1;
+
+    bool ok = true;
+    string filter_list = "," + filter + ",";
+    for (const auto& section : SECTIONS) {
+        if (!filter.empty() && filter_list.find(string(",") + section.name + ",") == string::npos) continue;
+        g_section = section.name;
+        if (!section.run()) {
+            fprintf(stderr, "Sekcja %s: błąd\n", section.name);
+            ok = false;
+        }
+    }
+    if (!output.empty() && !appendResults(output, label, filter)) ok = false;
+    return ok ? 0 : 1;
+}
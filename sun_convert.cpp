@@ -0,0 +1,350 @@
+// Konwersja zapisanych próbek między formatami eksportu:
+// - historia (TimeSeriesStore, --history sun_ftxui)
+// - JSON - pola jak w --output (obiekty jeden za drugim, linie z fifo: albo tablica)
+// - archiwum bloków kolumnowych (sample_codec.hpp)
+// - strumień rekordów binarnych (--json-format binary: varint długości + rekord)
+// Format wejścia jest rozpoznawany po nagłówku pliku (JSON i strumień rekordów
+// przez --from). Wartości JSON są zamieniane na liczby stałoprzecinkowe w skali
+// rejestru, więc JSON -> archiwum -> JSON odtwarza te same napisy.
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "energy_accounting.hpp"
+#include "sample_codec.hpp"
+#include "sample_json.hpp"
+#include "timeseries_store.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+
+enum class Format { Auto, History, Json, Archive, Wire };
+
+static Format parseFormat(const string& name) {
+    if (name == "history") return Format::History;
+    if (name == "json") return Format::Json;
+    if (name == "archive") return Format::Archive;
+    if (name == "wire") return Format::Wire;
+    return Format::Auto;
+}
+
+static const char* formatName(Format f) {
+    switch (f) {
+        case Format::History: return "historia";
+        case Format::Json: return "JSON";
+        case Format::Archive: return "archiwum";
+        case Format::Wire: return "rekordy binarne";
+        case Format::Auto: break;
+    }
+    return "?";
+}
+
+static bool isHistoryFile(const string& path) {
+    char magic[8] = {};
+    ifstream in(path, ios::binary);
+    return in.read(magic, sizeof(magic)) && memcmp(magic, "SUNTSDB", 8) == 0;
+}
+
+using SampleCallback = function<bool(const InverterSample&)>;
+
+// --- Wejście ---
+
+static bool readHistory(const string& path, const SampleCallback& emit) {
+    TimeSeriesStore store;
+    if (!store.open(path, true)) {
+        cerr << store.lastError() << endl;
+        return false;
+    }
+    InverterSample s;
+    for (size_t i = 0; i < store.size(); i++) {
+        const TimeSeriesRecord& rec = store.at(i);
+        if (!rec.intact()) continue;
+        rec.toSample(s);
+        if (!emit(s)) return false;
+    }
+    return true;
+}
+
+static bool readArchive(const string& path, const SampleCallback& emit) {
+    SampleArchiveReader reader;
+    if (!reader.open(path)) {
+        cerr << reader.lastError() << endl;
+        return false;
+    }
+    vector<InverterSample> block;
+    size_t offset = 0;
+    while (reader.next(offset, block)) {
+        for (const auto& s : block) {
+            if (!emit(s)) return false;
+        }
+    }
+    if (offset < reader.fileSize()) cerr << "Pominięto ogon archiwum: " << reader.lastError() << endl;
+    return true;
+}
+
+static bool readWire(const string& path, const SampleCallback& emit) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        cerr << "Nie można otworzyć " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data());
+    const uint8_t* end = p + data.size();
+    SampleWireReader reader;
+    InverterSample s;
+    while (p < end) {
+        uint64_t length;
+        if (!readVarint(p, end, length) || length > uint64_t(end - p) || reader.read(p, size_t(length), s) == 0) {
+            cerr << "Uszkodzony rekord na pozycji " << (p - reinterpret_cast<const uint8_t*>(data.data())) << endl;
+            return true;
+        }
+        p += length;
+        if (!emit(s)) return false;
+    }
+    return true;
+}
+
+// Liczba albo napis z liczbą (wartości ułamkowe w --output są napisami)
+static bool jsonNumber(const json& v, double& out) {
+    if (v.is_number()) {
+        out = v.get<double>();
+        return true;
+    }
+    if (!v.is_string()) return false;
+    const string& text = v.get_ref<const string&>();
+    char* end = nullptr;
+    out = strtod(text.c_str(), &end);
+    return end != text.c_str();
+}
+
+static void copyText(const json& j, const char* key, char* out, size_t size) {
+    auto it = j.find(key);
+    if (it != j.end() && it->is_string()) snprintf(out, size, "%s", it->get_ref<const string&>().c_str());
+}
+
+static bool sampleFromJson(const json& j, InverterSample& s, DescriptorCache& descriptors) {
+    s = InverterSample();
+    auto ts = j.find("timestamp");
+    if (ts == j.end() || !ts->is_string()) return false;
+    struct tm tm_local = {};
+    if (strptime(ts->get_ref<const string&>().c_str(), "%Y-%m-%d %H:%M:%S", &tm_local) == nullptr) return false;
+    tm_local.tm_isdst = -1;
+    s.timestamp_ms = int64_t(mktime(&tm_local)) * 1000;
+
+    for (const auto& desc : REGISTER_MAP) {
+        auto it = j.find(desc.key);
+        double v;
+        if (desc.type == RegType::STR || it == j.end() || !jsonNumber(*it, v)) continue;
+        setCodecValue(s, desc.id, codecRaw(desc.id, llround(v * desc.divider)), true);
+    }
+
+    DeviceDescriptor d;
+    copyText(j, "model", d.model, sizeof(d.model));
+    copyText(j, "sn", d.sn, sizeof(d.sn));
+    copyText(j, "firmware_version", d.firmware_version, sizeof(d.firmware_version));
+    if (s.regs.has(REG_RATED_POWER)) fillDescriptorValues(d, s.regs);
+    s.device = descriptors.intern(d);
+
+    double v;
+    if (j.contains("ping_ms") && jsonNumber(j["ping_ms"], v)) s.ping_ms = int16_t(v);
+    if (j.contains("poll_round_trips") && jsonNumber(j["poll_round_trips"], v)) s.poll.round_trips = int(v);
+    if (j.contains("poll_time_ms") && jsonNumber(j["poll_time_ms"], v)) s.poll.wall_ms = v;
+    return true;
+}
+
+static bool readJson(const string& path, const SampleCallback& emit) {
+    ifstream in(path);
+    if (!in) {
+        cerr << "Nie można otworzyć " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    DescriptorCache descriptors;
+    InverterSample s;
+    size_t skipped = 0;
+    auto one = [&](const json& j) {
+        if (j.is_object() && sampleFromJson(j, s, descriptors)) return emit(s);
+        skipped++;
+        return true;
+    };
+    try {
+        // Obiekty jeden za drugim (linie z fifo:, kolejne zrzuty --output) albo jedna tablica
+        while (in >> ws && in.peek() != EOF) {
+            json j;
+            in >> j;
+            if (j.is_array()) {
+                for (const auto& item : j) {
+                    if (!one(item)) return false;
+                }
+            } else if (!one(j)) {
+                return false;
+            }
+        }
+    } catch (const json::exception& e) {
+        cerr << "Błąd JSON: " << e.what() << endl;
+        return false;
+    }
+    if (skipped > 0) cerr << "Pominięto " << skipped << " obiektów bez pola timestamp" << endl;
+    return true;
+}
+
+// --- Wyjście ---
+
+class SampleOutput {
+private:
+    Format format;
+    FILE* file = nullptr;
+    SampleArchiveWriter archive;
+    TimeSeriesStore history;
+    SampleJsonWriter json_writer;
+    SampleWireWriter wire_writer;
+    // Bilans energii jak w --output (pola energy_*), osobno dla każdego urządzenia
+    map<const DeviceDescriptor*, unique_ptr<EnergyAccountant>> energy;
+    string length_prefix;
+
+public:
+    SampleOutput(Format f, bool pretty) : format(f), json_writer(pretty) {}
+    ~SampleOutput() { close(); }
+
+    bool open(const string& path) {
+        switch (format) {
+            case Format::Archive:
+                if (archive.open(path, true)) return true;
+                cerr << archive.lastError() << endl;
+                return false;
+            case Format::History:
+                if (history.open(path)) return true;
+                cerr << history.lastError() << endl;
+                return false;
+            default:
+                file = path == "-" ? stdout : fopen(path.c_str(), "wb");
+                if (file != nullptr) return true;
+                cerr << "Nie można otworzyć " << path << ": " << strerror(errno) << endl;
+                return false;
+        }
+    }
+
+    bool write(const InverterSample& s) {
+        switch (format) {
+            case Format::Archive:
+                if (archive.append(s)) return true;
+                cerr << archive.lastError() << endl;
+                return false;
+            case Format::History:
+                if (history.append(s)) return true;
+                cerr << history.lastError() << endl;
+                return false;
+            case Format::Json: {
+                auto& accountant = energy[s.device];
+                if (!accountant) accountant = make_unique<EnergyAccountant>();
+                if (s.regs.valid.any()) accountant->update(s);
+                const string& body = json_writer.write(s, &accountant->ledger());
+                fwrite(body.data(), 1, body.size(), file);
+                return fputc('\n', file) != EOF;
+            }
+            case Format::Wire: {
+                const string& record = wire_writer.write(s);
+                length_prefix.clear();
+                appendVarint(length_prefix, record.size());
+                fwrite(length_prefix.data(), 1, length_prefix.size(), file);
+                return fwrite(record.data(), 1, record.size(), file) == record.size();
+            }
+            case Format::Auto: break;
+        }
+        return false;
+    }
+
+    void close() {
+        archive.close();
+        history.close();
+        if (file != nullptr && file != stdout) fclose(file);
+        else if (file != nullptr) fflush(file);
+        file = nullptr;
+    }
+};
+
+static long long fileSize(const string& path) {
+    struct stat st;
+    return ::stat(path.c_str(), &st) == 0 ? (long long)st.st_size : -1;
+}
+
+int main(int argc, char* argv[]) {
+    Format from = Format::Auto, to = Format::Auto;
+    bool pretty = false;
+    vector<string> paths;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--from" && i + 1 < argc) {
+            from = parseFormat(argv[++i]);
+        } else if (arg == "--to" && i + 1 < argc) {
+            to = parseFormat(argv[++i]);
+        } else if (arg == "--pretty") {
+            pretty = true;
+        } else if (arg == "--help") {
+            cout << "Użycie: " << argv[0] << " [opcje] <wejście> <wyjście>" << endl;
+            cout << "  --from <f>   Format wejścia: json lub wire (historia i archiwum rozpoznawane z nagłówka)" << endl;
+            cout << "  --to <f>     Format wyjścia: archive, json, wire lub history" << endl;
+            cout << "               (domyślnie: archive, dla archiwum na wejściu: json)" << endl;
+            cout << "  --pretty     JSON z wcięciami jak --output (domyślnie jeden obiekt w linii)" << endl;
+            cout << "Archiwum i JSON są zapisywane od nowa, historia jest uzupełniana." << endl;
+            cout << "Wyjście \"-\" - standardowe wyjście (json, wire)" << endl;
+            return 0;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2) {
+        cerr << "Podaj plik wejściowy i wyjściowy (--help)" << endl;
+        return 1;
+    }
+    const string& input = paths[0];
+    const string& output = paths[1];
+
+    if (SampleArchiveReader::detect(input)) from = Format::Archive;
+    else if (isHistoryFile(input)) from = Format::History;
+    else if (from == Format::Auto) from = Format::Json;
+    if (to == Format::Auto) to = from == Format::Archive ? Format::Json : Format::Archive;
+    if ((to == Format::Archive || to == Format::History) && output == "-") {
+        cerr << "Archiwum i historia wymagają pliku wyjściowego" << endl;
+        return 1;
+    }
+
+    SampleOutput out(to, pretty);
+    if (!out.open(output)) return 1;
+    size_t samples = 0;
+    SampleCallback emit = [&](const InverterSample& s) {
+        samples++;
+        return out.write(s);
+    };
+    bool ok = false;
+    switch (from) {
+        case Format::History: ok = readHistory(input, emit); break;
+        case Format::Archive: ok = readArchive(input, emit); break;
+        case Format::Wire: ok = readWire(input, emit); break;
+        default: ok = readJson(input, emit); break;
+    }
+    out.close();
+    if (!ok) return 1;
+
+    long long in_size = fileSize(input);
+    long long out_size = output == "-" ? -1 : fileSize(output);
+    fprintf(stderr, "%s -> %s: %zu próbek, %lld B -> %lld B", formatName(from), formatName(to), samples,
+            in_size, out_size);
+    if (samples > 0 && in_size > 0 && out_size > 0) {
+        fprintf(stderr, " (%.1f -> %.1f B/próbkę)", double(in_size) / samples, double(out_size) / samples);
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
@@ -1,6 +1,4 @@
 #include <iostream>
-#include <modbus/modbus.h>
-#include <nlohmann/json.hpp>
 #include <fstream>
 #include <chrono>
 #include <iomanip>
@@ -8,8 +6,32 @@
 #include <cstring>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <deque>
+#include <csignal>
+#include <unistd.h>
+
+#include "alarm_decoder.hpp"
+#include "anomaly_detector.hpp"
+#include "device_feed.hpp"
+#include "energy_accounting.hpp"
+#include "frame_capture.hpp"
+#include "http_api.hpp"
+#include "http_server.hpp"
+#include "huawei_sun2000.hpp"
+#include "inverter_sample.hpp"
+#include "json_publisher.hpp"
+#include "metrics.hpp"
+#include "polling_engine.hpp"
+#include "power_chart.hpp"
+#include "register_map.hpp"
+#include "register_planner.hpp"
+#include "replay_source.hpp"
+#include "rollup.hpp"
+#include "snapshot.hpp"
+#include "string_monitor.hpp"
+#include "timeseries_store.hpp"
 
 // FTXUI includes
 #include "ftxui/component/captured_mouse.hpp"
@@ -20,7 +42,6 @@
 
 
 
-using json = nlohmann::ordered_json;
 using namespace std;
 using namespace ftxui;
 
@@ -28,31 +49,6 @@ using namespace ftxui;
 // using ftxui::Signal;
 // using ftxui::Ref;
 
-// Struktura do przechowywania danych invertera (bez mutexów)
-struct InverterData {
-    string timestamp = "N/A";
-    string model = "N/A";
-    string sn = "N/A";
-    string firmware_version = "N/A";
-    string device_status = "N/A";
-    double active_power = 0.0;
-    double input_power = 0.0;
-    double efficiency = 0.0;
-    double temperature = 0.0;
-    double daily_energy = 0.0;
-    double total_energy = 0.0;
-    double frequency = 0.0;
-    double phase_A_voltage = 0.0;
-    double phase_B_voltage = 0.0;
-    double phase_C_voltage = 0.0;
-    double phase_A_current = 0.0;
-    double phase_B_current = 0.0;
-    double phase_C_current = 0.0;
-    int wifi_signal = -65;
-    int ping_ms = 0;
-    string last_error = "";
-};
-
 // Funkcja pomocnicza do formatowania liczby do 1 miejsca po przecinku
 inline std::string to_fixed_1(double val) {
     std::ostringstream oss;
@@ -67,305 +63,228 @@ inline std::string to_fixed_2(double val) {
     return oss.str();
 }
 
-class HuaweiSun2000 {
-private:
-    modbus_t *mb;
-    string ip_address;
-    int port;
-    
-public:
-    HuaweiSun2000(const string& ip, int p = 6607) : mb(nullptr), ip_address(ip), port(p) {}
-    
-    ~HuaweiSun2000() { 
-        disconnect();
-    }
-    
-    bool connect() {
-        mb = modbus_new_tcp(ip_address.c_str(), port);
-        if (mb == nullptr) {
-            return false;
-        }
-        
-        modbus_set_response_timeout(mb, 5, 0);
-        modbus_set_slave(mb, 0);
-        
-        if (modbus_connect(mb) == -1) {
-            modbus_free(mb);
-            mb = nullptr;
-            return false;
-        }
-        
-        return true;
-    }
-    
-    void disconnect() {
-        if (mb != nullptr) {
-            modbus_close(mb);
-            modbus_free(mb);
-            mb = nullptr;
-        }
-    }
-    
-    uint16_t readHoldingRegister(int address) {
-        uint16_t value;
-        if (modbus_read_registers(mb, address, 1, &value) == -1) {
-            return 0;
-        }
-        return value;
-    }
-    
-    uint32_t readHoldingRegister32(int address) {
-        uint16_t values[2];
-        if (modbus_read_registers(mb, address, 2, values) == -1) {
-            return 0;
-        }
-        return (uint32_t(values[0]) << 16) | values[1];
-    }
-    
-    json readInverterData() {
-        json data;
-        
-        try {
-            // Timestamp
-            auto now = chrono::system_clock::now();
-            auto time_t = chrono::system_clock::to_time_t(now);
-            stringstream ss;
-            ss << put_time(localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-            data["timestamp"] = ss.str();
-            
-            // Model
-            data["model"] = "SUN2000-8KTL-M1";
-            
-            // Device status
-            uint16_t state = readHoldingRegister(32089);
-            string device_status = "Nieznany (" + to_string(state) + ")";
-            
-            switch(state) {
-                case 0x0000: device_status = "Standby: inicjalizacja"; break;
-                case 0x0200: device_status = "On-grid"; break;
-                case 0x0201: device_status = "On-grid: moc ograniczona"; break;
-                case 0x0300: device_status = "Wyłączony: błąd"; break;
-                case 0x0308: device_status = "Wyłączony: mała moc wejściowa"; break;
-                case 0xA000: device_status = "Standby: brak napromieniowania"; break;
-            }
-            data["device_status"] = device_status;
-            
-            // Podstawowe parametry
-            uint16_t temperature = readHoldingRegister(32087);
-            data["internal_temperature"] = to_fixed_1(temperature * 0.1);
-            
-            uint32_t daily_energy = readHoldingRegister32(32114);
-            data["daily_yield_energy"] = to_fixed_2(daily_energy * 0.01);
-            
-            uint32_t total_energy = readHoldingRegister32(32106);
-            data["accumulated_energy_yield"] = to_fixed_2(total_energy * 0.01);
-            
-            uint32_t active_power = readHoldingRegister32(32080);
-            data["active_power"] = to_fixed_1((double)active_power);
-            
-            uint32_t input_power = readHoldingRegister32(32064);
-            data["input_power"] = to_fixed_1((double)input_power);
-            
-            uint16_t efficiency_reg = readHoldingRegister(32086);
-            data["efficiency"] = to_fixed_2(efficiency_reg * 0.01);
-            
-            // Częstotliwość sieci
-            uint16_t grid_frequency = readHoldingRegister(32085);
-            if (grid_frequency == 0) {
-                grid_frequency = readHoldingRegister(37118);
-            }
-            
-            double frequency_hz = grid_frequency / 100.0;
-            if (frequency_hz < 45.0 || frequency_hz > 65.0) {
-                data["grid_frequency"] = "0.00";
-            } else {
-                data["grid_frequency"] = to_fixed_2(frequency_hz);
-            }
-            
-            // Napięcia fazowe
-            uint16_t ac_voltage_a = readHoldingRegister(32069);
-            data["phase_A_voltage"] = to_fixed_1(ac_voltage_a * 0.1);
-            
-            uint16_t ac_voltage_b = readHoldingRegister(32070);
-            data["phase_B_voltage"] = to_fixed_1(ac_voltage_b * 0.1);
-            
-            uint16_t ac_voltage_c = readHoldingRegister(32071);
-            data["phase_C_voltage"] = to_fixed_1(ac_voltage_c * 0.1);
-            
-            // Prądy fazowe
-            int32_t ac_current_a = (int32_t)readHoldingRegister32(32072);
-            data["phase_A_current"] = to_fixed_2(ac_current_a / 1000.0);
-            
-            int32_t ac_current_b = (int32_t)readHoldingRegister32(32074);
-            data["phase_B_current"] = to_fixed_2(ac_current_b / 1000.0);
-            
-            int32_t ac_current_c = (int32_t)readHoldingRegister32(32076);
-            data["phase_C_current"] = to_fixed_2(ac_current_c / 1000.0);
-            
-            // Dummy values
-            data["sn"] = "HV1234567890";
-            data["firmware_version"] = "V100R001C00";
-            data["wifi_signal_dbm"] = -65;
-            data["ping_ms"] = 15;
-            
-        } catch (const exception& e) {
-            data["error"] = e.what();
-        }
-        
-        return data;
+// Formatowanie z liczbą miejsc po przecinku z mapy rejestrów
+inline std::string to_fixed(double val, int decimals) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(decimals) << val;
+    return oss.str();
+}
+
+// Kolor stanu łącza w pasku stanu i tabeli instalacji
+static Color linkHealthColor(LinkHealth health) {
+    switch (health) {
+        case LinkHealth::Healthy: return Color::Green;
+        case LinkHealth::Degraded:
+        case LinkHealth::Connecting:
+        case LinkHealth::Reconnecting: return Color::Yellow;
+        case LinkHealth::Offline: break;
     }
+    return Color::Red;
+}
+
+// Okna czasowe wykresu przełączane klawiszami '+'/'-'
+struct ChartWindow {
+    const char* name;
+    int64_t ms;
 };
 
-// Funkcja do zapisu danych JSON do pliku
-void saveJsonToFile(const json& data, const string& filename) {
-    try {
-        ofstream file(filename);
-        if (file.is_open()) {
-            file << data.dump(2); // 2 spacje wcięcia dla czytelności
-            file.close();
+static const ChartWindow CHART_WINDOWS[] = {
+    {"1h", 3600LL * 1000},
+    {"6h", 6 * 3600LL * 1000},
+    {"24h", 24 * 3600LL * 1000},
+    {"7d", 7 * 24 * 3600LL * 1000},
+    {"30d", 30 * 24 * 3600LL * 1000},
+};
+static const int CHART_WINDOW_COUNT = int(sizeof(CHART_WINDOWS) / sizeof(CHART_WINDOWS[0]));
+
+// Liczba ostatnich zdarzeń w panelu (pełny dziennik w pliku --events)
+static const size_t EVENT_PANEL_ROWS = 5;
+
+// Czytelny opis odstępu czasu ("10s", "15min", "6h", "2d")
+string formatSpan(int64_t ms) {
+    int64_t s = ms / 1000;
+    if (s % 86400 == 0 && s >= 86400) return to_string(s / 86400) + "d";
+    if (s % 3600 == 0 && s >= 3600) return to_string(s / 3600) + "h";
+    if (s % 60 == 0 && s >= 60) return to_string(s / 60) + "min";
+    return to_string(s) + "s";
+}
+
+// Czas w mikrosekundach jako "850 µs" / "12.3 ms" / "5.0 s"
+string formatMicros(uint64_t us) {
+    if (us < 1000) return to_string(us) + " µs";
+    if (us < 1000000) return to_fixed_1(double(us) / 1000.0) + " ms";
+    return to_fixed_1(double(us) / 1e6) + " s";
+}
+
+// Wiersz panelu diagnostyki: liczba pomiarów i percentyle
+ftxui::Element histogramRow(const string& name, const LatencyHistogram::Snapshot& h) {
+    return hbox(Elements{
+        text(name) | size(WIDTH, EQUAL, 16),
+        text("n=" + to_string(h.count)) | size(WIDTH, EQUAL, 12) | color(Color::White),
+        text("p50 " + formatMicros(h.percentileUs(50))) | size(WIDTH, EQUAL, 16) | color(Color::Green),
+        text("p99 " + formatMicros(h.percentileUs(99))) | size(WIDTH, EQUAL, 16) | color(Color::Yellow),
+        text("max " + formatMicros(h.max_us)) | size(WIDTH, EQUAL, 16) | color(Color::Red),
+    });
+}
+
+// Klucz pamięci podręcznej z kilku wartości (mieszanie jak w boost::hash_combine)
+template <typename... Args>
+uint64_t cacheKey(Args... args) {
+    uint64_t key = 0;
+    for (uint64_t v : {uint64_t(args)...}) key ^= v + 0x9e3779b97f4a7c15ULL + (key << 6) + (key >> 2);
+    return key;
+}
+
+// Fragment ekranu budowany ponownie tylko po zmianie klucza (danych, od których zależy);
+// w pozostałych klatkach FTXUI dostaje ten sam gotowy element
+struct CachedElement {
+    uint64_t key = 0;
+    ftxui::Element element;
+
+    template <typename Build>
+    ftxui::Element get(uint64_t new_key, Build build) {
+        if (!element || new_key != key) {
+            element = build();
+            key = new_key;
         }
-    } catch (const exception& e) {
-        // W przypadku błędu, kontynuuj działanie
-        cerr << "Błąd zapisu JSON: " << e.what() << endl;
+        return element;
     }
-}
+};
 
-// Funkcja wykresu dostosowująca się do rozmiaru okna z blokami Unicode
-ftxui::Element drawPowerChartFromHistory(const std::deque<double>& history) {
-    if (history.empty()) {
-        return text("Brak danych historycznych") | center | color(Color::Yellow);
+// Wykres mocy z gotowych wierszy PowerChart (przeliczanych przyrostowo).
+// Kolumny pochodzą z agregatów (rollup), więc koszt nie zależy od długości historii.
+// Wysokość słupka to maksimum kolumny - krótkie szczyty mocy pozostają widoczne.
+// rated_power_w - moc nominalna urządzenia (0 - nieznana) dla progów kolorów.
+ftxui::Element drawPowerChart(const PowerChart& chart, const ChartWindow& window, int64_t resolution_ms,
+                              double rated_power_w) {
+    if (chart.samples() == 0) {
+        return text("Brak danych historycznych (okno " + string(window.name) + ")") | center |
+            color(Color::Yellow);
     }
-    
-    // Pobierz rozmiar terminala
-    auto screen_size = Terminal::Size();
-    int terminal_width = screen_size.dimx;
-    int terminal_height = screen_size.dimy;
-    
-    // Oblicz rozmiar wykresu (pozostaw miejsce na UI)
-    int chart_width = max(20, terminal_width - 15);  // 15 znaków na etykiety Y i marginesy
-    int chart_height = max(8, terminal_height / 3);   // 1/3 wysokości terminala
-    
-    double max_power = *max_element(history.begin(), history.end());
-    if (max_power <= 0) max_power = 1.0; // Unikaj dzielenia przez 0
-    
+    double max_power = chart.dataMaxPower();
+    int chart_width = chart.width();
+
     vector<Element> rows;
-    
+    rows.reserve(size_t(chart.height()) + 3);
+
     // Tytuł
     auto title_row = hbox(vector<Element>{
         text("WYKRES MOCY") | bold | color(Color::Yellow),
         text(" | Max: ") | color(Color::White),
         text(to_fixed_1(max_power) + "W") | color(Color::Red) | bold,
-        text(" | Punktów: ") | color(Color::White),
-        text(to_string(history.size())) | color(Color::Cyan),
+        text(" | Okno: ") | color(Color::White),
+        text(window.name) | color(Color::Cyan),
+        text(" | Poziom: ") | color(Color::White),
+        text(formatSpan(resolution_ms)) | color(Color::Cyan),
+        text(" | Próbek: ") | color(Color::White),
+        text(to_string(chart.samples())) | color(Color::Cyan),
     });
     rows.push_back(title_row | center);
-    
-    // Przygotuj dane do wyświetlenia
-    vector<double> display_data(chart_width, 0.0);
-    vector<bool> has_data(chart_width, false);
-    
-    // Mapuj dane na szerokość wykresu
-    int data_size = history.size();
-    if (data_size > 0) {
-        for (int i = 0; i < chart_width; i++) {
-            int data_idx = (i * data_size) / chart_width;
-            if (data_idx < data_size) {
-                display_data[i] = history[data_idx];
-                has_data[i] = true;
-            }
-        }
-    }
-    
-    // Rysuj wykres używając bloków Unicode
-    for (int y = chart_height - 1; y >= 0; y--) {
-        double threshold = (double(y + 1) / chart_height) * max_power;
-        
-        vector<Element> line;
-        
-        // Etykieta osi Y
-        stringstream ylabel;
-        ylabel << setw(6) << fixed << setprecision(0) << threshold << "W";
-        line.push_back(text(ylabel.str()) | color(Color::Cyan));
-        line.push_back(text("│") | color(Color::Cyan));
-        
-        // Punkty wykresu z blokami Unicode
-        string chart_line;
-        for (int x = 0; x < chart_width; x++) {
-            if (has_data[x]) {
-                double value = display_data[x];
-                double ratio = value / max_power;
-                double y_pos = (double(y) / chart_height);
-                
-                if (ratio >= y_pos + (1.0 / chart_height)) {
-                    // Pełny blok
-                    chart_line += "█";
-                } else if (ratio >= y_pos + (0.75 / chart_height)) {
-                    // 3/4 bloku
-                    chart_line += "▊";
-                } else if (ratio >= y_pos + (0.5 / chart_height)) {
-                    // Połowa bloku
-                    chart_line += "▌";
-                } else if (ratio >= y_pos + (0.25 / chart_height)) {
-                    // 1/4 bloku
-                    chart_line += "▎";
-                } else if (ratio > y_pos) {
-                    // Cienka linia
-                    chart_line += "▏";
-                } else {
-                    chart_line += " ";
-                }
-            } else {
-                chart_line += " ";
-            }
-        }
-        
-        auto chart_color = Color::Green;
-        if (max_power > 5000) chart_color = Color::Red;      // Wysokie obciążenie
-        else if (max_power > 3000) chart_color = Color::Yellow; // Średnie obciążenie
-        
-        line.push_back(text(chart_line) | color(chart_color));
-        rows.push_back(hbox(move(line)));
+
+    // Progi obciążenia względem mocy nominalnej (bez identyfikacji - dawne 5000/3000 W)
+    double high_w = rated_power_w > 0 ? rated_power_w * 0.6 : 5000.0;
+    double medium_w = rated_power_w > 0 ? rated_power_w * 0.35 : 3000.0;
+    auto chart_color = Color::Green;
+    if (max_power > high_w) chart_color = Color::Red;             // Wysokie obciążenie
+    else if (max_power > medium_w) chart_color = Color::Yellow;   // Średnie obciążenie
+
+    // Wiersze z etykietą osi Y
+    for (int i = 0; i < chart.height(); i++) {
+        rows.push_back(hbox(Elements{
+            text(chart.label(i)) | color(Color::Cyan),
+            text("│") | color(Color::Cyan),
+            text(chart.row(i)) | color(chart_color)
+        }));
     }
-    
+
     // Oś X
-    string bottom_line = "      └" + string(chart_width, '-') + "┘";
-    rows.push_back(text(bottom_line) | color(Color::Cyan));
-    
-    // Etykiety czasu
-    auto now = chrono::system_clock::now();
+    rows.push_back(text(chart.xAxis()) | color(Color::Cyan));
+
+    // Etykiety czasu - cztery odcinki okna
     vector<Element> time_labels;
     time_labels.push_back(text("        ") | color(Color::Cyan)); // Offset dla etykiet Y
-    
+
     for (int i = 0; i <= 4; i++) {
-        auto label_time = now - chrono::hours(6 * (4-i)); // Odwróć kolejność
-        auto label_time_t = chrono::system_clock::to_time_t(label_time);
-        auto label_tm = localtime(&label_time_t);
-        
-        stringstream label;
-        if (i == 4) {
-            label << "TERAZ";
-        } else {
-            label << "-" << (6 * (4-i)) << "h";
-        }
-        
-        int pos = (i * chart_width) / 4;
+        string label = i == 4 ? "TERAZ" : "-" + formatSpan(window.ms * (4 - i) / 4);
         if (i > 0) {
-            int spacing = (chart_width / 4) - 4; // -4 dla długości etykiety
+            int spacing = (chart_width / 4) - int(label.size());
             time_labels.push_back(text(string(max(1, spacing), ' ')) | color(Color::Cyan));
         }
-        time_labels.push_back(text(label.str()) | color(Color::Cyan));
+        time_labels.push_back(text(label) | color(Color::Cyan));
     }
-    
+
     rows.push_back(hbox(move(time_labels)));
-    
+
     return vbox(move(rows));
 }
 
+// Stan urządzenia po stronie interfejsu (tylko wątek UI)
+struct DeviceView {
+    DeviceSnapshot current;
+    uint64_t version = 0;       // Wersja ostatnio skopiowanej próbki
+    RollupEngine power_rollup;  // Agregaty mocy dla wykresu (10 s / 1 min / 10 min / 1 h)
+    AlarmEventLog<64> events;   // Ostatnie zmiany stanów i alarmów
+    StringMonitor strings;      // Historia stringów PV (struktura tablic)
+
+    // Pobiera nowe dane, jeśli są; koszt nie zależy od długości historii
+    void refresh(DeviceFeed& feed) {
+        if (feed.latest.version() != version) version = feed.latest.load(current);
+        PowerPoint p;
+        while (feed.power.pop(p)) power_rollup.add(p.timestamp_ms, p.power_w);
+        StringPoint sp;
+        while (feed.strings.pop(sp)) strings.add(sp);
+        AlarmEvent e;
+        while (feed.events.pop(e)) events.push(e);
+    }
+};
+
+// Wyjścia urządzenia - używane tylko przez wątek, który akurat odczytuje to urządzenie
+struct DeviceOutputs {
+    unique_ptr<JsonPublisher> publisher;
+    TimeSeriesStore history_store;
+    mutex history_mutex;      // Dopisywanie (wątek odczytu) a zakresy dla serwera HTTP
+    DeviceSnapshot snapshot;  // Bufor roboczy publikacji
+    AlarmDecoder alarms;      // Porównanie rejestrów bitowych z poprzednią próbką
+    AnomalyDetector anomalies;  // Asymetria faz, sprawność, częstotliwość, ograniczenie mocy
+    AlarmEvent alarm_events[AlarmDecoder::MAX_EVENTS + AnomalyDetector::MAX_EVENTS];
+    EnergyAccountant energy;  // Bilans produkcji (godziny, doby, miesiące)
+};
+
+static const int HTTP_DEFAULT_PORT = 8080;
+
+// "[adres:]port" -> adres i port (domyślnie tylko localhost)
+bool parseListenAddress(const string& spec, string& address, int& port) {
+    size_t colon = spec.rfind(':');
+    address = colon == string::npos ? "127.0.0.1" : spec.substr(0, colon);
+    string port_text = colon == string::npos ? spec : spec.substr(colon + 1);
+    char* end = nullptr;
+    long value = strtol(port_text.c_str(), &end, 10);
+    if (port_text.empty() || *end != '\0' || value < 1 || value > 65535) return false;
+    port = int(value);
+    return true;
+}
+
 int main(int argc, char* argv[]) {
     string ip = "10.88.45.1";
     int port = 6607;
-    string output_file = "/var/www/html/dane.json";
+    PublisherConfig publisher_config;
     int interval = 10;
+    DeviceConfig defaults;
+    int max_gap = REGISTER_PLAN_MAX_GAP;
+    string history_file = "sun2000_history.tsdb";
+    string events_file = "sun2000_events.log";
+    int slave_id = 0;
+    string config_file;
+    int worker_count = 2;
+    ModbusLinkOptions link_options;
+    string metrics_file;
+    int tick_s = 60;
+    bool headless = false;
+    string http_spec;
+    string replay_file;
+    ReplayOptions replay_options;
+    string capture_file;
+    bool output_set = false, history_set = false, events_set = false;  // Podane jawnie (dla --replay)
 
     // Parsowanie argumentów
     for (int i = 1; i < argc; i++) {
@@ -375,198 +294,768 @@ int main(int argc, char* argv[]) {
         } else if (arg == "--port" && i + 1 < argc) {
             port = stoi(argv[++i]);
         } else if (arg == "--output" && i + 1 < argc) {
-            output_file = argv[++i];
+            publisher_config.target = argv[++i];
+            output_set = true;
+        } else if (arg == "--json-format" && i + 1 < argc) {
+            string format = argv[++i];
+            publisher_config.pretty = format != "compact" && format != "binary";
+            publisher_config.binary = format == "binary";
+        } else if (arg == "--publish-min-interval" && i + 1 < argc) {
+            publisher_config.min_interval_ms = stoi(argv[++i]);
+        } else if (arg == "--publish-heartbeat" && i + 1 < argc) {
+            publisher_config.heartbeat_s = stoi(argv[++i]);
         } else if (arg == "--interval" && i + 1 < argc) {
             interval = stoi(argv[++i]);
+        } else if (arg == "--fast-interval" && i + 1 < argc) {
+            defaults.fast_interval_s = max(0, stoi(argv[++i]));
+        } else if (arg == "--night-interval" && i + 1 < argc) {
+            defaults.night_interval_s = max(0, stoi(argv[++i]));
+        } else if (arg == "--history" && i + 1 < argc) {
+            history_file = argv[++i];
+            history_set = true;
+        } else if (arg == "--no-history") {
+            history_file.clear();
+        } else if (arg == "--events" && i + 1 < argc) {
+            events_file = argv[++i];
+            events_set = true;
+        } else if (arg == "--no-events") {
+            events_file.clear();
+        } else if (arg == "--max-gap" && i + 1 < argc) {
+            max_gap = stoi(argv[++i]);
+        } else if (arg == "--slave" && i + 1 < argc) {
+            slave_id = stoi(argv[++i]);
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_file = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            worker_count = stoi(argv[++i]);
+        } else if (arg == "--transport" && i + 1 < argc) {
+            link_options.use_libmodbus = string(argv[++i]) == "libmodbus";
+        } else if (arg == "--pipeline" && i + 1 < argc) {
+            link_options.pipeline = stoi(argv[++i]);
+        } else if (arg == "--timeout" && i + 1 < argc) {
+            link_options.timeout_ms = stoi(argv[++i]);
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            metrics_file = argv[++i];
+        } else if (arg == "--tick" && i + 1 < argc) {
+            tick_s = stoi(argv[++i]);
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replay_file = argv[++i];
+        } else if (arg == "--replay-speed" && i + 1 < argc) {
+            string speed = argv[++i];
+            replay_options.speed = speed == "max" ? 0.0 : max(0.0, stod(speed));
+        } else if (arg == "--capture" && i + 1 < argc) {
+            capture_file = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--http" && i + 1 < argc) {
+            http_spec = argv[++i];
         } else if (arg == "--help") {
             cout << "Użycie: " << argv[0] << " [opcje]" << endl;
             cout << "  --ip <adres>       IP inwertera (domyślnie: 10.88.45.1)" << endl;
             cout << "  --port <port>      Port Modbus TCP (domyślnie: 6607)" << endl;
-            cout << "  --output <plik>    Plik wyjściowy JSON" << endl;
+            cout << "  --slave <id>       Identyfikator slave Modbus (domyślnie: 0)" << endl;
+            cout << "  --config <plik>    Lista inwerterów (INI) zamiast --ip/--port/--slave" << endl;
+            cout << "  --workers <n>      Liczba wątków odczytu dla wielu urządzeń (domyślnie: 2)" << endl;
+            cout << "  --transport <t>    epoll (domyślnie, zapytania potokowe) lub libmodbus" << endl;
+            cout << "  --pipeline <n>     Zapytań w locie na połączenie (domyślnie: "
+                 << ModbusTcpClient::DEFAULT_PIPELINE << ", 1 = bez potokowania)" << endl;
+            cout << "  --timeout <ms>     Termin odpowiedzi na zapytanie (domyślnie: "
+                 << ModbusTcpClient::DEFAULT_TIMEOUT_MS << ")" << endl;
+            cout << "  --metrics-file <plik>  Eksport pomiarów (format Prometheus) co 10 s" << endl;
+            cout << "  --tick <sek>       Odświeżenie ekranu bez nowych danych (domyślnie: 60, 0 = wyłączone)" << endl;
+            cout << "  --headless         Bez interfejsu: tylko odczyt, publikacja i serwer HTTP" << endl;
+            cout << "  --http [adres:]port  Serwer HTTP z JSON i metrykami Prometheusa (domyślnie przy --headless: "
+                 << "127.0.0.1:" << HTTP_DEFAULT_PORT << ")" << endl;
+            cout << "  --output <cel>     Wyjście JSON: plik, unix:<gniazdo> lub fifo:<potok>" << endl;
+            cout << "                     (domyślnie: /var/www/html/dane.json)" << endl;
+            cout << "  --json-format <f>  pretty (domyślnie), compact lub binary (rekord binarny, sun_convert)" << endl;
+            cout << "  --publish-min-interval <ms>  Minimalny odstęp zapisów JSON (domyślnie: 0)" << endl;
+            cout << "  --publish-heartbeat <sek>    Zapis mimo braku zmian co N sekund (domyślnie: 60)" << endl;
             cout << "  --interval <sek>   Interwał odczytu (domyślnie: 10)" << endl;
+            cout << "  --fast-interval <sek>   Interwał przy rozruchu i szybkich zmianach mocy (domyślnie: "
+                 << defaults.fast_interval_s << ", 0 = wyłączony)" << endl;
+            cout << "  --night-interval <sek>  Interwał w nocy, stan 0xA000 (domyślnie: "
+                 << defaults.night_interval_s << ", 0 = wyłączony)" << endl;
+            cout << "  --history <plik>   Plik historii próbek (domyślnie: sun2000_history.tsdb)" << endl;
+            cout << "  --no-history       Bez zapisu historii na dysk" << endl;
+            cout << "  --events <plik>    Dziennik zmian stanów i alarmów (domyślnie: sun2000_events.log)" << endl;
+            cout << "  --no-events        Bez zapisu dziennika zdarzeń" << endl;
+            cout << "  --capture <plik>   Zapis surowych ramek Modbus do późniejszego odtworzenia" << endl;
+            cout << "  --replay <plik>    Odtwarzanie zapisu ramek (--capture) albo pliku historii zamiast odczytu;" << endl;
+            cout << "                     JSON, historia i dziennik tylko gdy podane jawnie" << endl;
+            cout << "  --replay-speed <x> Tempo odtwarzania: krotność czasu rzeczywistego albo max (domyślnie: 1)" << endl;
+            cout << "  --max-gap <n>      Maks. przerwa scalanych rejestrów (domyślnie: "
+                 << REGISTER_PLAN_MAX_GAP << ", 0 = tylko sąsiednie)" << endl;
             return 0;
         }
     }
     
+    // Lista urządzeń: z odtwarzanego zapisu, z pliku konfiguracyjnego albo jedno z linii poleceń
+    vector<DeviceConfig> device_configs;
+    unique_ptr<SampleSource> source;
+    ReplaySource* replay = nullptr;
+    if (!replay_file.empty()) {
+        auto replay_source = make_unique<ReplaySource>();
+        if (!replay_source->open(replay_file, replay_options)) {
+            cerr << replay_source->lastError() << endl;
+            return 1;
+        }
+        for (size_t d = 0; d < replay_source->deviceCount(); d++) {
+            device_configs.push_back(replay_source->config(d));
+        }
+        // Odtwarzanie nie nadpisuje domyślnych plików odczytu na żywo
+        if (output_set) device_configs[0].output = publisher_config.target;
+        if (history_set) device_configs[0].history = history_file;
+        if (!events_set) events_file.clear();
+        replay = replay_source.get();
+        source = std::move(replay_source);
+    } else if (!config_file.empty()) {
+        string config_error;
+        if (!loadDeviceConfig(config_file, device_configs, config_error)) {
+            cerr << config_error << endl;
+            return 1;
+        }
+    } else {
+        DeviceConfig single = defaults;
+        single.name = ip;
+        single.ip = ip;
+        single.port = port;
+        single.slave_id = slave_id;
+        single.interval_s = max(1, interval);
+        single.output = publisher_config.target;
+        single.history = history_file;
+        device_configs.push_back(single);
+    }
+    const size_t device_count = device_configs.size();
+
+    string http_address;
+    int http_port = 0;
+    if (headless && http_spec.empty()) http_spec = to_string(HTTP_DEFAULT_PORT);
+    if (!http_spec.empty() && !parseListenAddress(http_spec, http_address, http_port)) {
+        cerr << "Niepoprawny adres serwera HTTP: " << http_spec << endl;
+        return 1;
+    }
+
+    FrameCapture frame_capture;
+    if (!capture_file.empty()) {
+        if (!frame_capture.open(capture_file)) {
+            cerr << frame_capture.lastError() << endl;
+            return 1;
+        }
+        link_options.capture = &frame_capture;
+    }
+
+    // Zapis do FIFO bez czytelnika nie może zabić procesu
+    signal(SIGPIPE, SIG_IGN);
+
+    // Bez interfejsu SIGINT/SIGTERM odbiera tylko główny wątek (sigwait) -
+    // maska ustawiona przed startem pozostałych wątków jest przez nie dziedziczona
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    if (headless) pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
     auto screen = ScreenInteractive::Fullscreen();
 
     // --- Stan współdzielony ---
-    InverterData current_data;
-    std::deque<double> power_history; // dynamiczna tabela mocy
-    const size_t POWER_HISTORY_MAX = 144; // np. 24h co 10 min
-    atomic<bool> should_exit(false);
-    atomic<bool> connected(false);
-    string connection_status = "Łączenie z " + ip + ":" + to_string(port) + "...";
-    mutex data_mutex;
+    vector<DeviceView> views(device_count);
+    vector<DeviceFeed> feeds(device_count);
+    vector<DeviceOutputs> outputs(device_count);
+    size_t selected = 0;  // Urządzenie pokazywane w szczegółach (tylko wątek UI)
+    bool show_diagnostics = false;
+    bool show_strings = false;
+    PollMetrics metrics;
+    link_options.metrics = &metrics;
+    int chart_window = 2; // 24h
 
-    HuaweiSun2000 inverter(ip, port);
+    // Dziennik zdarzeń wspólny dla wszystkich urządzeń (linie dopisywane przez wątki odczytu)
+    AlarmEventFile event_log;
+    string event_log_error;
+    if (!events_file.empty() && !event_log.open(events_file)) {
+        event_log_error = event_log.lastError();
+        cerr << event_log_error << endl;
+    }
 
-    // Wątek do odczytu danych
-    thread reader_thread([&]() {
-        while (!should_exit) {
-            if (!connected) {
-                if (inverter.connect()) {
-                    connected = true;
-                    connection_status = "Połączono z " + ip + ":" + to_string(port);
-                } else {
-                    connection_status = "Błąd połączenia z " + ip + ":" + to_string(port);
-                    this_thread::sleep_for(chrono::seconds(5));
-                    continue;
-                }
+    for (size_t d = 0; d < device_count; d++) {
+        const DeviceConfig& cfg = device_configs[d];
+        if (!cfg.output.empty()) {
+            PublisherConfig device_publisher = publisher_config;
+            device_publisher.target = cfg.output;
+            outputs[d].publisher = make_unique<JsonPublisher>(device_publisher);
+        }
+        // Historia z dysku - agregaty z najdłuższego okna wykresu od razu po starcie
+        if (cfg.history.empty()) continue;
+        TimeSeriesStore& history_store = outputs[d].history_store;
+        if (history_store.open(cfg.history) && replay == nullptr) {
+            int64_t now_ms = chrono::duration_cast<chrono::milliseconds>(
+                chrono::system_clock::now().time_since_epoch()).count();
+            int64_t load_ms = CHART_WINDOWS[CHART_WINDOW_COUNT - 1].ms;
+            auto range = history_store.range(now_ms - load_ms, now_ms + 1);
+            InverterSample stored;
+            for (size_t i = range.first; i < range.second; i++) {
+                const TimeSeriesRecord& rec = history_store.at(i);
+                if (!headless) views[d].power_rollup.add(rec.timestamp_ms, rec.value(REG_ACTIVE_POWER));
+                // Bilans energii z historii - kubełki godzin i dób od razu po starcie
+                rec.toSample(stored);
+                outputs[d].energy.update(stored);
+                StringPoint strings;
+                if (!headless && stringPointFromSample(stored, strings)) views[d].strings.add(strings);
             }
-            try {
-                json inverter_json = inverter.readInverterData();
-                
-                // Zapisz dane do pliku JSON
-                saveJsonToFile(inverter_json, output_file);
-                
-                InverterData d;
-                d.timestamp = inverter_json.value("timestamp", "N/A");
-                d.model = inverter_json.value("model", "N/A");
-                d.sn = inverter_json.value("sn", "N/A");
-                d.firmware_version = inverter_json.value("firmware_version", "N/A");
-                d.device_status = inverter_json.value("device_status", "N/A");
-                auto safe_stod = [](const json& val, double def = 0.0) -> double {
-                    if (val.is_string()) { try { return stod(val.get<string>()); } catch (...) { return def; } }
-                    else if (val.is_number()) return val.get<double>();
-                    return def;
-                };
-                d.active_power = safe_stod(inverter_json["active_power"]);
-                d.input_power = safe_stod(inverter_json["input_power"]);
-                d.efficiency = safe_stod(inverter_json["efficiency"]);
-                d.temperature = safe_stod(inverter_json["internal_temperature"]);
-                d.daily_energy = safe_stod(inverter_json["daily_yield_energy"]);
-                d.total_energy = safe_stod(inverter_json["accumulated_energy_yield"]);
-                d.frequency = safe_stod(inverter_json["grid_frequency"]);
-                d.phase_A_voltage = safe_stod(inverter_json["phase_A_voltage"]);
-                d.phase_B_voltage = safe_stod(inverter_json["phase_B_voltage"]);
-                d.phase_C_voltage = safe_stod(inverter_json["phase_C_voltage"]);
-                d.phase_A_current = safe_stod(inverter_json["phase_A_current"]);
-                d.phase_B_current = safe_stod(inverter_json["phase_B_current"]);
-                d.phase_C_current = safe_stod(inverter_json["phase_C_current"]);
-                d.wifi_signal = inverter_json.value("wifi_signal_dbm", -65);
-                d.ping_ms = inverter_json.value("ping_ms", 0);
-                {
-                    lock_guard<mutex> lock(data_mutex);
-                    current_data = d;
-                    // Dodaj moc do historii
-                    power_history.push_back(d.active_power);
-                    if (power_history.size() > POWER_HISTORY_MAX)
-                        power_history.pop_front();
-                }
-            } catch (const exception& e) {
-                lock_guard<mutex> lock(data_mutex);
-                current_data.last_error = string("Błąd: ") + e.what();
-                connected = false;
-                inverter.disconnect();
+            outputs[d].snapshot.energy = outputs[d].energy.ledger();
+            if (range.second > range.first) {
+                history_store.at(range.second - 1).toSample(outputs[d].snapshot.sample);
             }
-            for (int i = 0; i < interval && !should_exit; i++) {
+        } else if (!history_store.isOpen()) {
+            snprintf(outputs[d].snapshot.last_error, sizeof(outputs[d].snapshot.last_error), "%s",
+                     history_store.lastError().c_str());
+        }
+        feeds[d].latest.store(outputs[d].snapshot);
+    }
+    atomic<bool> should_exit(false);
+    atomic<bool> redraw_pending(false);  // Zdarzenie odświeżenia już czeka w kolejce FTXUI
+
+    // Prośba o nową klatkę (z dowolnego wątku); kilka zmian przed klatką daje jedno zdarzenie
+    auto requestRedraw = [&] {
+        if (headless) return;
+        if (!redraw_pending.exchange(true, memory_order_relaxed)) screen.PostEvent(Event::Custom);
+    };
+
+    // Odczyt wszystkich urządzeń na wspólnej puli wątków (albo odtwarzanie zapisu)
+    if (!source) source = make_unique<PollingEngine>(device_configs, max_gap, link_options);
+    // Bez interfejsu koniec odtwarzania kończy program (sigwait w głównym wątku)
+    if (replay != nullptr && headless) replay->setFinishCallback([] { kill(getpid(), SIGTERM); });
+    source->start(worker_count, [&](size_t d, const InverterSample& sample, bool read_ok) {
+        DeviceOutputs& out = outputs[d];
+        if (read_ok) out.energy.update(sample);
+        // Nieudany odczyt nie trafia do JSON, historii ani na wykres - zera z martwego
+        // łącza wyglądałyby jak "0 W, Standby"; interfejs zostaje przy ostatniej próbce
+        if (out.publisher && read_ok) out.publisher->publish(sample, &out.energy.ledger());
+        bool stored = true;
+        if (out.history_store.isOpen() && read_ok) {
+            lock_guard<mutex> lock(out.history_mutex);
+            stored = out.history_store.append(sample);
+        }
+        // Zmiany rejestrów bitowych względem poprzedniej udanej próbki
+        size_t event_count = read_ok ? out.alarms.update(sample, out.alarm_events) : 0;
+        if (read_ok) event_count += out.anomalies.update(sample, out.alarm_events + event_count);
+        bool events_logged = event_log.append(device_configs[d].name.c_str(), out.alarm_events, event_count);
+        int events_errno = errno;
+
+        // Publikacja dla interfejsu - wątek odczytu nigdy nie czeka na renderowanie
+        DeviceSnapshot& snap = out.snapshot;
+        if (read_ok) snap.sample = sample;
+        snap.energy = out.energy.ledger();
+        snap.anomalies = out.anomalies.current();
+        if (out.publisher) snap.publish_stats = out.publisher->getStats();
+        if (!read_ok) snprintf(snap.last_error, sizeof(snap.last_error), "Nie udało się odczytać rejestrów");
+        else if (!stored) snprintf(snap.last_error, sizeof(snap.last_error), "Zapis historii: %s",
+                                   out.history_store.lastError().c_str());
+        else if (!events_logged) snprintf(snap.last_error, sizeof(snap.last_error), "Dziennik zdarzeń: %s",
+                                          strerror(events_errno));
+        else if (!event_log_error.empty()) snprintf(snap.last_error, sizeof(snap.last_error), "%s",
+                                                    event_log_error.c_str());
+        else snap.last_error[0] = '\0';
+        feeds[d].latest.store(snap);
+        // Moc do agregatów wykresu i zdarzenia do dziennika na ekranie
+        if (!headless) {
+            if (read_ok && sample.regs.has(REG_ACTIVE_POWER)) {
+                feeds[d].power.push(PowerPoint{sample.timestamp_ms, sample.get<REG_ACTIVE_POWER>()});
+            }
+            StringPoint strings;
+            if (read_ok && stringPointFromSample(sample, strings)) feeds[d].strings.push(strings);
+            for (size_t i = 0; i < event_count; i++) feeds[d].events.push(out.alarm_events[i]);
+        }
+    }, [&](size_t) {
+        // Próbka i status urządzenia są już opublikowane
+        requestRedraw();
+    });
+
+    // Eksport pomiarów dla monitoringu
+    thread metrics_thread([&] {
+        if (metrics_file.empty()) return;
+        while (!should_exit) {
+            for (int i = 0; i < 10 && !should_exit; i++) {
                 this_thread::sleep_for(chrono::seconds(1));
             }
+            writeMetricsFile(metrics_file, metrics);
         }
-        inverter.disconnect();
     });
 
+    // Serwer HTTP: JSON i metryki z pamięci podręcznej, bez blokowania wątków odczytu
+    HttpServer http;
+    thread http_thread;
+    if (http_port > 0) {
+        if (!http.listen(http_address, http_port)) {
+            cerr << http.lastError() << endl;
+            should_exit = true;
+            source->stop();
+            metrics_thread.join();
+            return 1;
+        }
+        vector<HttpDeviceSource> sources(device_count);
+        for (size_t d = 0; d < device_count; d++) {
+            sources[d].feed = &feeds[d];
+            if (outputs[d].history_store.isOpen()) sources[d].history = &outputs[d].history_store;
+            sources[d].history_mutex = &outputs[d].history_mutex;
+        }
+        http_thread = thread([&http, &source, &metrics, sources] {
+            SunHttpApi api(*source, metrics, sources);
+            http.run([&api](const HttpRequest& req) { return api.handle(req); });
+        });
+    }
+
+    auto shutdown = [&] {
+        should_exit = true;
+        source->stop();
+        http.stop();
+        if (http_thread.joinable()) http_thread.join();
+        metrics_thread.join();
+    };
+
+    if (headless) {
+        cerr << "Tryb bez interfejsu: " << device_count << " urządzeń";
+        if (http_port > 0) cerr << ", HTTP na " << http_address << ":" << http_port;
+        cerr << endl;
+        int sig = 0;
+        sigwait(&stop_signals, &sig);
+        shutdown();
+        if (replay != nullptr) {
+            double seconds = replay->elapsedSeconds();
+            fprintf(stderr, "Odtworzono %llu z %zu próbek w %.3f s (%.0f próbek/s)\n",
+                    static_cast<unsigned long long>(replay->samplesDelivered()), replay->sampleCount(), seconds,
+                    seconds > 0 ? double(replay->samplesDelivered()) / seconds : 0.0);
+        }
+        return 0;
+    }
+
     // --- Renderer ---
+    // Klatka powstaje tylko po zdarzeniu: nowe dane z wątku odczytu, klawisz,
+    // zmiana rozmiaru terminala lub rzadki takt zegara (przesuwanie osi czasu).
+    // Niezmienione fragmenty ekranu są brane z pamięci podręcznej.
+    auto header = vbox(Elements{
+        text("╔══════════════════════════════════════════════════════════════════════════════╗") | color(Color::Cyan),
+        text("║                    HUAWEI SUN2000 INVERTER MONITOR                           ║") | color(Color::Cyan) | bold,
+        text("╚══════════════════════════════════════════════════════════════════════════════╝") | color(Color::Cyan)
+    });
+    CachedElement device_top_cache, device_bottom_cache, site_cache, events_cache, strings_cache, chart_cache,
+        footer_cache;
+    vector<DeviceStatus> statuses(device_count);
+    vector<uint64_t> status_versions(device_count);
+    vector<ChartColumn> chart_columns;
+    vector<float> string_columns;
+    PowerChart power_chart;
+
     auto renderer = Renderer([&]() -> ftxui::Element {
-        InverterData local_data;
-        std::deque<double> local_power_history;
-        {
-            lock_guard<mutex> lock(data_mutex);
-            local_data = current_data;
-            local_power_history = power_history;
+        auto frame_start = chrono::steady_clock::now();
+        redraw_pending.store(false, memory_order_relaxed);
+        // Rozmiar wykresu (pozostaw miejsce na UI)
+        auto screen_size = Terminal::Size();
+        int chart_width = max(20, screen_size.dimx - 15);  // 15 znaków na etykiety Y i marginesy
+        int chart_height = max(8, screen_size.dimy / 3);   // 1/3 wysokości terminala
+        const ChartWindow& window = CHART_WINDOWS[chart_window];
+        // Nowe dane (kopia tylko przy zmianie wersji) i klucze fragmentów ekranu
+        uint64_t site_key = cacheKey(selected);
+        for (size_t d = 0; d < device_count; d++) {
+            statuses[d] = source->status(d, &status_versions[d]);
+            views[d].refresh(feeds[d]);
+            site_key = cacheKey(site_key, views[d].version, status_versions[d]);
         }
-        auto status_color = Color::Red;
-        if (local_data.device_status.find("On-grid") != string::npos) {
-            status_color = Color::Green;
-        } else if (local_data.device_status.find("Standby") != string::npos) {
-            status_color = Color::Yellow;
-        }
-        // Nagłówek
-        auto header = vbox(Elements{
-            text("╔══════════════════════════════════════════════════════════════════════════════╗") | color(Color::Cyan),
-            text("║                    HUAWEI SUN2000 INVERTER MONITOR                           ║") | color(Color::Cyan) | bold,
-            text("╚══════════════════════════════════════════════════════════════════════════════╝") | color(Color::Cyan)
+        const DeviceView& view = views[selected];
+        const InverterSample& local_data = view.current.sample;
+        const DeviceDescriptor& device = *local_data.device;
+        const DeviceStatus& device_state = statuses[selected];
+        const DeviceConfig& device_config = device_configs[selected];
+        uint64_t device_key = cacheKey(selected, view.version, status_versions[selected]);
+        int64_t now_ms = source->clockMs();  // Przy odtwarzaniu czas zapisu
+        int64_t column_ms = max<int64_t>(1, window.ms / chart_width);
+        // Wykres zmienia się z nową próbką, rozmiarem, oknem albo gdy czas przejdzie do następnej kolumny
+        uint64_t chart_key = cacheKey(selected, view.version, chart_window, chart_width, chart_height,
+                                      now_ms / column_ms);
+
+        auto device_top = device_top_cache.get(device_key, [&] {
+            const char* status_name = deviceStatusName(local_data.state());
+            string device_status = local_data.timestamp_ms == 0 ? "N/A" :
+                status_name != nullptr ? status_name : "Nieznany (" + to_string(local_data.state()) + ")";
+            auto status_color = Color::Red;
+            if (device_status.find("On-grid") != string::npos) {
+                status_color = Color::Green;
+            } else if (device_status.find("Standby") != string::npos) {
+                status_color = Color::Yellow;
+            }
+            char timestamp[32] = "N/A";
+            if (local_data.timestamp_ms != 0) formatSampleTime(local_data.timestamp_ms, timestamp, sizeof(timestamp));
+            double temperature = local_data.get<REG_INTERNAL_TEMPERATURE>();
+            double active_power = local_data.get<REG_ACTIVE_POWER>();
+            double efficiency = local_data.get<REG_EFFICIENCY>();
+            const AnomalyState& anomalies = view.current.anomalies;
+            // Status połączenia
+            auto status_line = hbox(Elements{
+                device_count > 1 ?
+                    text("[" + to_string(selected + 1) + "/" + to_string(device_count) + "] " +
+                        device_config.name + " | ") | bold :
+                    text(""),
+                text("Połączenie: "),
+                text(device_state.status) | color(linkHealthColor(device_state.health)),
+                text(" | "),
+                text("Ostatni odczyt: "),
+                text(timestamp) | color(Color::White),
+                text(" | "),
+                text("Zapytania: " + to_string(local_data.poll.round_trips) + " (" +
+                    to_fixed_1(local_data.poll.wall_ms) + " ms)") | color(Color::Cyan)
+            });
+            // Informacje o urządzeniu
+            auto device_info = hbox(Elements{
+                vbox(Elements{
+                    text(string("Model: ") + device.model),
+                    text(string("S/N: ") + device.sn),
+                    text(string("Firmware: ") + device.firmware_version)
+                }) | flex,
+                vbox(Elements{
+                    hbox(Elements{
+                        text("Status: "),
+                        text(device_status) | color(status_color)
+                    }),
+                    text("Temperatura: " + to_fixed_1(temperature) + "°C") |
+                        color(temperature > 60 || anomalies.has(AnomalyKind::ThermalDerating) ?
+                              Color::Red : Color::Green),
+                    text("WiFi: " + to_string(int(local_data.get<REG_WIFI_SIGNAL>())) + " dBm | Ping: " +
+                        to_string(local_data.ping_ms) + " ms")
+                }) | flex
+            });
+            // Główne parametry
+            auto power_box = vbox(Elements{
+                text("MOC") | center | bold | color(Color::Yellow),
+                separator(),
+                text("Wyjściowa: " + to_fixed_1(active_power) + " W") |
+                    color(active_power > 0 ? Color::Green : Color::White),
+                text("Wejściowa: " + to_fixed_1(local_data.get<REG_INPUT_POWER>()) + " W") | color(Color::Cyan),
+                // Sprawność oceniana względem odniesienia dla tej samej mocy wejściowej
+                text("Sprawność: " + to_fixed_1(efficiency) + "%" +
+                    (anomalies.efficiency_expected_pct > 0 ?
+                        " (zwykle " + to_fixed_1(anomalies.efficiency_expected_pct) + "%)" : string())) |
+                    color(anomalies.has(AnomalyKind::EfficiencyDrop) ? Color::Red :
+                          efficiency > 95 ? Color::Green : Color::Yellow)
+            }) | border | flex;
+            auto energy_box = vbox(Elements{
+                text("ENERGIA") | center | bold | color(Color::Yellow),
+                separator(),
+                text("Dzienna: " + to_fixed_1(local_data.get<REG_DAILY_ENERGY>()) + " kWh") | color(Color::Green),
+                text("Całkowita: " + to_fixed_1(local_data.get<REG_TOTAL_ENERGY>()) + " kWh") | color(Color::Cyan),
+                text("Częstotliwość: " + to_fixed_2(local_data.get<REG_GRID_FREQUENCY>()) + " Hz") |
+                    color(anomalies.has(AnomalyKind::FrequencyExcursion) ? Color::Red : Color::White)
+            }) | border | flex;
+            // Fazy według identyfikacji - falownik jednofazowy ma tylko L1
+            static constexpr RegId PHASE_VOLTAGES[] = {REG_PHASE_A_VOLTAGE, REG_PHASE_B_VOLTAGE, REG_PHASE_C_VOLTAGE};
+            static constexpr RegId PHASE_CURRENTS[] = {REG_PHASE_A_CURRENT, REG_PHASE_B_CURRENT, REG_PHASE_C_CURRENT};
+            Elements voltage_rows{text("NAPIĘCIA [V]") | center | bold | color(Color::Yellow), separator()};
+            Elements current_rows{text("PRĄDY [A]") | center | bold | color(Color::Yellow), separator()};
+            for (int phase = 0; phase < device.phases(); phase++) {
+                string label = "L" + to_string(phase + 1) + ": ";
+                voltage_rows.push_back(text(label + to_fixed_1(local_data.value(PHASE_VOLTAGES[phase]))) |
+                    color(Color::Magenta));
+                current_rows.push_back(text(label + to_fixed_1(local_data.value(PHASE_CURRENTS[phase]))) |
+                    color(Color::Blue));
+            }
+            if (device.phases() == 3) {
+                voltage_rows.push_back(text("Asymetria: " + to_fixed_1(anomalies.voltage_imbalance_pct) + "%") |
+                    color(anomalies.has(AnomalyKind::VoltageImbalance) ? Color::Red : Color::GrayLight));
+                current_rows.push_back(text("Asymetria: " + to_fixed_1(anomalies.current_imbalance_pct) + "%") |
+                    color(anomalies.has(AnomalyKind::CurrentImbalance) ? Color::Red : Color::GrayLight));
+            }
+            auto voltage_box = vbox(move(voltage_rows)) | border | flex;
+            auto current_box = vbox(move(current_rows)) | border | flex;
+            auto params_row = hbox(Elements{power_box, energy_box, voltage_box, current_box});
+            // Stringi PV i parametry dodatkowe z mapy rejestrów
+            auto v = [&](RegId id) { return local_data.value(id); };
+            auto pv_box = vbox(Elements{
+                text("STRINGI PV") | center | bold | color(Color::Yellow),
+                separator(),
+                text("PV1: " + to_fixed_1(v(REG_PV1_VOLTAGE)) + " V / " + to_fixed_2(v(REG_PV1_CURRENT)) + " A") |
+                    color(Color::Cyan),
+                text("PV2: " + to_fixed_1(v(REG_PV2_VOLTAGE)) + " V / " + to_fixed_2(v(REG_PV2_CURRENT)) + " A") |
+                    color(Color::Cyan)
+            }) | border | flex;
+            auto grid_box = vbox(Elements{
+                text("SIEĆ") | center | bold | color(Color::Yellow),
+                separator(),
+                text("Moc bierna: " + to_fixed_1(v(REG_REACTIVE_POWER)) + " var") | color(Color::White),
+                text("Wsp. mocy: " + to_fixed(v(REG_POWER_FACTOR), 3)) | color(Color::White)
+            }) | border | flex;
+            char alarm_hex[48];
+            snprintf(alarm_hex, sizeof(alarm_hex), "%04X %04X %04X",
+                unsigned(v(REG_ALARM1)), unsigned(v(REG_ALARM2)), unsigned(v(REG_ALARM3)));
+            bool any_alarm = v(REG_ALARM1) != 0 || v(REG_ALARM2) != 0 || v(REG_ALARM3) != 0;
+            auto insulation_box = vbox(Elements{
+                text("IZOLACJA / ALARMY") | center | bold | color(Color::Yellow),
+                separator(),
+                text("Rezystancja izolacji: " + to_string(int(v(REG_INSULATION_RESISTANCE))) + " kΩ") |
+                    color(Color::White),
+                text(string("Alarmy: ") + alarm_hex) | color(any_alarm ? Color::Red : Color::Green)
+            }) | border | flex;
+            // Bilans produkcji: całka mocy uzgodniona z licznikami urządzenia
+            const EnergyLedger& energy = view.current.energy;
+            int64_t day_start, day_end;
+            energyPeriodBounds(local_data.timestamp_ms, EnergyPeriod::Day, day_start, day_end);
+            auto kwh = [](double wh) { return to_fixed_2(wh / 1000.0) + " kWh"; };
+            auto balance_box = vbox(Elements{
+                text("BILANS ENERGII") | center | bold | color(Color::Yellow),
+                separator(),
+                text("Godzina: " + kwh(energy.hours.energyAt(local_data.timestamp_ms)) + " | Dziś: " +
+                    kwh(energy.days.energyAt(local_data.timestamp_ms)) + " | Wczoraj: " +
+                    kwh(energy.days.energyAt(day_start - 1))) | color(Color::Green),
+                text("Miesiąc: " + kwh(energy.months.energyAt(local_data.timestamp_ms)) + " | Korekty: " +
+                    kwh(energy.corrections_wh) + " | Przerwy: " + to_string(energy.gaps) +
+                    " | Zakłócenia: " + to_string(energy.glitches)) |
+                    color(energy.glitches > 0 ? Color::Yellow : Color::Cyan)
+            }) | border;
+            // Aktywne anomalie ze strumienia próbek (tylko gdy są)
+            Elements anomaly_items;
+            for (size_t k = 0; k < ANOMALY_COUNT; k++) {
+                if (!anomalies.has(AnomalyKind(k))) continue;
+                anomaly_items.push_back(text((anomaly_items.empty() ? "" : " | ") + string(ANOMALIES[k].name)) |
+                    color(ANOMALIES[k].severity == AlarmSeverity::Critical ? Color::Red :
+                          ANOMALIES[k].severity == AlarmSeverity::Warning ? Color::Yellow : Color::White));
+            }
+            auto anomaly_line = anomaly_items.empty() ? text("") :
+                hbox(Elements{text("ANOMALIE: ") | bold | color(Color::Red), hbox(move(anomaly_items))});
+            auto extra_row = hbox(Elements{pv_box, grid_box, insulation_box});
+            return vbox(Elements{status_line, anomaly_line, separator(), device_info, separator(), params_row,
+                                 extra_row, balance_box});
         });
-        // Status połączenia
-        auto status_line = hbox(Elements{
-            text("Połączenie: "),
-            text(connection_status) | color(connected ? Color::Green : Color::Red),
-            text(" | "),
-            text("Ostatni odczyt: "),
-            text(local_data.timestamp) | color(Color::White)
+        // Błędy i statystyki publikacji JSON
+        auto device_bottom = device_bottom_cache.get(device_key, [&] {
+            const PublisherStats& local_publish = view.current.publish_stats;
+            const char* local_error = view.current.last_error;
+            auto error_line = local_error[0] == '\0' ?
+                text("") :
+                text(string("Błąd: ") + local_error) | color(Color::Red);
+            auto publish_line = hbox(Elements{
+                text("JSON: "),
+                text(to_string(local_publish.writes) + " zapisów, " +
+                    to_string(local_publish.skipped_unchanged + local_publish.skipped_rate) + " pominiętych, " +
+                    to_string(local_publish.bytes_written / 1024) + " KiB") | color(Color::Cyan),
+                text(" | Czas zapisu: " + to_fixed_1(local_publish.last_write_us) + " µs (max " +
+                    to_fixed_1(local_publish.max_write_us) + " µs)") | color(Color::Cyan),
+                local_publish.errors > 0 ?
+                    text(" | Błędy: " + to_string(local_publish.errors) + " (" +
+                        strerror(local_publish.last_errno) + ")") | color(Color::Red) :
+                    text("")
+            });
+            return vbox(Elements{error_line, publish_line});
         });
-        // Informacje o urządzeniu
-        auto device_info = hbox(Elements{
-            vbox(Elements{
-                text("Model: " + local_data.model),
-                text("S/N: " + local_data.sn),
-                text("Firmware: " + local_data.firmware_version)
-            }) | flex,
-            vbox(Elements{
-                hbox(Elements{
-                    text("Status: "),
-                    text(local_data.device_status) | color(status_color)
-                }),
-                text("Temperatura: " + to_fixed_1(local_data.temperature) + "°C") |
-                    color(local_data.temperature > 60 ? Color::Red : Color::Green),
-                text("WiFi: " + to_string(local_data.wifi_signal) + " dBm | Ping: " +
-                    to_string(local_data.ping_ms) + " ms")
-            }) | flex
+        // Instalacja: wszystkie urządzenia i sumy
+        auto site_panel = device_count < 2 ? text("") : site_cache.get(site_key, [&] {
+            Elements site_rows;
+            double site_power = 0.0, site_daily = 0.0, site_total = 0.0;
+            site_rows.push_back(text("INSTALACJA") | center | bold | color(Color::Yellow));
+            site_rows.push_back(separator());
+            for (size_t d = 0; d < device_count; d++) {
+                const DeviceStatus& st = statuses[d];
+                const InverterSample& s = views[d].current.sample;
+                double device_power = s.get<REG_ACTIVE_POWER>();
+                double device_daily = s.get<REG_DAILY_ENERGY>();
+                site_power += device_power;
+                site_daily += device_daily;
+                site_total += s.get<REG_TOTAL_ENERGY>();
+                site_rows.push_back(hbox(Elements{
+                    text(d == selected ? "▶ " : "  ") | color(Color::Yellow),
+                    text(device_configs[d].name) | size(WIDTH, EQUAL, 20),
+                    text(linkHealthName(st.health)) | size(WIDTH, EQUAL, 10) | color(linkHealthColor(st.health)),
+                    text(to_fixed_1(device_power) + " W") | size(WIDTH, EQUAL, 12) | color(Color::Green),
+                    text(to_fixed_1(device_daily) + " kWh") | size(WIDTH, EQUAL, 14) | color(Color::Cyan),
+                    text("co " + to_string(st.current_interval_s) + " s (" + pollModeName(st.mode) + "), odczytów: " +
+                        to_string(st.polls) +
+                        ", błędów: " + to_string(st.failures)) | color(st.failures > 0 ? Color::Yellow : Color::White)
+                }));
+            }
+            site_rows.push_back(separator());
+            site_rows.push_back(hbox(Elements{
+                text("  "),
+                text("RAZEM") | bold | size(WIDTH, EQUAL, 26),
+                text(to_fixed_1(site_power) + " W") | bold | size(WIDTH, EQUAL, 12) | color(Color::Green),
+                text(to_fixed_1(site_daily) + " kWh") | bold | size(WIDTH, EQUAL, 14) | color(Color::Cyan),
+                text("całkowita: " + to_fixed_1(site_total) + " kWh") | color(Color::Cyan)
+            }));
+            return vbox(move(site_rows)) | border;
+        });
+        // Ostatnie zmiany stanów i alarmów wybranego urządzenia (tylko gdy były jakieś zdarzenia)
+        const auto& event_log_view = view.events;
+        auto events_panel = event_log_view.size() == 0 ? text("") :
+            events_cache.get(cacheKey(selected, event_log_view.totalCount()), [&] {
+            Elements event_rows;
+            const uint32_t* alarm_raw = &local_data.regs.raw[REG_ALARM1];
+            int active = __builtin_popcount(alarm_raw[0]) + __builtin_popcount(alarm_raw[1]) +
+                __builtin_popcount(alarm_raw[2]);
+            event_rows.push_back(hbox(Elements{
+                text("ZDARZENIA") | bold | color(Color::Yellow),
+                text(" | Aktywne alarmy: " + to_string(active)) | color(active > 0 ? Color::Red : Color::Green),
+                text(" | Łącznie: " + to_string(event_log_view.totalCount())) | color(Color::White)
+            }) | center);
+            event_rows.push_back(separator());
+            size_t shown = min<size_t>(event_log_view.size(), EVENT_PANEL_ROWS);
+            for (size_t i = 0; i < shown; i++) {
+                const AlarmEvent& e = event_log_view.recent(i);
+                char timestamp[32];
+                formatSampleTime(e.timestamp_ms, timestamp, sizeof(timestamp));
+                char where[24];
+                if (e.reg == ALARM_FAULT_CODE) snprintf(where, sizeof(where), "FAULT %u", unsigned(e.value));
+                else if (e.reg == ALARM_ANOMALY) snprintf(where, sizeof(where), "ANOMALIA");
+                else snprintf(where, sizeof(where), "%s.%u", e.registerName(), unsigned(e.bit));
+                auto severity_color = e.severity == AlarmSeverity::Critical ? Color::Red :
+                    e.severity == AlarmSeverity::Warning ? Color::Yellow : Color::White;
+                event_rows.push_back(hbox(Elements{
+                    text(timestamp) | size(WIDTH, EQUAL, 21) | color(Color::Cyan),
+                    text(e.raised ? "▲ " : "▼ ") | color(e.raised ? Color::Red : Color::Green),
+                    text(where) | size(WIDTH, EQUAL, 12),
+                    text(e.description()) | color(severity_color)
+                }));
+            }
+            return vbox(move(event_rows)) | border;
+        });
+        // Porównanie stringów PV wybranego urządzenia w oknie wykresu ('s'); przy kilku
+        // urządzeniach także najsłabszy string instalacji
+        Element strings_panel = text("");
+        if (show_strings) {
+            int spark_width = max(10, screen_size.dimx - 78);
+            strings_panel = strings_cache.get(cacheKey(site_key, chart_window, spark_width, now_ms / column_ms), [&] {
+                using Q = StringMonitor::Quantity;
+                const StringMonitor& monitor = view.strings;
+                int64_t from_ms = now_ms - window.ms, to_ms = now_ms + 1;
+                auto mismatch_color = [](const StringMismatch& m) {
+                    return m.weakest < 0 ? Color::GrayLight : m.ratio >= STRING_MISMATCH_ALERT ? Color::Red :
+                        m.ratio >= STRING_MISMATCH_WARNING ? Color::Yellow : Color::Green;
+                };
+                auto mismatch_text = [](const StringMismatch& m) {
+                    return m.weakest < 0 ? string("-") :
+                        to_fixed_1(m.ratio * 100.0) + "% (najsłabszy PV" + to_string(m.weakest + 1) + ")";
+                };
+                StringMismatch mismatch = monitor.mismatch(from_ms, to_ms);
+                int64_t covered_ms = monitor.size() > 0 ? now_ms - max(from_ms, monitor.oldestMs()) : 0;
+                Elements rows;
+                rows.push_back(hbox(Elements{
+                    text("STRINGI PV") | bold | color(Color::Yellow),
+                    text(" | Okno: " + string(window.name) + " (dane: " + formatSpan(covered_ms) + ")") |
+                        color(Color::White),
+                    text(" | Niedopasowanie prądów: " + mismatch_text(mismatch)) | color(mismatch_color(mismatch))
+                }) | center);
+                rows.push_back(separator());
+                // Średnie prądów stringów i wspólna skala wykresów - stringi porównywane wprost
+                StringWindowStats current[StringMonitor::CHANNELS];
+                float best_mean = 0.0f, current_scale = 0.0f;
+                for (int k = 0; k < StringMonitor::CHANNELS; k++) {
+                    current[k] = monitor.stats(k, Q::CURRENT, from_ms, to_ms);
+                    if (k == StringMonitor::DEVICE_CHANNEL || k >= monitor.strings()) continue;
+                    best_mean = max(best_mean, current[k].mean);
+                    current_scale = max(current_scale, current[k].max);
+                }
+                string_columns.resize(spark_width);
+                for (int k = 0; k < StringMonitor::CHANNELS; k++) {
+                    bool device_row = k == StringMonitor::DEVICE_CHANNEL;
+                    if (!device_row && k >= monitor.strings()) continue;
+                    const StringWindowStats& st = current[k];
+                    if (device_row) rows.push_back(separator());
+                    monitor.columnMeans(k, Q::CURRENT, from_ms, to_ms, spark_width, string_columns.data());
+                    float scale = device_row ? st.max : current_scale;
+                    bool weakest = !device_row && k == mismatch.weakest;
+                    rows.push_back(hbox(Elements{
+                        text(device_row ? "Razem" : "PV" + to_string(k + 1)) | bold | size(WIDTH, EQUAL, 6),
+                        text(to_fixed_1(monitor.latest(k, Q::VOLTAGE)) + " V " +
+                            to_fixed_2(monitor.latest(k, Q::CURRENT)) + " A " +
+                            to_fixed_1(monitor.latest(k, Q::POWER)) + " W") | size(WIDTH, EQUAL, 26) |
+                            color(Color::Cyan),
+                        text(st.count == 0 ? string("śr. -") : "śr. " + to_fixed_2(st.mean) + " A") |
+                            size(WIDTH, EQUAL, 13) | color(Color::White),
+                        text(st.count == 0 ? string("") :
+                            "min/max " + to_fixed_1(st.min) + "/" + to_fixed_1(st.max)) |
+                            size(WIDTH, EQUAL, 20) | color(Color::White),
+                        text(device_row || best_mean <= 0.0f ? string("") :
+                            to_string(int(lround(st.mean / best_mean * 100.0))) + "%") | size(WIDTH, EQUAL, 7) |
+                            color(weakest ? mismatch_color(mismatch) : Color::GrayLight),
+                        text(sparkline(string_columns.data(), spark_width, scale)) |
+                            color(device_row ? Color::Yellow : weakest ? mismatch_color(mismatch) : Color::Green)
+                    }));
+                }
+                if (device_count > 1) {
+                    // Instalacja: urządzenie z największym niedopasowaniem w tym samym oknie
+                    size_t worst_device = 0;
+                    StringMismatch worst;
+                    int evaluated = 0;
+                    for (size_t d = 0; d < device_count; d++) {
+                        StringMismatch m = views[d].strings.mismatch(from_ms, to_ms);
+                        if (m.weakest < 0) continue;
+                        evaluated += m.connected;
+                        if (worst.weakest < 0 || m.ratio > worst.ratio) {
+                            worst = m;
+                            worst_device = d;
+                        }
+                    }
+                    rows.push_back(separator());
+                    rows.push_back(hbox(Elements{
+                        text("Instalacja: ") | bold,
+                        text(worst.weakest < 0 ? string("brak ocenionych stringów") :
+                            device_configs[worst_device].name + " " + mismatch_text(worst)) |
+                            color(mismatch_color(worst)),
+                        text(" | Ocenione stringi: " + to_string(evaluated)) | color(Color::White)
+                    }));
+                }
+                return vbox(move(rows)) | border;
+            });
+        }
+        // Diagnostyka ścieżki odczytu ('d') - bez pamięci podręcznej, liczniki zmieniają się stale
+        Element diagnostics_panel = text("");
+        if (show_diagnostics) {
+            LatencyHistogram::Snapshot rtt, poll, frame;
+            metrics.block_rtt.snapshot(rtt);
+            metrics.poll_duration.snapshot(poll);
+            metrics.render_frame.snapshot(frame);
+            auto count = [](const atomic<uint64_t>& c) { return to_string(c.load(memory_order_relaxed)); };
+            diagnostics_panel = vbox(Elements{
+                text("DIAGNOSTYKA") | center | bold | color(Color::Yellow),
+                separator(),
+                histogramRow("RTT zapytania", rtt),
+                histogramRow("Cykl odczytu", poll),
+                histogramRow("Klatka UI", frame),
+                text("Zapytania: " + count(metrics.requests) + " | Timeouty: " + count(metrics.timeouts) +
+                    " | Wyjątki: " + count(metrics.exceptions) + " | Zerwania: " + count(metrics.link_errors) +
+                    " | Połączenia: " + count(metrics.connects) + " (ponowne: " + count(metrics.reconnects) +
+                    ", nieudane: " + count(metrics.connect_failures) + ")") | color(Color::Cyan)
+            }) | border;
+        }
+        // Wykres z agregatów - bez kopiowania historii. Kolumny wyrównane do wielokrotności
+        // szerokości kolumny, więc upływ czasu przesuwa je o całe kolumny
+        auto chart = chart_cache.get(chart_key, [&] {
+            int64_t end_column = now_ms / column_ms + 1;
+            view.power_rollup.chartColumns(end_column * column_ms, window.ms, chart_width, chart_columns);
+            // Skala osi Y co najmniej do mocy nominalnej - stała przez większość dnia
+            double rated_power_w = device.rated_power_w;
+            power_chart.update(chart_columns, chart_height, end_column - chart_width, rated_power_w);
+            int64_t chart_resolution = view.power_rollup.tierFor(window.ms, chart_width).resolutionMs();
+            return drawPowerChart(power_chart, window, chart_resolution, rated_power_w) | border | flex;
         });
-        // Główne parametry
-        auto power_box = vbox(Elements{
-            text("MOC") | center | bold | color(Color::Yellow),
-            separator(),
-            text("Wyjściowa: " + to_fixed_1(local_data.active_power) + " W") |
-                color(local_data.active_power > 0 ? Color::Green : Color::White),
-            text("Wejściowa: " + to_fixed_1(local_data.input_power) + " W") | color(Color::Cyan),
-            text("Sprawność: " + to_fixed_1(local_data.efficiency) + "%") |
-                color(local_data.efficiency > 95 ? Color::Green : Color::Yellow)
-        }) | border | flex;
-        auto energy_box = vbox(Elements{
-            text("ENERGIA") | center | bold | color(Color::Yellow),
-            separator(),
-            text("Dzienna: " + to_fixed_1(local_data.daily_energy) + " kWh") | color(Color::Green),
-            text("Całkowita: " + to_fixed_1(local_data.total_energy) + " kWh") | color(Color::Cyan),
-            text("Częstotliwość: " + to_fixed_1(local_data.frequency) + " Hz") | color(Color::White)
-        }) | border | flex;
-        auto voltage_box = vbox(Elements{
-            text("NAPIĘCIA [V]") | center | bold | color(Color::Yellow),
-            separator(),
-            text("L1: " + to_fixed_1(local_data.phase_A_voltage)) | color(Color::Magenta),
-            text("L2: " + to_fixed_1(local_data.phase_B_voltage)) | color(Color::Magenta),
-            text("L3: " + to_fixed_1(local_data.phase_C_voltage)) | color(Color::Magenta)
-        }) | border | flex;
-        auto current_box = vbox(Elements{
-            text("PRĄDY [A]") | center | bold | color(Color::Yellow),
-            separator(),
-            text("L1: " + to_fixed_1(local_data.phase_A_current)) | color(Color::Blue),
-            text("L2: " + to_fixed_1(local_data.phase_B_current)) | color(Color::Blue),
-            text("L3: " + to_fixed_1(local_data.phase_C_current)) | color(Color::Blue)
-        }) | border | flex;
-        auto params_row = hbox(Elements{power_box, energy_box, voltage_box, current_box});
-        // Błędy
-        auto error_line = local_data.last_error.empty() ?
-            text("") :
-            text("Błąd: " + local_data.last_error) | color(Color::Red);
         // Footer
-        auto footer = text("Naciśnij 'q' aby zakończyć | 'r' aby wymusić odświeżenie | Interwał: " +
-            to_string(interval) + "s") | color(Color::Red) | center;
+        auto footer = footer_cache.get(cacheKey(device_key, chart_window), [&] {
+            return text("Naciśnij 'q' aby zakończyć | 'r' aby wymusić odświeżenie | '+'/'-' okno wykresu: " +
+                string(window.name) + (device_count > 1 ? " | Tab: następne urządzenie" : "") + " | 'd' diagnostyka" +
+                " | 's' stringi | Interwał: " + to_string(device_state.current_interval_s) + "s (" +
+                pollModeName(device_state.mode) + ")") | color(Color::Red) | center;
+        });
         // Złóż wszystko razem
-        return vbox(Elements{
+        auto frame = vbox(Elements{
             header,
-            status_line,
-            separator(),
-            device_info,
+            device_top,
+            site_panel,
+            events_panel,
+            strings_panel,
+            diagnostics_panel,
             separator(),
-            params_row,
-            separator(),
-            drawPowerChartFromHistory(local_power_history) | border | flex,
-            error_line,
+            chart,
+            device_bottom,
             separator(),
             footer
         });
+        metrics.render_frame.record(chrono::steady_clock::now() - frame_start);
+        return frame;
     });
 
     // Obsługa zdarzeń
@@ -577,25 +1066,57 @@ int main(int argc, char* argv[]) {
             return true;
         }
         if (event == Event::Character('r') || event == Event::Character('R')) {
-            // Wymuszenie natychmiastowego odczytu
+            // Wymuszenie natychmiastowego odczytu (wszystkich grup rejestrów)
+            source->pollAllNow();
+            return true;
+        }
+        if (event == Event::Character('+') || event == Event::Character('=')) {
+            chart_window = min(chart_window + 1, CHART_WINDOW_COUNT - 1);
+            return true;
+        }
+        if (event == Event::Character('-')) {
+            chart_window = max(chart_window - 1, 0);
+            return true;
+        }
+        if (event == Event::Character('d') || event == Event::Character('D')) {
+            show_diagnostics = !show_diagnostics;
+            return true;
+        }
+        if (event == Event::Character('s') || event == Event::Character('S')) {
+            show_strings = !show_strings;
+            return true;
+        }
+        if (event == Event::Tab) {
+            selected = (selected + 1) % device_count;
+            return true;
+        }
+        if (event == Event::TabReverse) {
+            selected = (selected + device_count - 1) % device_count;
             return true;
         }
         return false;
     });
 
-    // Timer do odświeżania ekranu
-    thread refresh_thread([&] {
-        while (!should_exit) {
-            this_thread::sleep_for(chrono::milliseconds(500));
-            screen.PostEvent(Event::Custom);
+    // Rzadki takt zegara - przesuwa oś czasu wykresu, gdy nie przychodzą nowe dane
+    mutex tick_mutex;
+    condition_variable tick_wake;
+    thread tick_thread([&] {
+        if (tick_s <= 0) return;
+        unique_lock<mutex> lock(tick_mutex);
+        while (!tick_wake.wait_for(lock, chrono::seconds(tick_s), [&] { return should_exit.load(); })) {
+            requestRedraw();
         }
     });
 
     screen.Loop(renderer);
 
-    should_exit = true;
-    reader_thread.join();
-    refresh_thread.join();
+    {
+        lock_guard<mutex> lock(tick_mutex);
+        should_exit = true;
+    }
+    tick_wake.notify_all();
+    tick_thread.join();
+    shutdown();
 
     return 0;
 }
\ No newline at end of file
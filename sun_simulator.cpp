@@ -0,0 +1,659 @@
+// Symulator inwerterów Huawei SUN2000 (Modbus TCP) do testów i benchmarków.
+// Serwuje rejestry z REGISTER_MAP (Huawei_SUN2000_Complete_Modbus_Map.md) na
+// localhost. Moc ma przebieg dobowy z zachmurzeniem, stany urządzenia
+// przechodzą 0xA000 -> 0x0000 -> 0x0200 (-> 0x0201) -> 0x0308 -> 0xA000.
+// Można wstrzykiwać opóźnienia, gubienie odpowiedzi i wyjątki Modbus.
+// Jeden wątek (epoll) obsługuje wiele portów i wiele urządzeń na porcie.
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "register_map.hpp"
+
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+// Obraz rejestrów jednego inwertera: adresy [REG_BASE, REG_END)
+static const uint16_t REG_BASE = 30000;
+static const uint16_t REG_END = 32410;
+
+struct SimOptions {
+    string bind_address = "127.0.0.1";
+    int base_port = 6607;
+    int ports = 1;              // Liczba portów (bramek)
+    int slaves = 1;             // Urządzeń na port (slave ID 1..N, 0 = pierwsze)
+    int rated_power = 8000;     // W
+    double speed = 1.0;         // Przyspieszenie zegara symulacji
+    double start_hour = -1.0;   // Godzina startu symulacji (-1 = bieżąca)
+    double cloudiness = 0.3;    // 0 - bezchmurnie, 1 - mocno zmienne
+    int latency_ms = 0;         // Stałe opóźnienie odpowiedzi
+    int jitter_ms = 0;          // Losowy dodatek do opóźnienia
+    double drop_pct = 0.0;      // Odpowiedzi gubione (brak odpowiedzi)
+    double exception_pct = 0.0; // Odpowiedzi z wyjątkiem 0x06 (urządzenie zajęte)
+    double fault_per_day = 0.0; // Średnia liczba awarii (0x0300) na dobę symulacji
+    bool no_frequency = false;  // 32085 = 0 (instalacja bez licznika; 37118 poza obrazem - wyjątek 0x02)
+    unsigned seed = 1;
+    string write_config;        // Plik INI dla sun_ftxui --config
+};
+
+// --- Model inwertera ---
+struct SimInverter {
+    string name;
+    uint16_t regs[REG_END - REG_BASE] = {};
+    mt19937 rng;
+    double rated = 8000;
+    double cloud = 1.0;          // Bieżący współczynnik zachmurzenia
+    uint16_t state = 0xA000;
+    double state_since_h = 0.0;  // Czas wejścia w bieżący stan (godziny symulacji)
+    double fault_until_h = -1.0;
+    double daily_kwh = 0.0;
+    double total_kwh = 0.0;
+    double month_base_kwh = 0.0;
+    double year_base_kwh = 0.0;
+    double run_minutes_today = 0.0;
+    double run_hours_total = 0.0;
+    int starts_today = 0;
+    int starts_total = 0;
+    double peak_power = 0.0, peak_temp = 0.0, peak_pv_v = 0.0, peak_pv_i = 0.0;
+    int day = -1;
+
+    void setRaw(RegId id, int64_t raw) {
+        const RegisterDesc& d = REGISTER_MAP[id];
+        uint16_t* p = regs + (d.address - REG_BASE);
+        if (d.words == 2) {
+            p[0] = uint16_t((uint64_t(raw) >> 16) & 0xFFFF);
+            p[1] = uint16_t(uint64_t(raw) & 0xFFFF);
+        } else {
+            p[0] = uint16_t(raw & 0xFFFF);
+        }
+    }
+
+    void set(RegId id, double value) { setRaw(id, llround(value * REGISTER_MAP[id].divider)); }
+
+    void setText(RegId id, const string& text) {
+        const RegisterDesc& d = REGISTER_MAP[id];
+        uint16_t* p = regs + (d.address - REG_BASE);
+        for (int w = 0; w < d.words; w++) {
+            size_t i = size_t(w) * 2;
+            uint8_t hi = i < text.size() ? uint8_t(text[i]) : 0;
+            uint8_t lo = i + 1 < text.size() ? uint8_t(text[i + 1]) : 0;
+            p[w] = uint16_t((hi << 8) | lo);
+        }
+    }
+
+    double noise(double sigma) { return normal_distribution<double>(0.0, sigma)(rng); }
+    double uniform() { return uniform_real_distribution<double>(0.0, 1.0)(rng); }
+
+    void init(int index, const SimOptions& opt) {
+        rng.seed(opt.seed * 7919u + unsigned(index));
+        rated = opt.rated_power;
+        total_kwh = 12000.0 + 500.0 * index;
+        month_base_kwh = 300.0;
+        year_base_kwh = 3500.0;
+        char sn[24];
+        snprintf(sn, sizeof(sn), "SIM%09d", index + 1);
+        setText(REG_MODEL, "SUN2000-" + to_string(int(rated / 1000)) + "KTL-M1");
+        setText(REG_SN, sn);
+        setText(REG_FIRMWARE, "V100R001C00SPC");
+        setText(REG_PRODUCTION_DATE, "2023-05-12");
+        setText(REG_EXTRA_INFO, "symulator");
+        set(REG_DEVICE_TYPE, 1);
+        set(REG_RATED_POWER, rated);
+        set(REG_MAX_POWER, rated * 1.1);
+        set(REG_PHASE_COUNT, 3);
+        set(REG_PV_STRING_COUNT, 2);
+        set(REG_NOMINAL_AC_VOLTAGE, 230);
+        set(REG_NOMINAL_FREQUENCY, 50);
+        set(REG_MAX_PV_VOLTAGE, 1100);
+        set(REG_MIN_PV_VOLTAGE, 140);
+        set(REG_MAX_PV_CURRENT, 13);
+        set(REG_NOMINAL_POWER, rated);
+        set(REG_WIFI_STATUS, 1);
+        set(REG_ETHERNET_STATUS, 0);
+        set(REG_RS485_STATUS, 1);
+        set(REG_CLOUD_STATUS, 1);
+    }
+
+    void enter(uint16_t new_state, double hour) {
+        if (new_state == 0x0200 && state != 0x0200 && state != 0x0201) {
+            starts_today++;
+            starts_total++;
+        }
+        state = new_state;
+        state_since_h = hour;
+    }
+
+    // Krok symulacji: hour - godzina doby, abs_h - godziny od startu, dt_h - krok w godzinach
+    void step(double hour, double abs_h, double dt_h, int day_index, const SimOptions& opt) {
+        if (day_index != day) {
+            if (day >= 0) {
+                month_base_kwh += daily_kwh;
+                year_base_kwh += daily_kwh;
+            }
+            day = day_index;
+            daily_kwh = 0.0;
+            run_minutes_today = 0.0;
+            starts_today = 0;
+            peak_power = peak_temp = peak_pv_v = peak_pv_i = 0.0;
+        }
+
+        // Nasłonecznienie: sinusoida 6:00-20:00, zachmurzenie jako ograniczone błądzenie losowe
+        const double sunrise = 6.0, sunset = 20.0;
+        double sun = hour > sunrise && hour < sunset ? sin(M_PI * (hour - sunrise) / (sunset - sunrise)) : 0.0;
+        cloud += noise(0.15 * opt.cloudiness * sqrt(max(dt_h, 1e-6) * 60.0));
+        cloud = min(1.0, max(1.0 - opt.cloudiness, cloud));
+        double pv_power = rated * 1.08 * sun * cloud;
+
+        // Awarie losowe
+        if (opt.fault_per_day > 0 && state != 0xA000 && uniform() < opt.fault_per_day * dt_h / 24.0) {
+            fault_until_h = abs_h + 10.0 / 60.0;
+            enter(0x0300, abs_h);
+        }
+
+        // Przejścia stanów
+        double in_state_h = abs_h - state_since_h;
+        switch (state) {
+            case 0xA000:
+                if (pv_power > 40) enter(0x0000, abs_h);
+                break;
+            case 0x0000:
+                if (pv_power < 20) enter(0xA000, abs_h);
+                else if (in_state_h >= 2.0 / 60.0) enter(0x0200, abs_h);  // 2 min inicjalizacji
+                break;
+            case 0x0200:
+            case 0x0201:
+                if (pv_power < 20) enter(0x0308, abs_h);
+                else enter(pv_power > rated ? 0x0201 : 0x0200, state_since_h);
+                break;
+            case 0x0308:
+                if (pv_power > 40) enter(0x0200, abs_h);
+                else if (in_state_h >= 5.0 / 60.0) enter(0xA000, abs_h);
+                break;
+            case 0x0300:
+                if (abs_h >= fault_until_h) enter(pv_power > 40 ? 0x0000 : 0xA000, abs_h);
+                break;
+        }
+
+        bool producing = state == 0x0200 || state == 0x0201;
+        double input = producing ? pv_power : 0.0;
+        double load = input / rated;
+        double efficiency = producing ? 98.4 - 6.0 * exp(-load * 12.0) + noise(0.05) : 0.0;
+        double active = producing ? min(rated, input * efficiency / 100.0) : 0.0;
+
+        double pv_v = sun > 0 ? 340.0 + 60.0 * sqrt(sun) + noise(1.5) : 0.0;
+        if (state == 0x0300) pv_v = 0.0;
+        double pv1_i = pv_v > 0 ? input * 0.51 / pv_v : 0.0;
+        double pv2_i = pv_v > 0 ? input * 0.49 / (pv_v - 4.0) : 0.0;
+        double grid_v[3] = {230.0 + noise(1.0), 230.5 + noise(1.0), 229.5 + noise(1.0)};
+        double temp = 22.0 + 28.0 * load + noise(0.2);
+
+        set(REG_PV1_VOLTAGE, pv_v);
+        set(REG_PV2_VOLTAGE, pv_v > 0 ? pv_v - 4.0 : 0.0);
+        set(REG_PV1_CURRENT, pv1_i);
+        set(REG_PV2_CURRENT, pv2_i);
+        set(REG_INPUT_POWER, input);
+        set(REG_PV2_POWER, input * 0.49);
+        set(REG_PHASE_A_VOLTAGE, grid_v[0]);
+        set(REG_PHASE_B_VOLTAGE, grid_v[1]);
+        set(REG_PHASE_C_VOLTAGE, grid_v[2]);
+        set(REG_PHASE_A_CURRENT, active / 3.0 / grid_v[0]);
+        set(REG_PHASE_B_CURRENT, active / 3.0 / grid_v[1]);
+        set(REG_PHASE_C_CURRENT, active / 3.0 / grid_v[2]);
+        set(REG_PHASE_A_POWER, active / 3.0);
+        set(REG_ACTIVE_POWER, active);
+        set(REG_REACTIVE_POWER, producing ? noise(15.0) : 0.0);
+        set(REG_POWER_FACTOR, producing ? 0.999 : 1.0);
+        double frequency = 50.0 + noise(0.01);
+        set(REG_GRID_FREQUENCY, opt.no_frequency ? 0.0 : frequency);
+        set(REG_EFFICIENCY, max(0.0, efficiency));
+        set(REG_INTERNAL_TEMPERATURE, temp);
+        set(REG_HEATSINK_TEMPERATURE, temp + 5.0 * load);
+        set(REG_DEVICE_STATE, state);
+        set(REG_FAULT_CODE, state == 0x0300 ? 2064 : 0);
+
+        set(REG_STATE1, producing ? 0x0006 : state == 0x0300 ? 0x0008 : 0x0001);
+        set(REG_STATE2, producing ? 0x0007 : 0x0000);
+        set(REG_STATE3, 0x0000);
+        set(REG_ALARM1, state == 0x0300 ? 0x0200 : 0);
+        set(REG_ALARM2, 0);
+        set(REG_ALARM3, 0);
+
+        set(REG_DC_BUS_VOLTAGE, producing ? 620.0 + noise(2.0) : 0.0);
+        set(REG_DC_BUS_CURRENT, producing ? input / 620.0 : 0.0);
+        set(REG_PV_POS_GROUND_VOLTAGE, pv_v / 2.0);
+        set(REG_PV_NEG_GROUND_VOLTAGE, pv_v / 2.0);
+        set(REG_INSULATION_RESISTANCE, 3000 + noise(20.0));
+        set(REG_LEAKAGE_CURRENT, producing ? 0.012 : 0.0);
+
+        double kwh = active * dt_h / 1000.0;
+        daily_kwh += kwh;
+        total_kwh += kwh;
+        set(REG_TOTAL_ENERGY, total_kwh);
+        set(REG_DAILY_ENERGY, daily_kwh);
+        set(REG_MONTHLY_ENERGY, month_base_kwh + daily_kwh);
+        set(REG_YEARLY_ENERGY, year_base_kwh + daily_kwh);
+
+        set(REG_LINE_AB_VOLTAGE, (grid_v[0] + grid_v[1]) / 2.0 * sqrt(3.0));
+        set(REG_LINE_BC_VOLTAGE, (grid_v[1] + grid_v[2]) / 2.0 * sqrt(3.0));
+        set(REG_LINE_CA_VOLTAGE, (grid_v[2] + grid_v[0]) / 2.0 * sqrt(3.0));
+        set(REG_VOLTAGE_THD, 1.2 + noise(0.05));
+        set(REG_CURRENT_THD, producing ? 2.5 + 3.0 * (1.0 - load) : 0.0);
+
+        if (producing) {
+            run_minutes_today += dt_h * 60.0;
+            run_hours_total += dt_h;
+        }
+        peak_power = max(peak_power, active);
+        peak_temp = max(peak_temp, temp);
+        peak_pv_v = max(peak_pv_v, pv_v);
+        peak_pv_i = max(peak_pv_i, max(pv1_i, pv2_i));
+        set(REG_TOTAL_RUN_HOURS, 8000 + run_hours_total);
+        set(REG_RUN_MINUTES_TODAY, run_minutes_today);
+        set(REG_STARTS_TODAY, starts_today);
+        set(REG_TOTAL_STARTS, 1500 + starts_total);
+        set(REG_PEAK_POWER_TODAY, peak_power);
+        set(REG_PEAK_TEMPERATURE_TODAY, peak_temp);
+        set(REG_PEAK_PV_VOLTAGE_TODAY, peak_pv_v);
+        set(REG_PEAK_PV_CURRENT_TODAY, peak_pv_i);
+
+        set(REG_WIFI_SIGNAL, -58 + noise(2.0));
+        set(REG_LAST_CLOUD_CONNECTION, 30);
+    }
+};
+
+// --- Serwer Modbus TCP ---
+struct PendingResponse {
+    Clock::time_point due;
+    vector<uint8_t> frame;
+};
+
+struct Connection {
+    int fd = -1;
+    int port_index = 0;
+    uint8_t rx[1024];
+    size_t rx_len = 0;
+    deque<PendingResponse> out;  // Odpowiedzi w kolejności zapytań (jak w prawdziwej bramce)
+};
+
+struct SimStats {
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t responses = 0;
+    uint64_t dropped = 0;
+    uint64_t exceptions = 0;
+    uint64_t registers = 0;
+};
+
+static volatile sig_atomic_t g_stop = 0;
+static void onSignal(int) { g_stop = 1; }
+
+class SimServer {
+private:
+    SimOptions opt;
+    vector<unique_ptr<SimInverter>> inverters;  // port * slaves + (slave - 1)
+    vector<int> listeners;
+    int epoll_fd = -1;
+    vector<unique_ptr<Connection>> connections;
+    SimStats stats;
+    mt19937 rng;
+    Clock::time_point started = Clock::now();
+    Clock::time_point last_step = Clock::now();
+    double start_hour = 0.0;
+
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = uint8_t(v >> 8);
+        p[1] = uint8_t(v & 0xFF);
+    }
+    static uint16_t get16(const uint8_t* p) { return uint16_t((p[0] << 8) | p[1]); }
+
+    bool chance(double pct) { return pct > 0 && uniform_real_distribution<double>(0, 100)(rng) < pct; }
+
+    SimInverter* inverterFor(int port_index, uint8_t unit) {
+        int slave = unit == 0 ? 1 : unit;
+        if (slave > opt.slaves) return nullptr;
+        return inverters[size_t(port_index * opt.slaves + slave - 1)].get();
+    }
+
+    void exceptionFrame(vector<uint8_t>& f, uint8_t fc, uint8_t code) {
+        f.resize(9);
+        f[7] = fc | 0x80;
+        f[8] = code;
+        stats.exceptions++;
+    }
+
+    // Buduje odpowiedź; false - odpowiedź zgubiona
+    bool handleRequest(Connection& c, const uint8_t* req, size_t size, vector<uint8_t>& f) {
+        stats.requests++;
+        if (chance(opt.drop_pct)) {
+            stats.dropped++;
+            return false;
+        }
+        f.assign(req, req + 7);
+        uint8_t fc = req[7];
+        SimInverter* inv = inverterFor(c.port_index, req[6]);
+        if (inv == nullptr) {
+            exceptionFrame(f, fc, 0x0B);  // Bramka: urządzenie docelowe nie odpowiada
+        } else if (fc != 0x03 || size < 12) {
+            exceptionFrame(f, fc, 0x01);  // Nieobsługiwana funkcja
+        } else if (chance(opt.exception_pct)) {
+            exceptionFrame(f, fc, 0x06);  // Urządzenie zajęte
+        } else {
+            uint16_t start = get16(req + 8), count = get16(req + 10);
+            if (count == 0 || count > 125) {
+                exceptionFrame(f, fc, 0x03);
+            } else if (start < REG_BASE || uint32_t(start) + count > REG_END) {
+                exceptionFrame(f, fc, 0x02);
+            } else {
+                f.resize(9 + size_t(count) * 2);
+                f[7] = 0x03;
+                f[8] = uint8_t(count * 2);
+                for (uint16_t k = 0; k < count; k++) put16(&f[9 + 2 * k], inv->regs[start - REG_BASE + k]);
+                stats.registers += count;
+            }
+        }
+        put16(&f[4], uint16_t(f.size() - 6));
+        return true;
+    }
+
+    void closeConnection(size_t i) {
+        ::close(connections[i]->fd);
+        connections.erase(connections.begin() + long(i));
+    }
+
+    void onReadable(size_t i) {
+        Connection& c = *connections[i];
+        while (true) {
+            ssize_t n = ::recv(c.fd, c.rx + c.rx_len, sizeof(c.rx) - c.rx_len, 0);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+                closeConnection(i);
+                return;
+            }
+            if (n < 0) break;
+            c.rx_len += size_t(n);
+            size_t pos = 0;
+            while (c.rx_len - pos >= 8) {
+                const uint8_t* req = c.rx + pos;
+                size_t frame = 6 + get16(req + 4);
+                if (get16(req + 2) != 0 || frame < 8 || frame > 260) {
+                    closeConnection(i);  // Strumień rozsynchronizowany
+                    return;
+                }
+                if (c.rx_len - pos < frame) break;
+                PendingResponse r;
+                if (handleRequest(c, req, frame, r.frame)) {
+                    int delay = opt.latency_ms;
+                    if (opt.jitter_ms > 0) delay += uniform_int_distribution<int>(0, opt.jitter_ms)(rng);
+                    r.due = Clock::now() + chrono::milliseconds(delay);
+                    if (!c.out.empty()) r.due = max(r.due, c.out.back().due);
+                    c.out.push_back(move(r));
+                }
+                pos += frame;
+            }
+            memmove(c.rx, c.rx + pos, c.rx_len - pos);
+            c.rx_len -= pos;
+        }
+    }
+
+    // Wysyła odpowiedzi, których termin minął; zwraca najbliższy termin
+    Clock::time_point flushDue() {
+        auto now = Clock::now();
+        auto next = Clock::time_point::max();
+        for (size_t i = 0; i < connections.size();) {
+            Connection& c = *connections[i];
+            bool closed = false;
+            while (!c.out.empty() && c.out.front().due <= now) {
+                const vector<uint8_t>& f = c.out.front().frame;
+                if (::send(c.fd, f.data(), f.size(), MSG_NOSIGNAL) < 0) {
+                    closed = true;
+                    break;
+                }
+                stats.responses++;
+                c.out.pop_front();
+            }
+            if (closed) {
+                closeConnection(i);
+                continue;
+            }
+            if (!c.out.empty()) next = min(next, c.out.front().due);
+            i++;
+        }
+        return next;
+    }
+
+    void stepModel() {
+        auto now = Clock::now();
+        double dt_h = chrono::duration<double>(now - last_step).count() * opt.speed / 3600.0;
+        last_step = now;
+        double abs_h = chrono::duration<double>(now - started).count() * opt.speed / 3600.0;
+        double sim_h = start_hour + abs_h;
+        int day_index = int(floor(sim_h / 24.0));
+        double hour = sim_h - 24.0 * day_index;
+        for (auto& inv : inverters) inv->step(hour, abs_h, dt_h, day_index, opt);
+    }
+
+public:
+    explicit SimServer(const SimOptions& o) : opt(o), rng(o.seed) {
+        if (opt.start_hour >= 0) {
+            start_hour = opt.start_hour;
+        } else {
+            time_t t = time(nullptr);
+            struct tm tm_local;
+            localtime_r(&t, &tm_local);
+            start_hour = tm_local.tm_hour + tm_local.tm_min / 60.0 + tm_local.tm_sec / 3600.0;
+        }
+        for (int p = 0; p < opt.ports; p++) {
+            for (int s = 1; s <= opt.slaves; s++) {
+                auto inv = make_unique<SimInverter>();
+                inv->name = "sim-" + to_string(opt.base_port + p) + "-" + to_string(s);
+                inv->init(int(inverters.size()), opt);
+                inv->step(start_hour, 0.0, 0.0, 0, opt);
+                inverters.push_back(move(inv));
+            }
+        }
+    }
+
+    ~SimServer() {
+        for (auto& c : connections) ::close(c->fd);
+        for (int fd : listeners) ::close(fd);
+        if (epoll_fd >= 0) ::close(epoll_fd);
+    }
+
+    bool listen() {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        for (int p = 0; p < opt.ports; p++) {
+            int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(uint16_t(opt.base_port + p));
+            inet_pton(AF_INET, opt.bind_address.c_str(), &addr.sin_addr);
+            if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 64) != 0) {
+                cerr << "Nie można nasłuchiwać na " << opt.bind_address << ":" << opt.base_port + p
+                     << ": " << strerror(errno) << endl;
+                ::close(fd);
+                return false;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = uint64_t(p);  // Gniazda nasłuchujące: indeks portu
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+            listeners.push_back(fd);
+        }
+        return true;
+    }
+
+    bool writeConfig(const string& path) const {
+        ofstream out(path);
+        if (!out) return false;
+        out << "# Wygenerowane przez sun_simulator\n";
+        for (int p = 0; p < opt.ports; p++) {
+            for (int s = 1; s <= opt.slaves; s++) {
+                out << "\n[" << inverters[size_t(p * opt.slaves + s - 1)]->name << "]\n"
+                    << "ip = " << opt.bind_address << "\n"
+                    << "port = " << opt.base_port + p << "\n"
+                    << "slave = " << s << "\n"
+                    << "interval = 10\n";
+            }
+        }
+        return bool(out);
+    }
+
+    void run() {
+        const uint64_t CONNECTION_TAG = uint64_t(1) << 32;
+        auto next_step = Clock::now();
+        auto next_report = Clock::now() + chrono::seconds(10);
+        SimStats last = stats;
+        epoll_event events[64];
+        while (!g_stop) {
+            auto now = Clock::now();
+            if (now >= next_step) {
+                stepModel();
+                next_step = now + chrono::seconds(1);
+            }
+            if (now >= next_report) {
+                printf("[sim] połączeń: %zu, zapytań/s: %.1f, rejestrów/s: %.0f, zgubionych: %llu, wyjątków: %llu\n",
+                       connections.size(), (stats.requests - last.requests) / 10.0,
+                       (stats.registers - last.registers) / 10.0,
+                       (unsigned long long)stats.dropped, (unsigned long long)stats.exceptions);
+                fflush(stdout);
+                last = stats;
+                next_report = now + chrono::seconds(10);
+            }
+            auto deadline = min(flushDue(), min(next_step, next_report));
+            int timeout = int(max<int64_t>(0, chrono::duration_cast<chrono::milliseconds>(
+                deadline - Clock::now()).count() + 1));
+            int n = epoll_wait(epoll_fd, events, 64, timeout);
+            for (int e = 0; e < n; e++) {
+                uint64_t tag = events[e].data.u64;
+                if (tag < CONNECTION_TAG) {
+                    int port_index = int(tag);
+                    int fd;
+                    while ((fd = ::accept4(listeners[size_t(port_index)], nullptr, nullptr,
+                                           SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                        int one = 1;
+                        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                        auto c = make_unique<Connection>();
+                        c->fd = fd;
+                        c->port_index = port_index;
+                        epoll_event ev{};
+                        ev.events = EPOLLIN;
+                        ev.data.u64 = CONNECTION_TAG | uint64_t(fd);
+                        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+                        connections.push_back(move(c));
+                        stats.connections++;
+                    }
+                } else {
+                    int fd = int(tag & 0xFFFFFFFF);
+                    for (size_t i = 0; i < connections.size(); i++) {
+                        if (connections[i]->fd == fd) {
+                            onReadable(i);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        printf("[sim] koniec: zapytań %llu, odpowiedzi %llu, zgubionych %llu, wyjątków %llu, połączeń %llu\n",
+               (unsigned long long)stats.requests, (unsigned long long)stats.responses,
+               (unsigned long long)stats.dropped, (unsigned long long)stats.exceptions,
+               (unsigned long long)stats.connections);
+    }
+
+    size_t inverterCount() const { return inverters.size(); }
+};
+
+int main(int argc, char* argv[]) {
+    SimOptions opt;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bind" && i + 1 < argc) {
+            opt.bind_address = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            opt.base_port = stoi(argv[++i]);
+        } else if (arg == "--ports" && i + 1 < argc) {
+            opt.ports = max(1, stoi(argv[++i]));
+        } else if (arg == "--slaves" && i + 1 < argc) {
+            opt.slaves = min(247, max(1, stoi(argv[++i])));
+        } else if (arg == "--rated" && i + 1 < argc) {
+            opt.rated_power = stoi(argv[++i]);
+        } else if (arg == "--speed" && i + 1 < argc) {
+            opt.speed = stod(argv[++i]);
+        } else if (arg == "--start-hour" && i + 1 < argc) {
+            opt.start_hour = stod(argv[++i]);
+        } else if (arg == "--cloudiness" && i + 1 < argc) {
+            opt.cloudiness = stod(argv[++i]);
+        } else if (arg == "--latency" && i + 1 < argc) {
+            opt.latency_ms = stoi(argv[++i]);
+        } else if (arg == "--jitter" && i + 1 < argc) {
+            opt.jitter_ms = stoi(argv[++i]);
+        } else if (arg == "--drop" && i + 1 < argc) {
+            opt.drop_pct = stod(argv[++i]);
+        } else if (arg == "--exceptions" && i + 1 < argc) {
+            opt.exception_pct = stod(argv[++i]);
+        } else if (arg == "--faults" && i + 1 < argc) {
+            opt.fault_per_day = stod(argv[++i]);
+        } else if (arg == "--no-frequency") {
+            opt.no_frequency = true;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            opt.seed = unsigned(stoul(argv[++i]));
+        } else if (arg == "--write-config" && i + 1 < argc) {
+            opt.write_config = argv[++i];
+        } else if (arg == "--help") {
+            cout << "Użycie: " << argv[0] << " [opcje]" << endl;
+            cout << "  --bind <adres>       Adres nasłuchu (domyślnie: 127.0.0.1)" << endl;
+            cout << "  --port <port>        Pierwszy port (domyślnie: 6607)" << endl;
+            cout << "  --ports <n>          Liczba portów/bramek (domyślnie: 1)" << endl;
+            cout << "  --slaves <n>         Inwerterów na port, slave ID 1..n (domyślnie: 1)" << endl;
+            cout << "  --rated <W>          Moc znamionowa (domyślnie: 8000)" << endl;
+            cout << "  --speed <x>          Przyspieszenie zegara symulacji (np. 720 = doba w 2 min)" << endl;
+            cout << "  --start-hour <h>     Godzina startu symulacji (domyślnie: bieżąca)" << endl;
+            cout << "  --cloudiness <0-1>   Zmienność zachmurzenia (domyślnie: 0.3)" << endl;
+            cout << "  --latency <ms>       Opóźnienie odpowiedzi" << endl;
+            cout << "  --jitter <ms>        Losowy dodatek do opóźnienia" << endl;
+            cout << "  --drop <%>           Procent zgubionych odpowiedzi" << endl;
+            cout << "  --exceptions <%>     Procent odpowiedzi z wyjątkiem 0x06" << endl;
+            cout << "  --faults <n>         Średnia liczba awarii (stan 0x0300) na dobę symulacji" << endl;
+            cout << "  --no-frequency       Częstotliwość 32085 = 0, rejestr zapasowy 37118 - wyjątek" << endl;
+            cout << "  --seed <n>           Ziarno generatora losowego" << endl;
+            cout << "  --write-config <plik> Zapisz plik INI dla sun_ftxui --config" << endl;
+            return 0;
+        }
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    SimServer server(opt);
+    if (!server.listen()) return 1;
+    if (!opt.write_config.empty() && !server.writeConfig(opt.write_config)) {
+        cerr << "Nie można zapisać " << opt.write_config << endl;
+        return 1;
+    }
+    printf("[sim] %zu inwerterów na %s:%d-%d (slave 1-%d), przyspieszenie x%.0f\n",
+           server.inverterCount(), opt.bind_address.c_str(), opt.base_port, opt.base_port + opt.ports - 1,
+           opt.slaves, opt.speed);
+    fflush(stdout);
+    server.run();
+    return 0;
+}
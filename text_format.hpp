@@ -0,0 +1,32 @@
+#pragma once
+
+// Formatowanie printf dopisywane na koniec std::string - bez bufora o stałym
+// rozmiarze, więc długa linia nie jest obcinana (i nie traci końca linii).
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+
+__attribute__((format(printf, 2, 3)))
+inline void appendFormat(std::string& out, const char* format, ...) {
+    size_t used = out.size();
+    size_t room = std::max<size_t>(out.capacity() - used, 256);
+    out.resize(used + room);
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(&out[used], room + 1, format, args);
+    va_end(args);
+    if (n < 0) {
+        out.resize(used);
+        return;
+    }
+    if (size_t(n) > room) {
+        // Za mało miejsca - drugi przebieg z dokładnym rozmiarem
+        out.resize(used + size_t(n));
+        va_start(args, format);
+        vsnprintf(&out[used], size_t(n) + 1, format, args);
+        va_end(args);
+    }
+    out.resize(used + size_t(n));
+}
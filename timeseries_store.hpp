@@ -0,0 +1,277 @@
+#pragma once
+
+// Trwały magazyn historii próbek: plik tylko do dopisywania, mapowany w pamięć,
+// ze stałym rozmiarem rekordu. Rekord i to po prostu offset
+// HEADER_SIZE + i * sizeof(TimeSeriesRecord), więc dostęp po indeksie jest O(1),
+// a wyszukanie chwili czasu to interpolacja + krótka korekta.
+//
+// Odporność na awarie: rekord jest zapisywany przed zwiększeniem licznika
+// w nagłówku i ma własne CRC32. Przy otwarciu uszkodzony ogon jest odcinany,
+// a poprawne rekordy za licznikiem (utracona aktualizacja nagłówka) odzyskiwane.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#include "inverter_sample.hpp"
+
+static_assert(REG_COUNT <= 128, "Maska ważności rekordu mieści 128 pól");
+
+// CRC32 (IEEE 802.3), tablica liczona w czasie kompilacji
+struct Crc32Table {
+    uint32_t t[256];
+    constexpr Crc32Table() : t() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+    }
+};
+
+inline uint32_t crc32(const void* data, size_t size, uint32_t crc = 0) {
+    static constexpr Crc32Table table;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table.t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+struct TimeSeriesRecord {
+    int64_t timestamp_ms;
+    uint32_t raw[REG_COUNT];
+    uint64_t valid_bits[2];
+    uint32_t flags;          // Zarezerwowane na znaczniki próbki
+    uint32_t crc;            // CRC32 wszystkich poprzednich pól
+
+    void fromSample(const InverterSample& s) {
+        memset(this, 0, sizeof(*this));
+        timestamp_ms = s.timestamp_ms;
+        memcpy(raw, s.regs.raw, sizeof(raw));
+        for (size_t i = 0; i < REG_COUNT; i++) {
+            if (s.regs.valid.test(i)) valid_bits[i / 64] |= uint64_t(1) << (i % 64);
+        }
+        crc = computeCrc();
+    }
+
+    void toSample(InverterSample& s) const {
+        s.timestamp_ms = timestamp_ms;
+        memcpy(s.regs.raw, raw, sizeof(raw));
+        for (size_t i = 0; i < REG_COUNT; i++) {
+            s.regs.valid.set(i, (valid_bits[i / 64] >> (i % 64)) & 1);
+        }
+    }
+
+    double value(RegId id) const { return regScaled(id, raw[id]); }
+    bool has(RegId id) const { return (valid_bits[id / 64] >> (id % 64)) & 1; }
+
+    uint32_t computeCrc() const { return crc32(this, offsetof(TimeSeriesRecord, crc)); }
+    bool intact() const { return timestamp_ms > 0 && crc == computeCrc(); }
+};
+
+struct TimeSeriesHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t field_count;
+    uint32_t reserved;
+    uint64_t count;          // Liczba zatwierdzonych rekordów
+};
+
+class TimeSeriesStore {
+public:
+    static constexpr size_t HEADER_SIZE = 4096;
+    static constexpr size_t GROW_RECORDS = 8640;   // Doba próbek co 10 s
+    static constexpr uint32_t VERSION = 1;
+    static constexpr int SYNC_EVERY = 30;          // msync co tyle dopisań
+
+private:
+    int fd = -1;
+    uint8_t* map = nullptr;
+    size_t map_size = 0;
+    size_t capacity = 0;
+    size_t record_count = 0;
+    int appends_since_sync = 0;
+    bool read_only = false;
+    std::string path;
+    std::string error;
+
+    TimeSeriesHeader* header() { return reinterpret_cast<TimeSeriesHeader*>(map); }
+    TimeSeriesRecord* records() { return reinterpret_cast<TimeSeriesRecord*>(map + HEADER_SIZE); }
+    const TimeSeriesRecord* records() const {
+        return reinterpret_cast<const TimeSeriesRecord*>(map + HEADER_SIZE);
+    }
+
+    bool fail(const std::string& what) {
+        error = what + ": " + strerror(errno);
+        close();
+        return false;
+    }
+
+    bool mapFile(size_t size) {
+        void* p = ::mmap(nullptr, size, read_only ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) return false;
+        map = static_cast<uint8_t*>(p);
+        map_size = size;
+        capacity = (size - HEADER_SIZE) / sizeof(TimeSeriesRecord);
+        return true;
+    }
+
+    bool grow() {
+        size_t new_size = HEADER_SIZE + (capacity + GROW_RECORDS) * sizeof(TimeSeriesRecord);
+        if (::ftruncate(fd, off_t(new_size)) != 0) return false;
+        void* p = ::mremap(map, map_size, new_size, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED) return false;
+        map = static_cast<uint8_t*>(p);
+        map_size = new_size;
+        capacity = (new_size - HEADER_SIZE) / sizeof(TimeSeriesRecord);
+        return true;
+    }
+
+    // Odcina uszkodzony ogon i odzyskuje rekordy zapisane bez aktualizacji licznika
+    void recover() {
+        size_t n = std::min<size_t>(header()->count, capacity);
+        while (n > 0 && !records()[n - 1].intact()) n--;
+        while (n < capacity && records()[n].intact() &&
+               (n == 0 || records()[n].timestamp_ms >= records()[n - 1].timestamp_ms)) {
+            n++;
+        }
+        record_count = n;
+        if (!read_only) header()->count = n;
+    }
+
+public:
+    TimeSeriesStore() = default;
+    ~TimeSeriesStore() { close(); }
+    TimeSeriesStore(const TimeSeriesStore&) = delete;
+    TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+    // readonly - tylko odczyt istniejącego pliku (odtwarzanie), bez naprawy nagłówka
+    bool open(const std::string& file_path, bool readonly = false) {
+        close();
+        path = file_path;
+        read_only = readonly;
+        fd = read_only ? ::open(path.c_str(), O_RDONLY | O_CLOEXEC) :
+                         ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) return fail("Nie można otworzyć " + path);
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) return fail("fstat " + path);
+
+        bool fresh = st.st_size == 0 && !read_only;
+        size_t size = size_t(st.st_size);
+        if (fresh) {
+            size = HEADER_SIZE + GROW_RECORDS * sizeof(TimeSeriesRecord);
+            if (::ftruncate(fd, off_t(size)) != 0) return fail("ftruncate " + path);
+        } else if (size < HEADER_SIZE) {
+            errno = EINVAL;
+            return fail("Uszkodzony nagłówek " + path);
+        }
+        if (!mapFile(size)) return fail("mmap " + path);
+
+        TimeSeriesHeader* h = header();
+        if (fresh) {
+            memset(h, 0, sizeof(*h));
+            memcpy(h->magic, "SUNTSDB", 8);
+            h->version = VERSION;
+            h->record_size = sizeof(TimeSeriesRecord);
+            h->field_count = REG_COUNT;
+            h->count = 0;
+        } else if (memcmp(h->magic, "SUNTSDB", 8) != 0 || h->version != VERSION ||
+                   h->record_size != sizeof(TimeSeriesRecord) || h->field_count != REG_COUNT) {
+            errno = EINVAL;
+            return fail("Niezgodny format pliku historii " + path);
+        }
+        recover();
+        return true;
+    }
+
+    void close() {
+        if (map != nullptr) {
+            flush();
+            ::munmap(map, map_size);
+            map = nullptr;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        map_size = capacity = record_count = 0;
+    }
+
+    bool isOpen() const { return map != nullptr; }
+    const std::string& lastError() const { return error; }
+    size_t size() const { return record_count; }
+
+    // Dopisuje próbkę: najpierw rekord, potem licznik w nagłówku
+    bool append(const InverterSample& s) {
+        if (map == nullptr || read_only) return false;
+        if (record_count > 0 && s.timestamp_ms < records()[record_count - 1].timestamp_ms) {
+            // Zegar cofnięty - plik musi być posortowany po czasie
+            error = "czas próbki wcześniejszy niż ostatni rekord";
+            return false;
+        }
+        if (record_count == capacity && !grow()) {
+            error = "Nie można powiększyć " + path + ": " + strerror(errno);
+            return false;
+        }
+        records()[record_count].fromSample(s);
+        std::atomic_thread_fence(std::memory_order_release);
+        header()->count = ++record_count;
+
+        if (++appends_since_sync >= SYNC_EVERY) flush();
+        return true;
+    }
+
+    // Zleca jądru zapis zmapowanych stron na dysk
+    void flush() {
+        if (map == nullptr || read_only) return;
+        ::msync(map, map_size, MS_ASYNC);
+        appends_since_sync = 0;
+    }
+
+    const TimeSeriesRecord& at(size_t index) const { return records()[index]; }
+
+    // Indeks pierwszego rekordu z czasem >= ts. Próbki są prawie równomierne,
+    // więc interpolacja trafia od razu albo po kilku krokach korekty.
+    size_t lowerBound(int64_t ts) const {
+        size_t n = record_count;
+        if (n == 0 || ts <= records()[0].timestamp_ms) return 0;
+        if (ts > records()[n - 1].timestamp_ms) return n;
+
+        int64_t t0 = records()[0].timestamp_ms, t1 = records()[n - 1].timestamp_ms;
+        size_t guess = t1 > t0 ? size_t(double(ts - t0) / double(t1 - t0) * double(n - 1)) : 0;
+        size_t lo = 0, hi = n;
+        // Galopowanie od przybliżenia, potem wyszukiwanie binarne w małym przedziale
+        size_t step = 1;
+        if (records()[guess].timestamp_ms < ts) {
+            lo = guess;
+            while (lo + step < n && records()[lo + step].timestamp_ms < ts) { lo += step; step *= 2; }
+            hi = std::min(n, lo + step);
+        } else {
+            hi = guess;
+            while (hi >= step && records()[hi - step].timestamp_ms >= ts) { hi -= step; step *= 2; }
+            lo = hi >= step ? hi - step : 0;
+        }
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (records()[mid].timestamp_ms < ts) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Zakres indeksów [first, last) rekordów z przedziału czasu [from_ms, to_ms)
+    std::pair<size_t, size_t> range(int64_t from_ms, int64_t to_ms) const {
+        return {lowerBound(from_ms), lowerBound(to_ms)};
+    }
+};